@@ -4,30 +4,53 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
-
-QMAKE_CXXFLAGS += -std=c++11
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = Tron
-TEMPLATE = app
-
-
-SOURCES += main.cpp\
-        mainwindow.cpp \
-    tron.cpp \
-    player.cpp \
-    tronwidget.cpp
-
-HEADERS  += mainwindow.h \
-    tron.h \
-    player.h \
-    tronwidget.h \
-    clamp.h
-
-FORMS    += mainwindow.ui
+TEMPLATE = subdirs
+
+# Headless game rules, shared by everything else
+SUBDIRS += core
+core.file = core.pro
+
+# The game itself
+SUBDIRS += gui
+gui.file = gui.pro
+gui.depends = core
+
+# Command-line simulation runner
+SUBDIRS += sim
+sim.file = sim.pro
+sim.depends = core
+
+# Benchmarks of the engine and renderer
+SUBDIRS += bench
+bench.file = bench.pro
+bench.depends = core
+
+# Headless rendering of games to frames
+SUBDIRS += exporter
+exporter.file = export.pro
+exporter.depends = core
+
+# Multi-core policy tournament
+SUBDIRS += tournament
+tournament.file = tournament.pro
+tournament.depends = core
+
+# Headless networked peer for testing netcode
+unix {
+    SUBDIRS += netplay
+    netplay.file = netplay.pro
+    netplay.depends = core
+}
+
+# Dedicated server for many concurrent matches
+linux {
+    SUBDIRS += server
+    server.file = server.pro
+    server.depends = core
+}
 
 OTHER_FILES += \
     README.md \
-    LICENSE.txt
+    LICENSE.txt \
+    common.pri \
+    core.pri
@@ -0,0 +1,59 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//! Hands out objects of `T` from a few big slabs, all freed together.
+/*!
+ * Objects are never freed one by one, only when the arena goes, so
+ * handing one out is a bump of a counter; a new slab is allocated
+ * now and then, each twice the size of the last. Suits state that
+ * only grows during a game and is reused by the next one, such as
+ * occupancy chunks.
+ */
+template <typename T>
+class Arena
+{
+public:
+    //! Start with a slab of `firstSlab` objects, once one is needed.
+    explicit Arena(std::size_t firstSlab = 4)
+        : nextSlab(std::max<std::size_t>(firstSlab, 1))
+    {
+    }
+    Arena(const Arena &other) = delete;
+    auto operator=(const Arena &other) -> Arena& = delete;
+
+    //! Get `count` new value-initialised objects, next to each other.
+    auto allocate(std::size_t count = 1) -> T*
+    {
+        if (slabs.empty() || used + count > slabSize) {
+            slabSize = std::max(nextSlab, count);
+            slabs.emplace_back(new T[slabSize]());
+            nextSlab = 2 * slabSize;
+            used = 0;
+        }
+        T *objects = slabs.back().get() + used;
+        used += count;
+        return objects;
+    }
+
+    //! Get the number of slabs allocated so far.
+    auto getSlabCount() const -> std::size_t
+    {
+        return slabs.size();
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> slabs;
+    //! Size of the last slab, and how much of it is handed out.
+    std::size_t slabSize{0};
+    std::size_t used{0};
+    //! Least size of the next slab.
+    std::size_t nextSlab;
+
+};
+
+#endif // ARENA_H
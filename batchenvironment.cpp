@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "batchenvironment.h"
+
+namespace {
+
+//! Get word `word` of row `y` of `occupied`, with tiles off the map set.
+auto blockedWord(const OccupancyGrid &occupied, int y, int word) -> std::uint64_t
+{
+    int width = occupied.getSize().width;
+    if (word < 0 || word >= (width + 63) / 64) {
+        return ~std::uint64_t{0};
+    }
+    std::uint64_t bits = occupied.getWord(y, word);
+    int onMap = width - word * 64;
+    if (onMap < 64) {
+        bits |= ~std::uint64_t{0} << onMap;
+    }
+    return bits;
+}
+
+//! Get which of the 64 tiles from (`x`, `y`) on are off the map or taken, bit `i` for `x` + `i`.
+auto blockedRow(const OccupancyGrid &occupied, int y, int x) -> std::uint64_t
+{
+    if (y < 0 || y >= occupied.getSize().height) {
+        return ~std::uint64_t{0};
+    }
+    // Round down, as `x` may be left of the map
+    int word = (x < 0 ? x - 63 : x) / 64;
+    int shift = x - word * 64;
+    std::uint64_t low = blockedWord(occupied, y, word);
+    if (shift == 0) {
+        return low;
+    }
+    return low >> shift | blockedWord(occupied, y, word + 1) << (64 - shift);
+}
+
+} // namespace
+
+BatchEnvironment::BatchEnvironment(int gameCount, Size mapSize, int playerCount, int windowRadius)
+    : playerCount(playerCount)
+    , windowRadius(windowRadius)
+    , windowSide(2 * windowRadius + 1)
+{
+    if (gameCount < 1) {
+        throw std::logic_error{"Bad game count."};
+    }
+    if (windowRadius < 0 || windowRadius > MAX_WINDOW_RADIUS) {
+        throw std::logic_error{"Bad window radius."};
+    }
+    games.reserve(gameCount);
+    for (int g = 0; g < gameCount; ++g) {
+        games.emplace_back(mapSize, playerCount);
+    }
+    std::size_t players = static_cast<std::size_t>(gameCount) * playerCount;
+    windows.resize(players * windowSide * windowSide);
+    rewards.resize(players);
+    alive.resize(players);
+    done.resize(gameCount);
+    reset();
+}
+
+/*!
+ * Games are stepped one after another, each observed while its
+ * state is still in cache.
+ */
+void BatchEnvironment::step(const std::uint8_t *actions)
+{
+    for (int g = 0; g < getGameCount(); ++g) {
+        applyActions(g, actions);
+        games[g].step();
+        done[g] = scoreGame(g);
+        if (done[g]) {
+            games[g].reset();
+            observeAlive(g);
+        }
+        observeWindows(g);
+    }
+}
+
+void BatchEnvironment::reset()
+{
+    std::fill(rewards.begin(), rewards.end(), 0.0f);
+    std::fill(done.begin(), done.end(), 0);
+    for (int g = 0; g < getGameCount(); ++g) {
+        games[g].reset();
+        observeAlive(g);
+        observeWindows(g);
+    }
+}
+
+auto BatchEnvironment::getGameCount() const -> int
+{
+    return static_cast<int>(games.size());
+}
+
+auto BatchEnvironment::getPlayerCount() const -> int
+{
+    return playerCount;
+}
+
+auto BatchEnvironment::getWindowSide() const -> int
+{
+    return windowSide;
+}
+
+auto BatchEnvironment::getGame(int game) const -> const Tron&
+{
+    return games[game];
+}
+
+auto BatchEnvironment::getWindows() const -> const std::uint8_t*
+{
+    return windows.data();
+}
+
+auto BatchEnvironment::getRewards() const -> const float*
+{
+    return rewards.data();
+}
+
+auto BatchEnvironment::getAlive() const -> const std::uint8_t*
+{
+    return alive.data();
+}
+
+auto BatchEnvironment::getDone() const -> const std::uint8_t*
+{
+    return done.data();
+}
+
+/*!
+ * Actions come from outside, so bytes that aren't a direction are
+ * taken as None rather than reaching Tron, where moving that way
+ * would throw part way through the batch.
+ */
+void BatchEnvironment::applyActions(int game, const std::uint8_t *actions)
+{
+    Tron &tron = games[game];
+    const std::uint8_t *action = actions + static_cast<std::size_t>(game) * playerCount;
+    for (int i = 0; i < playerCount; ++i) {
+        Player::Direction direction = Player::Direction::None;
+        if (action[i] <= static_cast<std::uint8_t>(Player::Direction::Right)) {
+            direction = static_cast<Player::Direction>(action[i]);
+        }
+        Player::Direction current = tron.getDirection(i);
+        if (tron.getIsPlaying(i)
+                && direction != Player::Direction::None
+                && direction != Player::opposite(current)) {
+            tron.turn(i, direction);
+        }
+    }
+}
+
+/*!
+ * Players still marked alive but out of play were taken out by
+ * this step.
+ */
+auto BatchEnvironment::scoreGame(int game) -> bool
+{
+    const Tron &tron = games[game];
+    std::size_t first = static_cast<std::size_t>(game) * playerCount;
+    for (int i = 0; i < playerCount; ++i) {
+        bool playing = tron.getIsPlaying(i);
+        rewards[first + i] = alive[first + i] && !playing ? -1.0f : 0.0f;
+        alive[first + i] = playing;
+    }
+    if (!tron.gameIsOver()) {
+        return false;
+    }
+    int winner = tron.getWinner();
+    if (winner >= 0) {
+        rewards[first + winner] += 1.0f;
+    }
+    return true;
+}
+
+void BatchEnvironment::observeAlive(int game)
+{
+    const Tron &tron = games[game];
+    std::size_t first = static_cast<std::size_t>(game) * playerCount;
+    for (int i = 0; i < playerCount; ++i) {
+        alive[first + i] = tron.getIsPlaying(i);
+    }
+}
+
+/*!
+ * Each window row is read from the occupancy a word or two at a
+ * time, then the heads in play are written over it.
+ */
+void BatchEnvironment::observeWindows(int game)
+{
+    const Tron &tron = games[game];
+    const OccupancyGrid &occupied = tron.getOccupancy();
+    std::size_t tiles = static_cast<std::size_t>(windowSide) * windowSide;
+    std::uint8_t *window = &windows[static_cast<std::size_t>(game) * playerCount * tiles];
+    for (int i = 0; i < playerCount; ++i, window += tiles) {
+        Point head = tron.getPosition(i);
+        std::uint8_t *row = window;
+        for (int y = head.y - windowRadius; y <= head.y + windowRadius; ++y, row += windowSide) {
+            std::uint64_t blocked = blockedRow(occupied, y, head.x - windowRadius);
+            for (int x = 0; x < windowSide; ++x) {
+                row[x] = static_cast<std::uint8_t>((blocked >> x) & 1u);
+            }
+        }
+        for (int other = 0; other < playerCount; ++other) {
+            Point position = tron.getPosition(other);
+            int x = position.x - head.x + windowRadius;
+            int y = position.y - head.y + windowRadius;
+            if (other != i && tron.getIsPlaying(other)
+                    && x >= 0 && x < windowSide && y >= 0 && y < windowSide) {
+                window[y * windowSide + x] = static_cast<std::uint8_t>(Tile::Head);
+            }
+        }
+    }
+}
+
+// Constants
+const int BatchEnvironment::MAX_WINDOW_RADIUS{31};
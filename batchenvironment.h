@@ -0,0 +1,108 @@
+#ifndef BATCHENVIRONMENT_H
+#define BATCHENVIRONMENT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "tron.h"
+
+//! Many games of the same size played in lockstep, for training agents.
+/*!
+ * Every player of every game is driven by an action passed to
+ * step(), and after each step every player gets an observation: a
+ * square window of the map around its head, a reward and whether
+ * it is still in play, plus one done flag per game. Observations
+ * are laid out as a struct of arrays, each packed in game order
+ * then player order, and stay where they are for the life of the
+ * environment, so they can be handed to a training framework
+ * without copying. Games that end are reset in place by the same
+ * step(), so the batch never runs dry. Nothing is allocated per
+ * step once trails have grown to their usual length.
+ */
+class BatchEnvironment
+{
+public:
+    //! What a window tile holds.
+    enum class Tile : std::uint8_t {
+        Free,
+        Blocked, //!< Off the map or covered by a trail.
+        Head //!< Head of another player in play.
+    };
+
+    //! Largest window radius; windows are at most 63 tiles wide.
+    static const int MAX_WINDOW_RADIUS;
+
+    //! Set up `gameCount` games and observe their start.
+    /*!
+     * \param windowRadius Tiles seen on each side of the head.
+     */
+    BatchEnvironment(int gameCount, Size mapSize, int playerCount, int windowRadius);
+
+    //! Move every game on by one tick.
+    /*!
+     * \param actions One per player, indexed game * players +
+     * player: a Player::Direction, or None to keep going; any
+     * other byte counts as None. Turns straight back are ignored,
+     * as with queued turns. A game only starts once every player
+     * in it has picked a direction.
+     */
+    void step(const std::uint8_t *actions);
+    //! Start every game over and observe the start.
+    void reset();
+
+    auto getGameCount() const -> int;
+    auto getPlayerCount() const -> int; //!< Get players per game.
+    //! Get the width and height of a window in tiles.
+    auto getWindowSide() const -> int;
+    //! Get a game, e.g. to look at more than the observations show.
+    auto getGame(int game) const -> const Tron&;
+
+    //! Get every player's window, a Tile per byte, row by row.
+    /*!
+     * Each is getWindowSide() squared bytes, centred on the head;
+     * the window of player `p` of game `g` starts at byte
+     * (g * players + p) * side * side.
+     */
+    auto getWindows() const -> const std::uint8_t*;
+    //! Get each player's reward for the last step.
+    /*!
+     * -1 for being taken out, +1 more for winning a game, else 0.
+     */
+    auto getRewards() const -> const float*;
+    //! Get whether each player is in play (1) or not (0).
+    auto getAlive() const -> const std::uint8_t*;
+    //! Get whether each game ended in the last step and was reset.
+    /*!
+     * Windows and liveness of a reset game are of its new start;
+     * rewards are of the tick it ended on.
+     */
+    auto getDone() const -> const std::uint8_t*;
+
+private:
+    const int playerCount;
+    const int windowRadius;
+    const int windowSide;
+    std::vector<Tron> games;
+
+    // Observations
+    std::vector<std::uint8_t> windows;
+    std::vector<float> rewards;
+    std::vector<std::uint8_t> alive;
+    std::vector<std::uint8_t> done;
+
+    //! Steer each player in play in `game` as its action says.
+    void applyActions(int game, const std::uint8_t *actions);
+    //! Fill in rewards and liveness of `game` after a step.
+    /*!
+     * \return Whether the game is over.
+     */
+    auto scoreGame(int game) -> bool;
+    //! Fill in the liveness of `game` as it is now.
+    void observeAlive(int game);
+    //! Fill in the windows of every player of `game`.
+    void observeWindows(int game);
+
+};
+
+#endif // BATCHENVIRONMENT_H
@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "bitboard.h"
+#include "controller.h"
+#include "tron.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options
+{
+    //! Shortest time one sample of a benchmark may take, in milliseconds.
+    long minTime = 20;
+    int samples = 5;
+    //! Largest map width swept up to; heights follow.
+    int maxWidth = Tron::MAX_MAP_WIDTH;
+    std::vector<int> playerCounts{2, 4, 64, 1024, Tron::MAX_PLAYER_COUNT};
+    //! Only run benchmarks whose names start with this, if given.
+    const char *filter = nullptr;
+    //! First column of every row, e.g. the commit measured.
+    std::string label = "-";
+    std::uint32_t seed = 1;
+};
+
+//! Ticks played to make an early position.
+const int EARLY_TICKS = 8;
+//! Share of the map covered by trails in a late position...
+const double LATE_COVERAGE = 0.2;
+//! ...unless it takes longer than this.
+const int LATE_MAX_TICKS = 5000;
+//! Ticks a game is stepped before starting again from its position.
+const long RESTART_INTERVAL = 256;
+//! Points looked up by the tile query benchmarks, cycled through.
+const int QUERY_POINTS = 1024;
+
+//! Results are folded in here so the work can't be optimized away.
+volatile long sink;
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  --min-time MS   shortest sample of each benchmark (default 20)\n"
+              << "  --samples N     samples of each benchmark (default 5)\n"
+              << "  --max-width W   largest map width to sweep up to (default "
+              << Tron::MAX_MAP_WIDTH << ")\n"
+              << "  --players P     player count to sweep; repeat for more\n"
+              << "  --filter NAME   only run benchmarks whose names start with NAME\n"
+              << "  --label TEXT    first column of every row, e.g. a commit\n"
+              << "  --seed S        seed of the bots that make the positions (default 1)\n"
+              << "Prints one CSV row per benchmark; times are in nanoseconds.\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    bool playersGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--label") == 0) {
+            options.label = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && value > 0) {
+            options.minTime = value;
+        } else if (std::strcmp(argv[i], "--samples") == 0 && value > 0) {
+            options.samples = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--max-width") == 0) {
+            options.maxWidth = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--players") == 0) {
+            if (!playersGiven) {
+                options.playerCounts.clear();
+                playersGiven = true;
+            }
+            options.playerCounts.push_back(static_cast<int>(value));
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+//! Get map sizes from the smallest up to `maxWidth` wide, ten times larger each time.
+auto sweptSizes(int maxWidth) -> std::vector<Size>
+{
+    std::vector<Size> sizes;
+    Size size{Tron::MIN_MAP_WIDTH, Tron::MIN_MAP_HEIGHT};
+    while (size.width <= maxWidth) {
+        sizes.push_back(size);
+        if (size.width == Tron::MAX_MAP_WIDTH) {
+            break;
+        }
+        size.width = std::min(size.width * 10, Tron::MAX_MAP_WIDTH);
+        size.height = std::min(size.height * 10, Tron::MAX_MAP_HEIGHT);
+    }
+    return sizes;
+}
+
+auto totalTrail(const Tron &game) -> long
+{
+    long tiles = 0;
+    for (int i = 0; i < game.getPlayerCount(); ++i) {
+        tiles += static_cast<long>(game.getTrail(i).size());
+    }
+    return tiles;
+}
+
+//! Play a game between cautious bots up to the given phase.
+/*!
+ * Should the game end first, it is taken back a tick, so every
+ * position still has a game to play.
+ */
+auto makePosition(Size mapSize, int playerCount, bool late, std::uint32_t seed)
+        -> std::shared_ptr<const Tron>
+{
+    Tron game{mapSize, playerCount};
+    ControllerFactory cautious = findController("cautious");
+    for (int i = 0; i < playerCount; ++i) {
+        game.setController(i, cautious(seed + static_cast<std::uint32_t>(i)));
+    }
+    game.setRewindLimit(1);
+    long area = static_cast<long>(mapSize.width) * mapSize.height;
+    if (late) {
+        while (game.getTick() < LATE_MAX_TICKS && totalTrail(game) < area * LATE_COVERAGE
+               && game.step()) {}
+    } else {
+        while (game.getTick() < EARLY_TICKS && game.step()) {}
+    }
+    if (game.gameIsOver()) {
+        game.rewind(1);
+    }
+    std::shared_ptr<Tron> position{new Tron{game}};
+    position->setRewindLimit(0);
+    return position;
+}
+
+//! Pick points all over the map of `game`.
+auto queryPoints(const Tron &game, std::uint32_t seed) -> std::vector<Point>
+{
+    std::mt19937 random{seed};
+    Size mapSize = game.getMapSize();
+    std::uniform_int_distribution<int> x{0, mapSize.width - 1};
+    std::uniform_int_distribution<int> y{0, mapSize.height - 1};
+    std::vector<Point> points;
+    for (int i = 0; i < QUERY_POINTS; ++i) {
+        points.push_back(Point{x(random), y(random)});
+    }
+    return points;
+}
+
+auto seconds(Clock::duration duration) -> double
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+/*!
+ * Players go straight on, so only the engine is timed. Copying
+ * the position again is left out, and happens every
+ * RESTART_INTERVAL ticks or when the game ends.
+ */
+auto timeSteps(const Tron &position, int threadCount, long iterations) -> double
+{
+    Clock::duration elapsed{0};
+    long done = 0;
+    while (done < iterations) {
+        Tron game{position};
+        game.setStepThreads(threadCount);
+        long batch = std::min(iterations - done, RESTART_INTERVAL);
+        long stepped = 0;
+        Clock::time_point begin = Clock::now();
+        while (stepped < batch) {
+            ++stepped;
+            if (!game.step()) {
+                break;
+            }
+        }
+        elapsed += Clock::now() - begin;
+        done += stepped;
+    }
+    sink = done;
+    return seconds(elapsed);
+}
+
+/*!
+ * What collision checks cost without the occupancy grid: looking
+ * for a tile in every trail in turn, segment by segment.
+ */
+auto timeTrailScans(const Tron &game, const std::vector<Point> &points, long iterations) -> double
+{
+    long found = 0;
+    Clock::time_point begin = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        Point point = points[i % QUERY_POINTS];
+        for (int player = 0; player < game.getPlayerCount(); ++player) {
+            if (game.getTrail(player).contains(point)) {
+                ++found;
+                break;
+            }
+        }
+    }
+    Clock::duration elapsed = Clock::now() - begin;
+    sink = found;
+    return seconds(elapsed);
+}
+
+auto kernelName(Bitboard::Kernel kernel) -> const char*
+{
+    switch (kernel) {
+    case Bitboard::Kernel::AVX2:
+        return "avx2";
+    case Bitboard::Kernel::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void addEngineBenchmarks(const std::vector<BenchPosition> &positions, std::uint32_t seed,
+                         std::vector<Benchmark> &benchmarks)
+{
+    for (const BenchPosition &position : positions) {
+        std::shared_ptr<const Tron> game = position.game;
+        std::shared_ptr<std::vector<Point>> points{new std::vector<Point>{queryPoints(*game, seed)}};
+
+        benchmarks.push_back(Benchmark{"step", &position, [game](long iterations) {
+            return timeSteps(*game, 1, iterations);
+        }});
+        int threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        if (threadCount > 1 && game->getPlayingCount() >= Tron::PARALLEL_MIN_PLAYERS) {
+            benchmarks.push_back(Benchmark{"step/parallel", &position, [game, threadCount](long iterations) {
+                return timeSteps(*game, threadCount, iterations);
+            }});
+        }
+        benchmarks.push_back(Benchmark{"isBlocked", &position, [game, points](long iterations) {
+            long blocked = 0;
+            Clock::time_point begin = Clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                blocked += game->isBlocked((*points)[i % QUERY_POINTS]);
+            }
+            Clock::duration elapsed = Clock::now() - begin;
+            sink = blocked;
+            return seconds(elapsed);
+        }});
+        benchmarks.push_back(Benchmark{"freeRun", &position, [game, points](long iterations) {
+            long run = 0;
+            Clock::time_point begin = Clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                Player::Direction direction = static_cast<Player::Direction>(1 + i % 4);
+                run += game->freeRun((*points)[i % QUERY_POINTS], direction);
+            }
+            Clock::duration elapsed = Clock::now() - begin;
+            sink = run;
+            return seconds(elapsed);
+        }});
+        // Random points on early positions are mostly open, so this times the cap
+        std::string capped = "obstacleDistance/cap"
+                + std::to_string(RayIndex::MAX_OBSTACLE_DISTANCE);
+        benchmarks.push_back(Benchmark{capped, &position, [game, points](long iterations) {
+            long distance = 0;
+            Clock::time_point begin = Clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                distance += game->obstacleDistance((*points)[i % QUERY_POINTS]);
+            }
+            Clock::duration elapsed = Clock::now() - begin;
+            sink = distance;
+            return seconds(elapsed);
+        }});
+        benchmarks.push_back(Benchmark{"trailScan", &position, [game, points](long iterations) {
+            return timeTrailScans(*game, *points, iterations);
+        }});
+        benchmarks.push_back(Benchmark{"gameIsOver", &position, [game](long iterations) {
+            long over = 0;
+            Clock::time_point begin = Clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                over += game->gameIsOver();
+            }
+            Clock::duration elapsed = Clock::now() - begin;
+            sink = over;
+            return seconds(elapsed);
+        }});
+
+        // Every flood fill kernel this CPU can run, fastest last
+        for (Bitboard::Kernel kernel : {Bitboard::Kernel::Scalar, Bitboard::Kernel::SSE2,
+                                        Bitboard::Kernel::AVX2}) {
+            if (!Bitboard::supports(kernel)) {
+                continue;
+            }
+            std::string name = std::string{"reachableArea/"} + kernelName(kernel);
+            benchmarks.push_back(Benchmark{name, &position, [game, kernel](long iterations) {
+                Bitboard::setKernel(kernel);
+                long area = 0;
+                Clock::time_point begin = Clock::now();
+                for (long i = 0; i < iterations; ++i) {
+                    area += game->reachableArea(game->getPosition(0));
+                }
+                Clock::duration elapsed = Clock::now() - begin;
+                sink = area;
+                return seconds(elapsed);
+            }});
+        }
+    }
+}
+
+//! Median, fastest and slowest time per operation over several samples.
+struct Measurement
+{
+    long iterations;
+    double median;
+    double fastest;
+    double slowest;
+};
+
+/*!
+ * The iteration count grows until one run takes at least the
+ * minimum time, which also warms caches and lazily built state;
+ * then every sample runs that many times.
+ */
+auto measure(const Benchmark &benchmark, const Options &options) -> Measurement
+{
+    double minTime = options.minTime / 1000.0;
+    long iterations = 1;
+    double taken = benchmark.run(iterations);
+    while (taken < minTime) {
+        // Aim a little past the minimum so the next run gets there
+        double scale = taken > 0 ? std::min(minTime * 1.2 / taken, 100.0) : 100.0;
+        iterations = std::max(iterations + 1, static_cast<long>(iterations * scale));
+        taken = benchmark.run(iterations);
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < options.samples; ++i) {
+        samples.push_back(benchmark.run(iterations) * 1e9 / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return Measurement{iterations, samples[samples.size() / 2], samples.front(), samples.back()};
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::vector<BenchPosition> positions;
+        for (Size mapSize : sweptSizes(options.maxWidth)) {
+            for (int playerCount : options.playerCounts) {
+                if (static_cast<long>(playerCount) * 4 > static_cast<long>(mapSize.width) * mapSize.height) {
+                    continue;
+                }
+                for (bool late : {false, true}) {
+                    positions.push_back(BenchPosition{late ? "late" : "early",
+                                                      makePosition(mapSize, playerCount, late, options.seed)});
+                }
+            }
+        }
+
+        std::vector<Benchmark> benchmarks;
+        addEngineBenchmarks(positions, options.seed, benchmarks);
+        addPaintBenchmarks(positions, benchmarks);
+
+        Bitboard::Kernel defaultKernel = Bitboard::getKernel();
+        std::cout << "label,benchmark,width,height,players,phase,tick,iterations,"
+                     "ns_per_op,min_ns,max_ns" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+        for (const Benchmark &benchmark : benchmarks) {
+            if (options.filter
+                    && benchmark.name.compare(0, std::strlen(options.filter), options.filter) != 0) {
+                continue;
+            }
+            Measurement result = measure(benchmark, options);
+            Bitboard::setKernel(defaultKernel);
+            const Tron &game = *benchmark.position->game;
+            std::cout << options.label << "," << benchmark.name << ","
+                      << game.getMapSize().width << "," << game.getMapSize().height << ","
+                      << game.getPlayerCount() << "," << benchmark.position->phase << ","
+                      << game.getTick() << "," << result.iterations << ","
+                      << result.median << "," << result.fastest << "," << result.slowest
+                      << std::endl;
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
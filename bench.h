@@ -0,0 +1,39 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tron.h"
+
+//! A game position benchmarks are timed against.
+struct BenchPosition
+{
+    //! "early" for a game a few ticks old, "late" for long trails.
+    const char *phase;
+    //! The position itself; copies of it have no controllers.
+    std::shared_ptr<const Tron> game;
+};
+
+//! One operation to time against one position.
+struct Benchmark
+{
+    std::string name;
+    const BenchPosition *position;
+    //! Do the operation `iterations` times.
+    /*!
+     * \return Seconds taken, leaving out any setup between runs.
+     */
+    std::function<auto (long iterations) -> double> run;
+};
+
+//! Add the benchmarks that paint into an offscreen image.
+/*!
+ * Defined with the widget, so only built where Qt is.
+ */
+void addPaintBenchmarks(const std::vector<BenchPosition> &positions,
+                        std::vector<Benchmark> &benchmarks);
+
+#endif // BENCH_H
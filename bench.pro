@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Times engine and renderer hot paths; prints CSV.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += console thread
+CONFIG -= app_bundle
+
+TARGET = tron-bench
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += bench.cpp \
+    benchpaint.cpp \
+    tronwidget.cpp \
+    boardpainter.cpp
+
+HEADERS  += bench.h \
+    tronwidget.h \
+    boardpainter.h \
+    clamp.h
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <memory>
+
+#include <QApplication>
+#include <QImage>
+
+#include "bench.h"
+#include "tronwidget.h"
+
+namespace {
+
+//! Size of the window painted, a common laptop screen.
+const QSize WINDOW_SIZE{1280, 720};
+
+/*!
+ * Widgets need an application; without a display the offscreen
+ * platform stands in, so the benchmarks run on build machines.
+ */
+void ensureApplication()
+{
+    static int argc = 1;
+    static char name[] = "tron-bench";
+    static char *argv[] = {name, nullptr};
+    if (!QApplication::instance()) {
+        if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        new QApplication{argc, argv};
+    }
+}
+
+//! One widget shared by every paint benchmark, and what it shows.
+struct Canvas
+{
+    TronWidget widget;
+    QImage image{WINDOW_SIZE, QImage::Format_ARGB32_Premultiplied};
+    const Tron *shown{nullptr};
+};
+
+} // namespace
+
+/*!
+ * Times paintEvent() through QWidget::render(); maps too big to fit
+ * the window go through the viewport rather than the cached board.
+ */
+void addPaintBenchmarks(const std::vector<BenchPosition> &positions,
+                        std::vector<Benchmark> &benchmarks)
+{
+    ensureApplication();
+    std::shared_ptr<Canvas> canvas{new Canvas};
+    canvas->widget.resize(WINDOW_SIZE);
+    for (const BenchPosition &position : positions) {
+        std::shared_ptr<const Tron> game = position.game;
+        benchmarks.push_back(Benchmark{"paint", &position, [canvas, game](long iterations) {
+            if (canvas->shown != game.get()) {
+                canvas->widget.showPosition(*game);
+                canvas->shown = game.get();
+            }
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            for (long i = 0; i < iterations; ++i) {
+                canvas->widget.render(&canvas->image);
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }});
+    }
+}
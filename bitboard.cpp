@@ -0,0 +1,488 @@
+#include <algorithm>
+
+#include "bitboard.h"
+#include "bits.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRON_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Kernels work on a board's words as one flat array, padding and
+// all: a word's horizontal neighbours are the words either side and
+// its vertical ones are `stride` away. Padding is zero in every mask,
+// so nothing leaks between rows, and rows need not be a multiple of
+// the vector width to keep every lane busy.
+
+//! Flood `count` words in place, from the last if `backward`.
+/*!
+ * \return The bits that changed.
+ */
+typedef auto (*FillWords)(std::uint64_t *words, const std::uint64_t *mask,
+                          std::ptrdiff_t stride, std::ptrdiff_t count,
+                          bool backward) -> std::uint64_t;
+//! Write `count` words of `from` grown by one tile, within `mask`, to `out`.
+typedef void (*DilateWords)(const std::uint64_t *from, const std::uint64_t *mask,
+                            std::uint64_t *out, std::ptrdiff_t stride,
+                            std::ptrdiff_t count);
+
+struct Kernels
+{
+    Bitboard::Kernel kernel;
+    FillWords fill;
+    DilateWords dilate;
+};
+
+//! Spread `seeds` along every run of `mask` holding one, within a word.
+/*!
+ * A Kogge-Stone fill: each step lets the seeds jump twice as far
+ * as the last, over tiles the previous steps proved clear.
+ */
+inline auto fillRuns(std::uint64_t seeds, std::uint64_t mask) -> std::uint64_t
+{
+    std::uint64_t up = seeds;
+    std::uint64_t upClear = mask;
+    std::uint64_t down = seeds;
+    std::uint64_t downClear = mask;
+    for (int shift = 1; shift < 64; shift *= 2) {
+        up |= upClear & (up << shift);
+        upClear &= upClear << shift;
+        down |= downClear & (down >> shift);
+        downClear &= downClear >> shift;
+    }
+    return up | down;
+}
+
+inline auto fillWord(std::uint64_t *word, std::uint64_t mask,
+                     std::ptrdiff_t stride) -> std::uint64_t
+{
+    std::uint64_t seeds = word[0] | word[-stride] | word[stride]
+            | word[-1] >> 63 | word[1] << 63;
+    std::uint64_t filled = fillRuns(seeds & mask, mask);
+    std::uint64_t changed = filled ^ word[0];
+    word[0] = filled;
+    return changed;
+}
+
+auto fillScalar(std::uint64_t *words, const std::uint64_t *mask,
+                std::ptrdiff_t stride, std::ptrdiff_t count,
+                bool backward) -> std::uint64_t
+{
+    std::uint64_t changed = 0;
+    if (backward) {
+        for (std::ptrdiff_t i = count - 1; i >= 0; --i) {
+            changed |= fillWord(words + i, mask[i], stride);
+        }
+    } else {
+        for (std::ptrdiff_t i = 0; i < count; ++i) {
+            changed |= fillWord(words + i, mask[i], stride);
+        }
+    }
+    return changed;
+}
+
+void dilateScalar(const std::uint64_t *from, const std::uint64_t *mask,
+                  std::uint64_t *out, std::ptrdiff_t stride, std::ptrdiff_t count)
+{
+    for (std::ptrdiff_t i = 0; i < count; ++i) {
+        std::uint64_t grown = from[i] | from[i] << 1 | from[i] >> 1
+                | from[i - 1] >> 63 | from[i + 1] << 63
+                | from[i - stride] | from[i + stride];
+        out[i] = grown & mask[i];
+    }
+}
+
+#ifdef TRON_X86_KERNELS
+
+// The vector kernels are the scalar ones a few words at a time.
+// Rows are padded to a whole number of blocks, so a block never
+// straddles two rows and there are no words left over.
+
+__attribute__((target("sse2")))
+inline auto loadSSE2(const std::uint64_t *word) -> __m128i
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(word));
+}
+
+//! Flood one block given its neighbours; `left` and `right` hold
+//! each lane's horizontal neighbours.
+__attribute__((target("sse2")))
+inline auto fillBlockSSE2(__m128i current, __m128i left, __m128i right,
+                          __m128i above, __m128i below, __m128i clear) -> __m128i
+{
+    __m128i seeds = _mm_or_si128(
+                _mm_or_si128(current, above),
+                _mm_or_si128(below,
+                             _mm_or_si128(_mm_srli_epi64(left, 63),
+                                          _mm_slli_epi64(right, 63))));
+    seeds = _mm_and_si128(seeds, clear);
+    __m128i up = seeds;
+    __m128i upClear = clear;
+    __m128i down = seeds;
+    __m128i downClear = clear;
+    for (int shift = 1; shift < 64; shift *= 2) {
+        up = _mm_or_si128(up, _mm_and_si128(upClear, _mm_slli_epi64(up, shift)));
+        upClear = _mm_and_si128(upClear, _mm_slli_epi64(upClear, shift));
+        down = _mm_or_si128(down, _mm_and_si128(downClear, _mm_srli_epi64(down, shift)));
+        downClear = _mm_and_si128(downClear, _mm_srli_epi64(downClear, shift));
+    }
+    return _mm_or_si128(up, down);
+}
+
+__attribute__((target("sse2")))
+inline auto sameSSE2(__m128i a, __m128i b) -> bool
+{
+    // No 64-bit compare in SSE2, but equal halves make equal words
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) == 0xffff;
+}
+
+/*!
+ * The neighbour on the side already swept comes from the block
+ * just filled, still in a register, rather than memory: loading it
+ * back would straddle that block's store and stall. Each block is
+ * refilled until stable, so a fill crosses it in one sweep.
+ */
+__attribute__((target("sse2")))
+auto fillSSE2(std::uint64_t *words, const std::uint64_t *mask,
+              std::ptrdiff_t stride, std::ptrdiff_t count,
+              bool backward) -> std::uint64_t
+{
+    const std::ptrdiff_t WIDTH = 2;
+    __m128i changed = _mm_setzero_si128();
+    __m128i carry = _mm_setzero_si128();
+    for (std::ptrdiff_t n = 0; n < count; n += WIDTH) {
+        std::ptrdiff_t i = backward ? count - WIDTH - n : n;
+        __m128i current = loadSSE2(words + i);
+        // The neighbouring block not yet swept
+        __m128i ahead = loadSSE2(backward ? words + i - WIDTH : words + i + WIDTH);
+        __m128i above = loadSSE2(words + i - stride);
+        __m128i below = loadSSE2(words + i + stride);
+        __m128i clear = loadSSE2(mask + i);
+        __m128i leftBlock = backward ? ahead : carry;
+        __m128i rightBlock = backward ? carry : ahead;
+        __m128i filled = current;
+        for (int pass = 0; pass < WIDTH; ++pass) {
+            // [leftBlock1, filled0] and [filled1, rightBlock0]
+            __m128i left = _mm_or_si128(_mm_slli_si128(filled, 8), _mm_srli_si128(leftBlock, 8));
+            __m128i right = _mm_or_si128(_mm_srli_si128(filled, 8), _mm_slli_si128(rightBlock, 8));
+            __m128i next = fillBlockSSE2(filled, left, right, above, below, clear);
+            if (sameSSE2(next, filled)) {
+                break;
+            }
+            filled = next;
+        }
+        carry = filled;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i), filled);
+        changed = _mm_or_si128(changed, _mm_xor_si128(filled, current));
+    }
+    std::uint64_t lanes[WIDTH];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), changed);
+    return lanes[0] | lanes[1];
+}
+
+__attribute__((target("sse2")))
+void dilateSSE2(const std::uint64_t *from, const std::uint64_t *mask,
+                std::uint64_t *out, std::ptrdiff_t stride, std::ptrdiff_t count)
+{
+    const std::ptrdiff_t WIDTH = 2;
+    std::ptrdiff_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        __m128i current = loadSSE2(from + i);
+        __m128i grown = _mm_or_si128(
+                    _mm_or_si128(_mm_or_si128(current, _mm_slli_epi64(current, 1)),
+                                 _mm_or_si128(_mm_srli_epi64(current, 1),
+                                              _mm_srli_epi64(loadSSE2(from + i - 1), 63))),
+                    _mm_or_si128(_mm_or_si128(_mm_slli_epi64(loadSSE2(from + i + 1), 63),
+                                              loadSSE2(from + i - stride)),
+                                 loadSSE2(from + i + stride)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_and_si128(grown, loadSSE2(mask + i)));
+    }
+    dilateScalar(from + i, mask + i, out + i, stride, count - i);
+}
+
+__attribute__((target("avx2")))
+inline auto loadAVX2(const std::uint64_t *word) -> __m256i
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(word));
+}
+
+__attribute__((target("avx2")))
+inline auto sameAVX2(__m256i a, __m256i b) -> bool
+{
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b)) == -1;
+}
+
+__attribute__((target("avx2")))
+inline auto fillBlockAVX2(__m256i current, __m256i left, __m256i right,
+                          __m256i above, __m256i below, __m256i clear) -> __m256i
+{
+    __m256i seeds = _mm256_or_si256(
+                _mm256_or_si256(current, above),
+                _mm256_or_si256(below,
+                                _mm256_or_si256(_mm256_srli_epi64(left, 63),
+                                                _mm256_slli_epi64(right, 63))));
+    seeds = _mm256_and_si256(seeds, clear);
+    __m256i up = seeds;
+    __m256i upClear = clear;
+    __m256i down = seeds;
+    __m256i downClear = clear;
+    for (int shift = 1; shift < 64; shift *= 2) {
+        up = _mm256_or_si256(up, _mm256_and_si256(upClear, _mm256_slli_epi64(up, shift)));
+        upClear = _mm256_and_si256(upClear, _mm256_slli_epi64(upClear, shift));
+        down = _mm256_or_si256(down, _mm256_and_si256(downClear, _mm256_srli_epi64(down, shift)));
+        downClear = _mm256_and_si256(downClear, _mm256_srli_epi64(downClear, shift));
+    }
+    return _mm256_or_si256(up, down);
+}
+
+__attribute__((target("avx2")))
+auto fillAVX2(std::uint64_t *words, const std::uint64_t *mask,
+              std::ptrdiff_t stride, std::ptrdiff_t count,
+              bool backward) -> std::uint64_t
+{
+    const std::ptrdiff_t WIDTH = 4;
+    __m256i changed = _mm256_setzero_si256();
+    __m256i carry = _mm256_setzero_si256();
+    for (std::ptrdiff_t n = 0; n < count; n += WIDTH) {
+        std::ptrdiff_t i = backward ? count - WIDTH - n : n;
+        __m256i current = loadAVX2(words + i);
+        __m256i ahead = loadAVX2(backward ? words + i - WIDTH : words + i + WIDTH);
+        __m256i above = loadAVX2(words + i - stride);
+        __m256i below = loadAVX2(words + i + stride);
+        __m256i clear = loadAVX2(mask + i);
+        __m256i leftBlock = backward ? ahead : carry;
+        __m256i rightBlock = backward ? carry : ahead;
+        __m256i filled = current;
+        for (int pass = 0; pass < WIDTH; ++pass) {
+            // [leftBlock3, filled0, filled1, filled2] and [filled1, filled2, filled3, rightBlock0]
+            __m256i left = _mm256_blend_epi32(
+                        _mm256_permute4x64_epi64(filled, _MM_SHUFFLE(2, 1, 0, 3)),
+                        _mm256_permute4x64_epi64(leftBlock, _MM_SHUFFLE(3, 3, 3, 3)), 0x03);
+            __m256i right = _mm256_blend_epi32(
+                        _mm256_permute4x64_epi64(filled, _MM_SHUFFLE(0, 3, 2, 1)),
+                        _mm256_permute4x64_epi64(rightBlock, _MM_SHUFFLE(0, 0, 0, 0)), 0xc0);
+            __m256i next = fillBlockAVX2(filled, left, right, above, below, clear);
+            if (sameAVX2(next, filled)) {
+                break;
+            }
+            filled = next;
+        }
+        carry = filled;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(words + i), filled);
+        changed = _mm256_or_si256(changed, _mm256_xor_si256(filled, current));
+    }
+    std::uint64_t lanes[WIDTH];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), changed);
+    return lanes[0] | lanes[1] | lanes[2] | lanes[3];
+}
+
+__attribute__((target("avx2")))
+void dilateAVX2(const std::uint64_t *from, const std::uint64_t *mask,
+                std::uint64_t *out, std::ptrdiff_t stride, std::ptrdiff_t count)
+{
+    const std::ptrdiff_t WIDTH = 4;
+    std::ptrdiff_t i = 0;
+    for (; i + WIDTH <= count; i += WIDTH) {
+        __m256i current = loadAVX2(from + i);
+        __m256i grown = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_or_si256(current, _mm256_slli_epi64(current, 1)),
+                                    _mm256_or_si256(_mm256_srli_epi64(current, 1),
+                                                    _mm256_srli_epi64(loadAVX2(from + i - 1), 63))),
+                    _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi64(loadAVX2(from + i + 1), 63),
+                                                    loadAVX2(from + i - stride)),
+                                    loadAVX2(from + i + stride)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_and_si256(grown, loadAVX2(mask + i)));
+    }
+    dilateScalar(from + i, mask + i, out + i, stride, count - i);
+}
+
+#endif // TRON_X86_KERNELS
+
+auto kernelsFor(Bitboard::Kernel kernel) -> Kernels
+{
+    switch (kernel) {
+#ifdef TRON_X86_KERNELS
+    case Bitboard::Kernel::AVX2:
+        return Kernels{kernel, fillAVX2, dilateAVX2};
+    case Bitboard::Kernel::SSE2:
+        return Kernels{kernel, fillSSE2, dilateSSE2};
+#endif
+    default:
+        return Kernels{Bitboard::Kernel::Scalar, fillScalar, dilateScalar};
+    }
+}
+
+//! Get the kernels in use, picking the fastest supported at first call.
+auto activeKernels() -> Kernels&
+{
+    static Kernels kernels = kernelsFor(
+                Bitboard::supports(Bitboard::Kernel::AVX2) ? Bitboard::Kernel::AVX2
+                : Bitboard::supports(Bitboard::Kernel::SSE2) ? Bitboard::Kernel::SSE2
+                : Bitboard::Kernel::Scalar);
+    return kernels;
+}
+
+} // namespace
+
+Bitboard::Bitboard(Size size)
+    : size(size)
+    , wordsPerRow((size.width + 63) / 64)
+    // A padding word either side, rounded up to whole AVX2 blocks
+    , stride((wordsPerRow + 2 + 3) / 4 * 4)
+    , lastWordMask(size.width % 64 ? (std::uint64_t{1} << (size.width % 64)) - 1 : ~std::uint64_t{0})
+    , words(static_cast<std::size_t>(stride) * (size.height + 2), 0)
+{}
+
+auto Bitboard::row(int y) -> std::uint64_t*
+{
+    return words.data() + static_cast<std::size_t>(y + 1) * stride + 1;
+}
+
+auto Bitboard::row(int y) const -> const std::uint64_t*
+{
+    return words.data() + static_cast<std::size_t>(y + 1) * stride + 1;
+}
+
+auto Bitboard::test(Point position) const -> bool
+{
+    return (row(position.y)[position.x / 64] >> (position.x % 64)) & 1u;
+}
+
+void Bitboard::set(Point position)
+{
+    row(position.y)[position.x / 64] |= std::uint64_t{1} << (position.x % 64);
+}
+
+void Bitboard::reset(Point position)
+{
+    row(position.y)[position.x / 64] &= ~(std::uint64_t{1} << (position.x % 64));
+}
+
+void Bitboard::clear()
+{
+    std::fill(words.begin(), words.end(), 0);
+}
+
+auto Bitboard::getWord(int y, int word) const -> std::uint64_t
+{
+    return row(y)[word];
+}
+
+void Bitboard::setWord(int y, int word, std::uint64_t bits)
+{
+    row(y)[word] = word == wordsPerRow - 1 ? bits & lastWordMask : bits;
+}
+
+auto Bitboard::count() const -> int
+{
+    // Padding is always zero, so it can be counted along with the rest
+    int total = 0;
+    for (std::uint64_t word : words) {
+        total += popCount(word);
+    }
+    return total;
+}
+
+auto Bitboard::isEmpty() const -> bool
+{
+    return std::all_of(words.begin(), words.end(),
+                       [](std::uint64_t word) { return word == 0; });
+}
+
+auto Bitboard::operator|=(const Bitboard &other) -> Bitboard&
+{
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+auto Bitboard::operator&=(const Bitboard &other) -> Bitboard&
+{
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] &= other.words[i];
+    }
+    return *this;
+}
+
+void Bitboard::andNot(const Bitboard &other)
+{
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] &= ~other.words[i];
+    }
+}
+
+void Bitboard::orIntersection(const Bitboard &a, const Bitboard &b)
+{
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] |= a.words[i] & b.words[i];
+    }
+}
+
+/*!
+ * Sweeps down then up the board until a sweep changes nothing.
+ * Each word takes in whatever the words just swept have reached,
+ * so one sweep usually carries a fill the length of a corridor; it
+ * is mostly bends that cost extra sweeps.
+ */
+void Bitboard::flood(const Bitboard &mask)
+{
+    FillWords fill = activeKernels().fill;
+    // Every row, with the padding between them
+    std::uint64_t *first = row(0) - 1;
+    const std::uint64_t *maskFirst = mask.row(0) - 1;
+    std::ptrdiff_t count = static_cast<std::ptrdiff_t>(size.height) * stride;
+    for (bool backward = false; fill(first, maskFirst, stride, count, backward); backward = !backward) {}
+}
+
+void Bitboard::dilate(const Bitboard &from, const Bitboard &mask)
+{
+    std::ptrdiff_t count = static_cast<std::ptrdiff_t>(size.height) * stride;
+    activeKernels().dilate(from.row(0) - 1, mask.row(0) - 1, row(0) - 1, stride, count);
+}
+
+auto Bitboard::getSize() const -> Size
+{
+    return size;
+}
+
+auto Bitboard::getWordsPerRow() const -> int
+{
+    return wordsPerRow;
+}
+
+auto Bitboard::getKernel() -> Kernel
+{
+    return activeKernels().kernel;
+}
+
+auto Bitboard::supports(Kernel kernel) -> bool
+{
+    switch (kernel) {
+    case Kernel::Scalar:
+        return true;
+#ifdef TRON_X86_KERNELS
+    case Kernel::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case Kernel::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+auto Bitboard::setKernel(Kernel kernel) -> bool
+{
+    if (!supports(kernel)) {
+        return false;
+    }
+    activeKernels() = kernelsFor(kernel);
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+//! One bit per map tile, rows packed into 64-bit words.
+/*!
+ * Whole-map questions such as "what can be reached from here?"
+ * become word-wide bit operations: a flood fill grows every tile
+ * of a row at once instead of visiting them one by one.
+ *
+ * Rows are padded with zero words at each end, and the board with
+ * a zero row above and below, so the kernels can read every
+ * neighbour without bounds checks. The kernels come in scalar,
+ * SSE2 and AVX2 versions; the fastest the CPU supports is picked
+ * the first time one is needed.
+ */
+class Bitboard
+{
+public:
+    //! Implementations of the row kernels.
+    enum class Kernel {Scalar, SSE2, AVX2};
+
+    explicit Bitboard(Size size);
+
+    auto test(Point position) const -> bool;
+    void set(Point position);
+    void reset(Point position);
+    //! Clear every bit.
+    void clear();
+    //! Get word `word` of row `y`; bit `i` is tile 64 * `word` + `i`.
+    auto getWord(int y, int word) const -> std::uint64_t;
+    //! Set word `word` of row `y`, dropping bits beyond the width.
+    void setWord(int y, int word, std::uint64_t bits);
+
+    //! Count set bits.
+    auto count() const -> int;
+    //! Check if no bit is set.
+    auto isEmpty() const -> bool;
+
+    //! Set every bit of `other` too.
+    auto operator|=(const Bitboard &other) -> Bitboard&;
+    //! Keep only bits also set in `other`.
+    auto operator&=(const Bitboard &other) -> Bitboard&;
+    //! Clear every bit set in `other`.
+    void andNot(const Bitboard &other);
+    //! Set every bit set in both `a` and `b`.
+    void orIntersection(const Bitboard &a, const Bitboard &b);
+
+    //! Grow into every tile of `mask` connected to a set tile.
+    /*!
+     * Set tiles should lie within `mask`. Runs of a row fill in
+     * one go, so open areas take only a few passes whatever their
+     * size.
+     */
+    void flood(const Bitboard &mask);
+    //! Become `from` grown by one tile in each direction, within `mask`.
+    /*!
+     * One breadth-first step; `from` may not be this board.
+     */
+    void dilate(const Bitboard &from, const Bitboard &mask);
+
+    auto getSize() const -> Size; //!< Get size in tiles.
+    //! Get the number of words holding each row.
+    auto getWordsPerRow() const -> int;
+
+    //! Get the kernels in use.
+    static auto getKernel() -> Kernel;
+    //! Check if this CPU can run `kernel`.
+    static auto supports(Kernel kernel) -> bool;
+    //! Use `kernel` from now on, if supported; for benchmarks.
+    /*!
+     * Not thread-safe; call before any board is filled.
+     * \return Whether `kernel` is now in use.
+     */
+    static auto setKernel(Kernel kernel) -> bool;
+
+private:
+    // Not const, so boards can be assigned and swapped
+    Size size;
+    int wordsPerRow;
+    //! Words from one row to the next, padding included.
+    int stride;
+    //! Bits of the last word of a row that lie on the map.
+    std::uint64_t lastWordMask;
+    std::vector<std::uint64_t> words;
+
+    //! Get the first word of row `y`; rows -1 and `height` are padding.
+    auto row(int y) -> std::uint64_t*;
+    auto row(int y) const -> const std::uint64_t*;
+
+};
+
+#endif // BITBOARD_H
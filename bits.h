@@ -0,0 +1,49 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <cstdint>
+
+//! Get the index of the lowest set bit of `word`, which must be non-zero.
+inline auto lowestBit(std::uint64_t word) -> int
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1u)) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+//! Get the index of the highest set bit of `word`, which must be non-zero.
+inline auto highestBit(std::uint64_t word) -> int
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(word);
+#else
+    int bit = 0;
+    while (word >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+//! Count the set bits of `word`.
+inline auto popCount(std::uint64_t word) -> int
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+#endif // BITS_H
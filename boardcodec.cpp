@@ -0,0 +1,152 @@
+#include <stdexcept>
+
+#include "boardcodec.h"
+#include "tron.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+
+//! Board flag of a player still in play.
+const std::uint8_t PLAYING_FLAG = 4;
+//! Board flag of a player that hasn't picked a direction yet.
+const std::uint8_t WAITING_FLAG = 8;
+
+//! Get the direction leading from `from` to the next tile `to`.
+auto directionBetween(Point from, Point to) -> Direction
+{
+    if (to.x != from.x) {
+        return to.x < from.x ? Direction::Left : Direction::Right;
+    }
+    return to.y < from.y ? Direction::Up : Direction::Down;
+}
+
+} // namespace
+
+auto packDirection(Player::Direction direction) -> std::uint8_t
+{
+    return static_cast<std::uint8_t>(static_cast<int>(direction) - 1);
+}
+
+auto unpackDirection(unsigned bits) -> Player::Direction
+{
+    return static_cast<Direction>((bits & 3) + 1);
+}
+
+void putVarint(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+auto getVarint(const std::uint8_t *data, std::size_t size,
+               std::size_t &offset) -> std::uint32_t
+{
+    std::uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= size) {
+            break;
+        }
+        std::uint8_t byte = data[offset++];
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::logic_error{"Corrupt game data."};
+}
+
+/*!
+ * Per player: a byte of direction and flags, the start of the
+ * trail (or the position, if there is no trail yet) as x and y,
+ * the number of runs, then each run as (length << 2 | direction).
+ * Runs come straight from the trail's segments: every tile of a
+ * segment but the last moves along it, and the last moves on to
+ * the next segment, or the position.
+ */
+void encodeBoard(const Tron &tron, std::vector<std::uint8_t> &out)
+{
+    std::vector<std::uint32_t> moves;
+    auto addMoves = [&moves](Direction direction, std::uint32_t count) {
+        std::uint32_t bits = packDirection(direction);
+        if (!moves.empty() && (moves.back() & 3) == bits) {
+            moves.back() += count << 2;
+        } else {
+            moves.push_back(count << 2 | bits);
+        }
+    };
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        const Trail &trail = tron.getTrail(i);
+        Point position = tron.getPosition(i);
+        Direction direction = tron.getDirection(i);
+        std::uint8_t state = direction == Direction::None ? WAITING_FLAG : packDirection(direction);
+        out.push_back(tron.getIsPlaying(i) ? state | PLAYING_FLAG : state);
+        Point start = trail.empty() ? position : trail.front();
+        putVarint(out, static_cast<std::uint32_t>(start.x));
+        putVarint(out, static_cast<std::uint32_t>(start.y));
+
+        moves.clear();
+        const std::vector<Trail::Segment> &segments = trail.getSegments();
+        for (std::size_t s = 0; s < segments.size(); ++s) {
+            const Trail::Segment &segment = segments[s];
+            if (segment.length > 1) {
+                addMoves(segment.direction, static_cast<std::uint32_t>(segment.length - 1));
+            }
+            Point next = s + 1 < segments.size() ? segments[s + 1].start : position;
+            addMoves(directionBetween(segment.end(), next), 1);
+        }
+        putVarint(out, static_cast<std::uint32_t>(moves.size()));
+        for (std::uint32_t move : moves) {
+            putVarint(out, move);
+        }
+    }
+}
+
+/*!
+ * Boards may come off the network, so every tile is checked to be
+ * on the map before it goes anywhere near the occupancy grid.
+ */
+void decodeBoard(const std::uint8_t *data, std::size_t size, std::size_t &offset, Tron &tron)
+{
+    Size mapSize = tron.getMapSize();
+    std::size_t area = static_cast<std::size_t>(mapSize.width) * mapSize.height;
+    auto onMap = [mapSize](Point tile) {
+        return tile.x >= 0 && tile.x < mapSize.width && tile.y >= 0 && tile.y < mapSize.height;
+    };
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        if (offset >= size) {
+            throw std::logic_error{"Corrupt game data."};
+        }
+        std::uint8_t state = data[offset++];
+        Point position;
+        position.x = static_cast<int>(getVarint(data, size, offset));
+        position.y = static_cast<int>(getVarint(data, size, offset));
+        Trail trail;
+        Direction moved = Direction::None;
+        for (std::uint32_t runs = getVarint(data, size, offset); runs > 0; --runs) {
+            std::uint32_t move = getVarint(data, size, offset);
+            for (std::uint32_t m = 0; m < move >> 2; ++m) {
+                if (!onMap(position) || trail.size() >= area) {
+                    throw std::logic_error{"Corrupt game data."};
+                }
+                trail.push_back(position);
+                moved = unpackDirection(move);
+                position = Player::advance(position, moved);
+            }
+        }
+        // The stored direction may be the one about to be taken
+        Direction direction = state & WAITING_FLAG ? Direction::None : unpackDirection(state);
+        if (moved != Direction::None) {
+            direction = moved;
+        }
+        // A player that crashed into the edge ends up just off the map
+        if (!onMap(position) && (direction == Direction::None
+                                 || !onMap(Player::advance(position, Player::opposite(direction))))) {
+            throw std::logic_error{"Corrupt game data."};
+        }
+        tron.placePlayer(i, std::move(trail), position, direction, (state & PLAYING_FLAG) != 0);
+    }
+}
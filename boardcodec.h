@@ -0,0 +1,49 @@
+#ifndef BOARDCODEC_H
+#define BOARDCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "player.h"
+
+class Tron;
+
+/*! \file
+ * Byte encodings shared by everything that stores or sends games:
+ * replays and spectator feeds.
+ */
+
+//! Pack a direction other than None into 2 bits.
+auto packDirection(Player::Direction direction) -> std::uint8_t;
+//! Get the direction packed into the low 2 bits of `bits`.
+auto unpackDirection(unsigned bits) -> Player::Direction;
+
+//! Append `value` seven bits a byte, low bits first.
+void putVarint(std::vector<std::uint8_t> &out, std::uint32_t value);
+//! Read a varint at `offset` of `data`, moving `offset` past it.
+/*!
+ * \throw std::logic_error if it runs off the end.
+ */
+auto getVarint(const std::uint8_t *data, std::size_t size,
+               std::size_t &offset) -> std::uint32_t;
+
+//! Append every player's trail, position, direction and state.
+/*!
+ * Each trail is stored as runs of moves in one direction from
+ * where it started, so the board costs a few bytes per turn taken,
+ * not per tile covered.
+ */
+void encodeBoard(const Tron &tron, std::vector<std::uint8_t> &out);
+//! Place the players encoded at `offset` of `data` into `tron`.
+/*!
+ * `tron` has to be a new game of the encoded map size and player
+ * count; `offset` is moved past the board. Players that have moved
+ * head the way they last moved, as they would in the game played
+ * through; the tick isn't part of the board, so is left to the
+ * caller to place.
+ * \throw std::logic_error if it is corrupt or off the map.
+ */
+void decodeBoard(const std::uint8_t *data, std::size_t size, std::size_t &offset, Tron &tron);
+
+#endif // BOARDCODEC_H
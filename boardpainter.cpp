@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "boardpainter.h"
+
+auto BoardPainter::spreadColors(int count) -> std::vector<QColor>
+{
+    std::vector<QColor> colors;
+    for (int i = 0; i < count; ++i) {
+        colors.push_back(QColor::fromHsv(i * 360 / count, 160, 255));
+    }
+    return colors;
+}
+
+void BoardPainter::reset(Size mapSize, std::vector<QColor> colors)
+{
+    this->mapSize = mapSize;
+    this->colors = std::move(colors);
+    image = QImage{};
+    const int CHUNK = OccupancyGrid::CHUNK_SIZE;
+    chunksWide = (mapSize.width + CHUNK - 1) / CHUNK;
+    forgetRuns(0);
+}
+
+void BoardPainter::setTileSize(int tileSize)
+{
+    this->tileSize = tileSize;
+    image = QImage{};
+}
+
+auto BoardPainter::getTileSize() const -> int
+{
+    return tileSize;
+}
+
+void BoardPainter::cacheImage(const FrameSnapshot &frame, bool withHeads)
+{
+    // Leave room for the right and bottom edges of the outline
+    image = QImage{mapSize.width * tileSize + 1,
+                   mapSize.height * tileSize + 1,
+                   QImage::Format_ARGB32_Premultiplied};
+    image.fill(Qt::transparent);
+    QPainter painter{&image};
+    drawMap(painter);
+
+    // Draw every trail run seen so far, then the heads
+    for (const TrailRun &run : runs) {
+        drawRun(painter, run);
+    }
+    if (withHeads) {
+        drawPredicted(painter, frame);
+    }
+}
+
+/*!
+ * Tiles a player leaves were usually drawn as its head already,
+ * but frames can be skipped if drawing falls behind, so every
+ * tile logged since the last frame is painted along with the
+ * current heads. A tile carrying a run on is joined to the one
+ * before it, so runs look the same however they were drawn.
+ */
+void BoardPainter::addFrame(const FrameSnapshot &frame, const TileLog &tiles, bool withHeads)
+{
+    if (frame.firstTile != firstTile) {
+        forgetRuns(frame.firstTile);
+        if (!image.isNull()) {
+            cacheImage(frame, false);
+        }
+    }
+    if (image.isNull()) {
+        for (; drawnTiles < frame.tileCount; ++drawnTiles) {
+            addTile(tiles[drawnTiles]);
+        }
+        return;
+    }
+    QPainter painter{&image};
+    for (; drawnTiles < frame.tileCount; ++drawnTiles) {
+        const OccupiedTile &tile = tiles[drawnTiles];
+        QColor color = colors[tile.player];
+        drawTile(painter, tile.position, color);
+        int open = openRuns[tile.player];
+        Point previous = open >= 0 ? runs[open].segment.end() : tile.position;
+        if (addTile(tile)) {
+            joinTiles(painter, previous, tile.position, color);
+        }
+    }
+    if (withHeads) {
+        drawPredicted(painter, frame);
+    }
+}
+
+auto BoardPainter::getImage() const -> const QImage&
+{
+    return image;
+}
+
+/*!
+ * Visits only the chunks overlapping the area, and draws each run
+ * crossing them once, so the cost depends on the area and the
+ * turns taken in it rather than the map size.
+ */
+void BoardPainter::paintArea(QPainter &painter, int left, int top, int right, int bottom)
+{
+    drawMap(painter);
+    const int CHUNK = OccupancyGrid::CHUNK_SIZE;
+    visibleRuns.clear();
+    for (int chunkY = top / CHUNK; chunkY * CHUNK < bottom; ++chunkY) {
+        for (int chunkX = left / CHUNK; chunkX * CHUNK < right; ++chunkX) {
+            const std::vector<int> &crossing =
+                    chunkRuns[static_cast<std::size_t>(chunkY) * chunksWide + chunkX];
+            visibleRuns.insert(visibleRuns.end(), crossing.begin(), crossing.end());
+        }
+    }
+    // Long runs cross several chunks
+    std::sort(visibleRuns.begin(), visibleRuns.end());
+    visibleRuns.erase(std::unique(visibleRuns.begin(), visibleRuns.end()), visibleRuns.end());
+    for (int run : visibleRuns) {
+        drawRun(painter, runs[run]);
+    }
+}
+
+void BoardPainter::drawPredicted(QPainter &painter, const FrameSnapshot &frame)
+{
+    for (const OccupiedTile &tile : frame.predicted) {
+        drawTile(painter, tile.position, colors[tile.player]);
+    }
+    for (std::size_t i = 0; i < frame.heads.size(); ++i) {
+        if (frame.alive[i]) {
+            drawTile(painter, frame.heads[i], colors[i]);
+        }
+    }
+}
+
+/*!
+ * A run is indexed under every chunk it crosses, as it reaches
+ * them, so runs are found from any part of the map they cover.
+ */
+void BoardPainter::forgetRuns(std::size_t firstTile)
+{
+    this->firstTile = firstTile;
+    drawnTiles = firstTile;
+    runs.clear();
+    openRuns.assign(colors.size(), -1);
+    const int CHUNK = OccupancyGrid::CHUNK_SIZE;
+    chunkRuns.clear();
+    chunkRuns.resize(static_cast<std::size_t>(chunksWide)
+                     * ((mapSize.height + CHUNK - 1) / CHUNK));
+}
+
+auto BoardPainter::addTile(const OccupiedTile &tile) -> bool
+{
+    const int CHUNK = OccupancyGrid::CHUNK_SIZE;
+    int &open = openRuns[tile.player];
+    if (open >= 0 && runs[open].segment.continuesTo(tile.position)) {
+        Trail::Segment &segment = runs[open].segment;
+        Point previous = segment.end();
+        segment.extendTo(tile.position);
+        if (previous.x / CHUNK != tile.position.x / CHUNK
+                || previous.y / CHUNK != tile.position.y / CHUNK) {
+            indexRun(open, tile.position);
+        }
+        return true;
+    }
+    open = static_cast<int>(runs.size());
+    runs.push_back(TrailRun{Trail::Segment{tile.position, 0, 1, Player::Direction::None},
+                            tile.player});
+    indexRun(open, tile.position);
+    return false;
+}
+
+void BoardPainter::indexRun(int run, Point tile)
+{
+    const int CHUNK = OccupancyGrid::CHUNK_SIZE;
+    chunkRuns[static_cast<std::size_t>(tile.y / CHUNK) * chunksWide + tile.x / CHUNK]
+            .push_back(run);
+}
+
+void BoardPainter::drawMap(QPainter &painter)
+{
+    painter.setBrush(Qt::black);
+    painter.setPen(QPen(QBrush(Qt::white), 1));
+    painter.drawRect(0, 0,
+                     mapSize.width*tileSize,
+                     mapSize.height*tileSize);
+}
+
+void BoardPainter::drawTile(QPainter &painter, Point position, QColor color)
+{
+    painter.setPen(QPen(QBrush(Qt::white), 1));
+    painter.setBrush(color);
+    painter.drawRect(position.x * tileSize, position.y * tileSize,
+                     tileSize, tileSize);
+}
+
+void BoardPainter::drawRun(QPainter &painter, const TrailRun &run)
+{
+    Point start = run.segment.start;
+    Point end = run.segment.end();
+    painter.setPen(QPen(QBrush(Qt::white), 1));
+    painter.setBrush(colors[run.player]);
+    painter.drawRect(std::min(start.x, end.x) * tileSize, std::min(start.y, end.y) * tileSize,
+                     (std::abs(end.x - start.x) + 1) * tileSize,
+                     (std::abs(end.y - start.y) + 1) * tileSize);
+}
+
+/*!
+ * The shared edge lies between the tiles' outlines; its two end
+ * pixels belong to the outline of the run and are left white.
+ */
+void BoardPainter::joinTiles(QPainter &painter, Point from, Point to, QColor color)
+{
+    if (from.y == to.y) {
+        painter.fillRect(std::max(from.x, to.x) * tileSize, from.y * tileSize + 1,
+                         1, tileSize - 1, color);
+    } else {
+        painter.fillRect(from.x * tileSize + 1, std::max(from.y, to.y) * tileSize,
+                         tileSize - 1, 1, color);
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef BOARDPAINTER_H
+#define BOARDPAINTER_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+
+#include "trail.h"
+#include "tronrunner.h"
+
+//! Draws a game from its TileLog, one rectangle per straight run of trail.
+/*!
+ * Runs are rebuilt from the log as tiles come in, and indexed by
+ * the chunks they cross. A picture of the whole board can be kept
+ * up to date in getImage(), a few tiles per frame; otherwise any
+ * part of the map is drawn on demand with paintArea(). Only needs
+ * QtGui, so it works on any thread and without a display.
+ */
+class BoardPainter
+{
+public:
+    //! Get `count` colours, for as many bots, with hues spread evenly.
+    static auto spreadColors(int count) -> std::vector<QColor>;
+
+    //! Start over with an empty map of `mapSize`, one colour per player.
+    void reset(Size mapSize, std::vector<QColor> colors);
+    //! Draw tiles `tileSize` pixels wide; the cached image is dropped.
+    void setTileSize(int tileSize);
+    auto getTileSize() const -> int;
+
+    //! Draw the whole board into getImage() and keep it up to date.
+    /*!
+     * \param withHeads Whether to draw the heads of `frame` in too.
+     */
+    void cacheImage(const FrameSnapshot &frame, bool withHeads);
+    //! Take in the tiles logged up to `frame`, drawing them into the cached image.
+    /*!
+     * If `frame` starts its game at a different tile of the log
+     * than the frames before, the game was replaced, and what was
+     * drawn of the old one is forgotten.
+     * \param withHeads Whether to draw the heads of `frame` in too;
+     * only for games that can't be rewound, since heads are simply
+     * drawn over by the tiles they become.
+     */
+    void addFrame(const FrameSnapshot &frame, const TileLog &tiles, bool withHeads);
+    //! Get the picture of the whole board, or a null image if not cached.
+    auto getImage() const -> const QImage&;
+
+    //! Draw the map outline and the runs crossing the tiles in [`left`, `right`) x [`top`, `bottom`).
+    /*!
+     * Runs are drawn whole; the painter's clipping keeps what shows.
+     */
+    void paintArea(QPainter &painter, int left, int top, int right, int bottom);
+    //! Draw what may still be rewound: heads and predicted tiles.
+    void drawPredicted(QPainter &painter, const FrameSnapshot &frame);
+
+private:
+    //! A straight run of one player's trail.
+    struct TrailRun
+    {
+        Trail::Segment segment;
+        int player;
+    };
+
+    Size mapSize{0, 0};
+    std::vector<QColor> colors;
+    int tileSize{1};
+    //! Cached picture of the board at the current tile size.
+    QImage image;
+    //! Entry of the log where the game drawn starts.
+    std::size_t firstTile{0};
+    //! Number of logged trail tiles already taken in.
+    std::size_t drawnTiles{0};
+    //! Every run of the tiles taken in so far, in the order they began.
+    std::vector<TrailRun> runs;
+    //! Index in `runs` of each player's latest run, or -1.
+    std::vector<int> openRuns;
+    //! Indices in `runs` of the runs crossing each chunk.
+    /*!
+     * Chunks are OccupancyGrid::CHUNK_SIZE squares, so drawing part
+     * of the map only looks at runs near it, however big the map.
+     */
+    std::vector<std::vector<int>> chunkRuns;
+    //! Width of the map in chunks.
+    int chunksWide{0};
+    //! Runs paintArea() is about to draw, kept to save allocating.
+    std::vector<int> visibleRuns;
+
+    //! Forget every run, to draw the game starting at log entry `firstTile`.
+    void forgetRuns(std::size_t firstTile);
+    //! Add `tile` to its player's runs.
+    /*!
+     * \return Whether it carried on the player's latest run.
+     */
+    auto addTile(const OccupiedTile &tile) -> bool;
+    //! Record run `run` as crossing the chunk holding `tile`.
+    void indexRun(int run, Point tile);
+    //! Draw the outline of the whole map.
+    void drawMap(QPainter &painter);
+    //! Draw one tile of `color` at `position` using `painter`.
+    void drawTile(QPainter &painter, Point position, QColor color);
+    //! Draw `run` as one outlined rectangle of its player's colour.
+    void drawRun(QPainter &painter, const TrailRun &run);
+    //! Fill in the outline between neighbouring tiles `from` and `to`.
+    /*!
+     * Tiles drawn one by one and then joined look the same as the
+     * run drawn in one go by drawRun().
+     */
+    void joinTiles(QPainter &painter, Point from, Point to, QColor color);
+
+};
+
+#endif // BOARDPAINTER_H
@@ -0,0 +1,322 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "bots.h"
+#include "minimaxbot.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+
+const Direction DIRECTIONS[] = {
+    Direction::Up, Direction::Down, Direction::Left, Direction::Right
+};
+
+//! Check if a rival could also step onto `position` this tick.
+auto risksHeadOn(Point position, const std::vector<Point> &rivals) -> bool
+{
+    for (Point rival : rivals) {
+        if (std::abs(rival.x - position.x) + std::abs(rival.y - position.y) == 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//! Pick the best-scoring direction for `player`.
+/*!
+ * Reversing is never considered. Moves that might meet a rival
+ * head-on lose to any safe move with room to spare, and ties go
+ * to carrying straight on.
+ */
+template <typename Score>
+auto bestMove(const Tron &tron, int player, const SearchWindow &window,
+              const std::vector<Point> &rivals, Score score) -> Direction
+{
+    Direction current = tron.getDirection(player);
+    Point head = tron.getPosition(player);
+    Direction best = current != Direction::None ? current : Direction::Up;
+    long bestScore = -1;
+    for (Direction direction : DIRECTIONS) {
+        if (direction == Player::opposite(current)) {
+            continue;
+        }
+        Point next = Player::advance(head, direction);
+        if (!window.isFree(next)) {
+            continue;
+        }
+        // Scale scores so straight-on wins ties
+        long value = 2 * static_cast<long>(score(next)) + (direction == current ? 1 : 0);
+        if (risksHeadOn(next, rivals)) {
+            value /= 4;
+        }
+        if (value > bestScore) {
+            best = direction;
+            bestScore = value;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+SearchWindow::SearchWindow(int radius)
+    : radius(radius)
+    , side(2 * radius + 1)
+    , origin{0, 0}
+    , blocked(side * side)
+    , visited(side * side, 0)
+    , distance(side * side)
+    , owner(side * side)
+{
+    queue.reserve(side * side);
+}
+
+void SearchWindow::load(const Tron &tron, Point centre)
+{
+    origin = Point{centre.x - radius, centre.y - radius};
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            blocked[y * side + x] = tron.isBlocked(Point{origin.x + x, origin.y + y});
+        }
+    }
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        Point head = tron.getPosition(i);
+        if (tron.getIsPlaying(i) && contains(head)) {
+            blocked[indexOf(head)] = true;
+        }
+    }
+}
+
+auto SearchWindow::contains(Point position) const -> bool
+{
+    return position.x >= origin.x && position.x < origin.x + side
+            && position.y >= origin.y && position.y < origin.y + side;
+}
+
+auto SearchWindow::indexOf(Point position) const -> int
+{
+    return (position.y - origin.y) * side + (position.x - origin.x);
+}
+
+auto SearchWindow::isFree(Point position) const -> bool
+{
+    return contains(position) && !blocked[indexOf(position)];
+}
+
+void SearchWindow::nextGeneration()
+{
+    if (++generation == 0) {
+        // Wrapped; stale marks could look current again
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+    queue.clear();
+}
+
+auto SearchWindow::reachable(Point start) -> int
+{
+    if (!isFree(start)) {
+        return 0;
+    }
+    nextGeneration();
+    queue.push_back(indexOf(start));
+    visited[queue.back()] = generation;
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+        int index = queue[next];
+        int x = index % side;
+        int y = index / side;
+        const int neighbours[4] = {index - side, index + side, index - 1, index + 1};
+        const bool valid[4] = {y > 0, y < side - 1, x > 0, x < side - 1};
+        for (int n = 0; n < 4; ++n) {
+            if (valid[n] && !blocked[neighbours[n]] && visited[neighbours[n]] != generation) {
+                visited[neighbours[n]] = generation;
+                queue.push_back(neighbours[n]);
+            }
+        }
+    }
+    return static_cast<int>(queue.size());
+}
+
+auto SearchWindow::territory(Point start, const std::vector<Point> &rivals) -> int
+{
+    if (!isFree(start)) {
+        return 0;
+    }
+    nextGeneration();
+    // Rivals have yet to move, so their heads sit at distance 0
+    // and our first step at distance 1; FIFO order keeps every
+    // distance-0 tile ahead of every distance-1 tile.
+    for (Point rival : rivals) {
+        int index = indexOf(rival);
+        visited[index] = generation;
+        distance[index] = 0;
+        owner[index] = 1;
+        queue.push_back(index);
+    }
+    int index = indexOf(start);
+    visited[index] = generation;
+    distance[index] = 1;
+    owner[index] = 0;
+    queue.push_back(index);
+
+    int ours = 0;
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+        index = queue[next];
+        if (owner[index] < 0) {
+            // Contested tiles don't extend anyone's claim
+            continue;
+        }
+        if (owner[index] == 0) {
+            ++ours;
+        }
+        int x = index % side;
+        int y = index / side;
+        const int neighbours[4] = {index - side, index + side, index - 1, index + 1};
+        const bool valid[4] = {y > 0, y < side - 1, x > 0, x < side - 1};
+        for (int n = 0; n < 4; ++n) {
+            int neighbour = neighbours[n];
+            if (!valid[n] || blocked[neighbour]) {
+                continue;
+            }
+            if (visited[neighbour] != generation) {
+                visited[neighbour] = generation;
+                distance[neighbour] = distance[index] + 1;
+                owner[neighbour] = owner[index];
+                queue.push_back(neighbour);
+            } else if (distance[neighbour] == distance[index] + 1
+                       && owner[neighbour] != owner[index]) {
+                owner[neighbour] = -1;
+            }
+        }
+    }
+    return ours;
+}
+
+auto SearchWindow::balance(Point ours, Point theirs) -> int
+{
+    nextGeneration();
+    const Point heads[2] = {ours, theirs};
+    for (int who = 0; who < 2; ++who) {
+        if (contains(heads[who])) {
+            int index = indexOf(heads[who]);
+            visited[index] = generation;
+            distance[index] = 0;
+            owner[index] = who;
+            queue.push_back(index);
+        }
+    }
+
+    int counts[2] = {0, 0};
+    for (std::size_t next = 0; next < queue.size(); ++next) {
+        int index = queue[next];
+        if (owner[index] < 0) {
+            continue;
+        }
+        ++counts[owner[index]];
+        int x = index % side;
+        int y = index / side;
+        const int neighbours[4] = {index - side, index + side, index - 1, index + 1};
+        const bool valid[4] = {y > 0, y < side - 1, x > 0, x < side - 1};
+        for (int n = 0; n < 4; ++n) {
+            int neighbour = neighbours[n];
+            if (!valid[n] || blocked[neighbour]) {
+                continue;
+            }
+            if (visited[neighbour] != generation) {
+                visited[neighbour] = generation;
+                distance[neighbour] = distance[index] + 1;
+                owner[neighbour] = owner[index];
+                queue.push_back(neighbour);
+            } else if (distance[neighbour] == distance[index] + 1
+                       && owner[neighbour] != owner[index]) {
+                owner[neighbour] = -1;
+            }
+        }
+    }
+    // The heads themselves were counted; they cancel out unless
+    // one was left out, and a head is worth no room either way.
+    return (counts[0] - contains(ours)) - (counts[1] - contains(theirs));
+}
+
+FloodFillBot::FloodFillBot(int radius)
+    : window(radius)
+{}
+
+auto FloodFillBot::decide(const Tron &tron, int player) -> Player::Direction
+{
+    static const std::vector<Point> NO_RIVALS;
+    window.load(tron, tron.getPosition(player));
+    return bestMove(tron, player, window, NO_RIVALS,
+                    [this](Point next) { return window.reachable(next); });
+}
+
+VoronoiBot::VoronoiBot(int radius)
+    : window(radius)
+{}
+
+auto VoronoiBot::decide(const Tron &tron, int player) -> Player::Direction
+{
+    Point head = tron.getPosition(player);
+    window.load(tron, head);
+    rivals.clear();
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        if (i != player && tron.getIsPlaying(i)) {
+            Point rival = tron.getPosition(i);
+            if (window.contains(rival)) {
+                rivals.push_back(rival);
+            }
+        }
+    }
+    return bestMove(tron, player, window, rivals,
+                    [this](Point next) { return window.territory(next, rivals); });
+}
+
+PolicyController::PolicyController(Policy policy, std::uint32_t seed)
+    : policy(policy)
+    , rng(seed)
+{}
+
+auto PolicyController::decide(const Tron &tron, int player) -> Player::Direction
+{
+    return policy(tron, player, rng);
+}
+
+auto builtinControllers() -> const std::vector<NamedController>&
+{
+    static const std::vector<NamedController> controllers{
+        {"random", [](std::uint32_t seed) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new PolicyController{randomPolicy, seed}};
+         }},
+        {"cautious", [](std::uint32_t seed) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new PolicyController{cautiousPolicy, seed}};
+         }},
+        {"spacious", [](std::uint32_t seed) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new PolicyController{spaciousPolicy, seed}};
+         }},
+        {"floodfill", [](std::uint32_t) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new FloodFillBot{}};
+         }},
+        {"voronoi", [](std::uint32_t) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new VoronoiBot{}};
+         }},
+        {"minimax", [](std::uint32_t) -> std::unique_ptr<Controller> {
+             return std::unique_ptr<Controller>{new MinimaxBot{}};
+         }},
+    };
+    return controllers;
+}
+
+auto findController(const char *name) -> ControllerFactory
+{
+    for (const NamedController &controller : builtinControllers()) {
+        if (std::strcmp(controller.name, name) == 0) {
+            return controller.create;
+        }
+    }
+    return nullptr;
+}
+
+// Constants
+const int FloodFillBot::DEFAULT_RADIUS{24};
+const int VoronoiBot::DEFAULT_RADIUS{24};
@@ -0,0 +1,126 @@
+#ifndef BOTS_H
+#define BOTS_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "controller.h"
+#include "policy.h"
+#include "tron.h"
+
+//! Square scratch area around a head for bounded searches.
+/*!
+ * Searches never look further than `radius` tiles away, so their
+ * cost is fixed no matter how large the map or how long the game,
+ * and hundreds of bots can decide within a single tick.
+ */
+class SearchWindow
+{
+public:
+    explicit SearchWindow(int radius);
+
+    //! Centre on `centre` and note which tiles are blocked.
+    /*!
+     * Walls, trails and the head of every player in play count
+     * as blocked.
+     */
+    void load(const Tron &tron, Point centre);
+    //! Check if `position` is inside the window and free.
+    auto isFree(Point position) const -> bool;
+    //! Check if `position` lies in the window.
+    auto contains(Point position) const -> bool;
+    //! Count free tiles reachable from `start`.
+    auto reachable(Point start) -> int;
+    //! Count tiles reached from `start` strictly before any rival.
+    /*!
+     * `start` is one move away from our head, while `rivals` are
+     * heads that have yet to move; tiles reached at the same time
+     * are contested and count for nobody.
+     */
+    auto territory(Point start, const std::vector<Point> &rivals) -> int;
+    //! Count tiles `ours` reaches before `theirs`, less the reverse.
+    /*!
+     * Both are heads that have just moved. A head outside the
+     * window is left out, so the other simply counts its room.
+     */
+    auto balance(Point ours, Point theirs) -> int;
+
+private:
+    const int radius;
+    //! Width and height in tiles.
+    const int side;
+    //! Map position of the window's top left tile.
+    Point origin;
+    //! Whether each tile is blocked.
+    std::vector<std::uint8_t> blocked;
+    //! Search generation that last reached each tile.
+    std::vector<std::uint32_t> visited;
+    std::uint32_t generation{0};
+    //! Search distance of each tile, valid when visited.
+    std::vector<int> distance;
+    //! Who reached each tile first: 0 us, 1 a rival, -1 contested.
+    std::vector<int> owner;
+    //! Breadth-first search queue.
+    std::vector<int> queue;
+
+    //! Get the window index of `position`.
+    auto indexOf(Point position) const -> int;
+    //! Start a new search, forgetting what the last one reached.
+    void nextGeneration();
+
+};
+
+//! Moves towards whichever side has the most room to fill.
+class FloodFillBot : public Controller
+{
+public:
+    static const int DEFAULT_RADIUS;
+
+    explicit FloodFillBot(int radius = DEFAULT_RADIUS);
+
+    auto decide(const Tron &tron, int player) -> Player::Direction override;
+
+private:
+    SearchWindow window;
+
+};
+
+//! Moves to claim the most tiles it can reach before any rival.
+/*!
+ * Scores each move by its Voronoi territory: a breadth-first search
+ * from every head at once, counting the tiles this player gets to
+ * first. Once walled off from everyone that is simply the room
+ * left to fill.
+ */
+class VoronoiBot : public Controller
+{
+public:
+    static const int DEFAULT_RADIUS;
+
+    explicit VoronoiBot(int radius = DEFAULT_RADIUS);
+
+    auto decide(const Tron &tron, int player) -> Player::Direction override;
+
+private:
+    SearchWindow window;
+    //! Heads of rivals inside the window.
+    std::vector<Point> rivals;
+
+};
+
+//! Drives a player with one of the simple Policy functions.
+class PolicyController : public Controller
+{
+public:
+    PolicyController(Policy policy, std::uint32_t seed);
+
+    auto decide(const Tron &tron, int player) -> Player::Direction override;
+
+private:
+    Policy policy;
+    std::mt19937 rng;
+
+};
+
+#endif // BOTS_H
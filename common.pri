@@ -0,0 +1,12 @@
+# Settings shared by every project in Tron.pro
+
+QMAKE_CXXFLAGS += -std=c++11
+
+# Cross-check the occupancy grid against a full trail scan every tick.
+#DEFINES += TRON_VERIFY_OCCUPANCY
+
+# Several projects build from this one directory, so
+# keep their intermediate files apart.
+OBJECTS_DIR = .obj/$$TARGET
+MOC_DIR = .moc/$$TARGET
+UI_DIR = .ui/$$TARGET
@@ -0,0 +1,46 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "player.h"
+
+class Tron;
+
+//! Steers a computer-controlled player.
+/*!
+ * Tron asks each player's controller for a direction at the start
+ * of every step(), before anyone moves, so every controller sees
+ * the same board. Controllers run on the simulation thread and may
+ * keep scratch state between ticks.
+ */
+class Controller
+{
+public:
+    virtual ~Controller() {}
+
+    //! Choose the direction `player` should travel this tick.
+    virtual auto decide(const Tron &tron, int player) -> Player::Direction = 0;
+};
+
+//! Creates a controller; any randomness it uses comes from `seed`.
+typedef auto (*ControllerFactory)(std::uint32_t seed) -> std::unique_ptr<Controller>;
+
+//! A kind of controller with a displayable name, for menus and reports.
+struct NamedController
+{
+    const char *name;
+    ControllerFactory create;
+};
+
+//! Get every built-in kind of controller.
+auto builtinControllers() -> const std::vector<NamedController>&;
+//! Find a built-in kind of controller by name.
+/*!
+ * \return The factory, or null if there is none called `name`.
+ */
+auto findController(const char *name) -> ControllerFactory;
+
+#endif // CONTROLLER_H
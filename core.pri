@@ -0,0 +1,4 @@
+# Link against the headless engine built by core.pro
+
+LIBS += -L$$OUT_PWD -ltroncore
+PRE_TARGETDEPS += $$OUT_PWD/libtroncore.a
@@ -0,0 +1,77 @@
+#-------------------------------------------------
+#
+# Headless game engine; no Qt required.
+#
+#-------------------------------------------------
+
+CONFIG -= qt
+CONFIG += staticlib
+
+TARGET = troncore
+TEMPLATE = lib
+
+include(common.pri)
+
+SOURCES += \
+    tron.cpp \
+    player.cpp \
+    trail.cpp \
+    occupancygrid.cpp \
+    rayindex.cpp \
+    headtable.cpp \
+    bitboard.cpp \
+    policy.cpp \
+    bots.cpp \
+    minimaxbot.cpp \
+    transpositiontable.cpp \
+    match.cpp \
+    matchpool.cpp \
+    boardcodec.cpp \
+    replay.cpp \
+    spectatorfeed.cpp \
+    udpchannel.cpp \
+    spectatorlink.cpp \
+    rollbacksession.cpp \
+    workstealing.cpp \
+    workerteam.cpp \
+    tilelog.cpp \
+    latencyhistogram.cpp \
+    tickprofiler.cpp \
+    tronrunner.cpp \
+    batchenvironment.cpp
+
+HEADERS += \
+    geometry.h \
+    tron.h \
+    player.h \
+    trail.h \
+    arena.h \
+    occupancygrid.h \
+    rayindex.h \
+    headtable.h \
+    bitboard.h \
+    bits.h \
+    inputqueue.h \
+    policy.h \
+    controller.h \
+    bots.h \
+    minimaxbot.h \
+    transpositiontable.h \
+    zobrist.h \
+    match.h \
+    matchpool.h \
+    boardcodec.h \
+    replay.h \
+    spectatorfeed.h \
+    udpchannel.h \
+    spectatorlink.h \
+    rollbacksession.h \
+    workstealing.h \
+    workerteam.h \
+    snapshotexchange.h \
+    reorderbuffer.h \
+    tilelog.h \
+    latencyhistogram.h \
+    tickprofiler.h \
+    tronrunner.h \
+    batchenvironment.h
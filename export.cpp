@@ -0,0 +1,407 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QGuiApplication>
+#include <QImage>
+
+#include "boardpainter.h"
+#include "match.h"
+#include "reorderbuffer.h"
+#include "replay.h"
+#include "tron.h"
+
+namespace {
+
+//! Frames each thread may have in flight, waiting to be drawn or written.
+const std::size_t FRAMES_PER_THREAD = 4;
+
+struct Options
+{
+    //! Replay file to render, or null to play new games.
+    const char *replay = nullptr;
+    //! Index of the one replay to render, or -1 for every one.
+    long game = -1;
+    long games = 1;
+    std::uint32_t seed = 1;
+    Size mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
+    int playerCount = Tron::MIN_PLAYER_COUNT;
+    ControllerFactory controller = findController("random");
+    //! Pixels per tile.
+    int tileSize = 8;
+    //! Ticks per frame.
+    int every = 1;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    //! Directory to write one PNG per frame to, if any.
+    const char *png = nullptr;
+    //! File to write raw RGB frames to, "-" for standard output, if any.
+    const char *raw = nullptr;
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " (--png DIR | --raw FILE) [options]\n"
+              << "  --png DIR     write each frame to DIR/GAME-TICK.png\n"
+              << "  --raw FILE    write every frame as raw rgb24 to FILE (- for stdout)\n"
+              << "  --replay FILE render the replays in FILE rather than new games\n"
+              << "  --game I      only render replay I of FILE\n"
+              << "  --games N     number of new games to play (default 1)\n"
+              << "  --seed S      seed of the first new game (default 1)\n"
+              << "  --width W     map width in tiles\n"
+              << "  --height H    map height in tiles\n"
+              << "  --players P   players per game\n"
+              << "  --tile N      pixels per tile (default 8)\n"
+              << "  --every N     ticks per frame (default 1)\n"
+              << "  --threads T   drawing threads (default: all cores)\n"
+              << "  --bot NAME    controller for every player (default random):";
+    for (const NamedController &controller : builtinControllers()) {
+        std::cerr << " " << controller.name;
+    }
+    std::cerr << "\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--bot") == 0) {
+            options.controller = findController(argv[i + 1]);
+            if (!options.controller) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--png") == 0) {
+            options.png = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--raw") == 0) {
+            options.raw = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--replay") == 0) {
+            options.replay = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--game") == 0) {
+            options.game = value;
+        } else if (std::strcmp(argv[i], "--games") == 0) {
+            options.games = value;
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(value);
+        } else if (std::strcmp(argv[i], "--width") == 0) {
+            options.mapSize.width = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--height") == 0) {
+            options.mapSize.height = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--players") == 0) {
+            options.playerCount = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--tile") == 0) {
+            options.tileSize = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--every") == 0) {
+            options.every = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options.threads = static_cast<int>(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return (options.png || options.raw) && options.tileSize >= 2
+            && options.every >= 1 && options.threads >= 1;
+}
+
+//! One frame to draw: a game's tiles so far, and where its heads are.
+struct FrameJob
+{
+    //! Place of the frame in the output.
+    std::size_t index;
+    //! Number of the game, counting from 0 in the order played.
+    long game;
+    Size mapSize;
+    //! Every tile of the game logged so far; later frames add to it.
+    std::shared_ptr<const TileLog> tiles;
+    FrameSnapshot frame;
+};
+
+//! One frame drawn and encoded, ready to write.
+struct EncodedFrame
+{
+    long game;
+    long tick;
+    QByteArray data;
+};
+
+//! Frames on their way from the game, through the drawing threads, to the file.
+struct Pipeline
+{
+    explicit Pipeline(std::size_t capacity)
+        : jobs(capacity)
+        , frames(capacity)
+    {
+    }
+
+    ReorderBuffer<FrameJob> jobs;
+    ReorderBuffer<EncodedFrame> frames;
+    //! Set when writing failed, so no more frames are made.
+    std::atomic<bool> stopping{false};
+};
+
+/*!
+ * Each game gets a TileLog of its own, which the drawing threads
+ * read up to each frame's `tileCount` while more is logged.
+ */
+class FrameMaker
+{
+public:
+    FrameMaker(const Options &options, Pipeline &pipeline)
+        : options(options)
+        , pipeline(pipeline)
+    {
+    }
+
+    //! Make frames of `game` from its start until step() says it's over.
+    /*!
+     * \return Whether to go on to more games.
+     */
+    auto play(const Tron &game, const std::function<auto () -> bool> &step) -> bool
+    {
+        Size mapSize = game.getMapSize();
+        std::shared_ptr<TileLog> tiles{new TileLog{static_cast<std::size_t>(mapSize.width)
+                                                   * mapSize.height}};
+        std::vector<std::size_t> logged(game.getPlayerCount(), 0);
+        bool playing = true;
+        while (!pipeline.stopping.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < game.getPlayerCount(); ++i) {
+                const Trail &trail = game.getTrail(i);
+                for (; logged[i] < trail.size(); ++logged[i]) {
+                    tiles->append(OccupiedTile{trail[logged[i]], i});
+                }
+            }
+            if (!playing || game.getTick() % options.every == 0) {
+                FrameJob job{frameCount, gameCount, mapSize, tiles, FrameSnapshot{}};
+                snapshot(game, *tiles, job.frame);
+                pipeline.jobs.put(frameCount++, std::move(job));
+            }
+            if (!playing) {
+                ++gameCount;
+                return true;
+            }
+            playing = step();
+        }
+        return false;
+    }
+
+    //! Get the number of frames made so far.
+    auto getFrameCount() const -> std::size_t
+    {
+        return frameCount;
+    }
+
+private:
+    const Options &options;
+    Pipeline &pipeline;
+    long gameCount{0};
+    std::size_t frameCount{0};
+
+    //! Fill in `frame` with where `game` stands, `tiles` logged.
+    void snapshot(const Tron &game, const TileLog &tiles, FrameSnapshot &frame)
+    {
+        int playerCount = game.getPlayerCount();
+        frame.tick = game.getTick();
+        frame.heads.resize(playerCount);
+        frame.alive.resize(playerCount);
+        for (int i = 0; i < playerCount; ++i) {
+            frame.heads[i] = game.getPosition(i);
+            frame.alive[i] = game.getIsPlaying(i);
+        }
+        frame.tileCount = tiles.size();
+        frame.over = game.gameIsOver();
+        frame.winner = frame.over ? game.getWinner() : -1;
+    }
+};
+
+//! Play or replay every game asked for, then close the pipeline.
+void makeFrames(const Options &options, Pipeline &pipeline, std::string &error)
+{
+    FrameMaker maker{options, pipeline};
+    try {
+        if (options.replay) {
+            ReplayFile file{options.replay};
+            long first = options.game >= 0 ? options.game : 0;
+            long last = options.game >= 0 ? options.game + 1
+                                          : static_cast<long>(file.getReplayCount());
+            if (last > static_cast<long>(file.getReplayCount())) {
+                throw std::logic_error{"No such game in the replay file."};
+            }
+            for (long i = first; i < last; ++i) {
+                ReplayPlayer player{file.getReplay(static_cast<std::size_t>(i))};
+                if (!maker.play(player.getTron(), [&player] { return player.step(); })) {
+                    break;
+                }
+            }
+        } else {
+            std::vector<ControllerFactory> seats(options.playerCount, options.controller);
+            for (long game = 0; game < options.games; ++game) {
+                std::uint32_t seed = options.seed + static_cast<std::uint32_t>(game);
+                std::unique_ptr<Tron> tron = makeMatch(options.mapSize, seats, seed);
+                if (!maker.play(*tron, [&tron] { return tron->step(); })) {
+                    break;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        error = exception.what();
+    }
+    pipeline.jobs.close(maker.getFrameCount());
+    pipeline.frames.close(maker.getFrameCount());
+}
+
+/*!
+ * Frames are taken in order, so each thread's BoardPainter only
+ * ever moves forward through a game: it draws the tiles logged
+ * since its last frame and encodes the result.
+ */
+void drawFrames(const Options &options, Pipeline &pipeline)
+{
+    BoardPainter painter;
+    long game = -1;
+    FrameJob job;
+    while (pipeline.jobs.take(job)) {
+        if (job.game != game) {
+            painter.reset(job.mapSize, BoardPainter::spreadColors(
+                              static_cast<int>(job.frame.heads.size())));
+            painter.setTileSize(options.tileSize);
+            painter.cacheImage(FrameSnapshot{}, false);
+            game = job.game;
+        }
+        painter.addFrame(job.frame, *job.tiles, true);
+        QImage image = painter.getImage().convertToFormat(QImage::Format_RGB888);
+
+        EncodedFrame encoded{job.game, job.frame.tick, QByteArray{}};
+        if (options.png) {
+            QBuffer buffer{&encoded.data};
+            buffer.open(QIODevice::WriteOnly);
+            image.save(&buffer, "PNG");
+        } else {
+            // Rows of a QImage are padded to whole words
+            int rowBytes = image.width() * 3;
+            encoded.data.resize(rowBytes * image.height());
+            for (int y = 0; y < image.height(); ++y) {
+                std::memcpy(encoded.data.data() + y * rowBytes, image.constScanLine(y),
+                            static_cast<std::size_t>(rowBytes));
+            }
+        }
+        pipeline.frames.put(job.index, std::move(encoded));
+    }
+}
+
+//! Write `frame` where `options` says.
+/*!
+ * A raw stream has no header, so every frame in it has to be the
+ * same size; `rawBytes` is the size of the first, or 0.
+ */
+void writeFrame(const Options &options, const EncodedFrame &frame, std::FILE *raw, int &rawBytes)
+{
+    if (options.png) {
+        char name[32];
+        std::snprintf(name, sizeof name, "/%06ld-%06ld.png", frame.game, frame.tick);
+        std::string path = std::string{options.png} + name;
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        bool written = file && std::fwrite(frame.data.constData(), 1, frame.data.size(), file)
+                == static_cast<std::size_t>(frame.data.size());
+        if (!file || std::fclose(file) != 0 || !written) {
+            throw std::runtime_error{"Can't write " + path + "."};
+        }
+        return;
+    }
+    if (rawBytes != 0 && frame.data.size() != rawBytes) {
+        throw std::logic_error{"Every game written raw has to be on the same map."};
+    }
+    rawBytes = frame.data.size();
+    if (std::fwrite(frame.data.constData(), 1, frame.data.size(), raw)
+            != static_cast<std::size_t>(frame.data.size())) {
+        throw std::runtime_error{std::string{"Can't write "} + options.raw + "."};
+    }
+}
+
+} // namespace
+
+/*!
+ * The game is played on one thread, frames are drawn and encoded
+ * on `--threads` others, and written in order on this one. Raw
+ * frames suit piping into a video encoder, e.g.
+ * `ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH -r 30 -i - clip.mp4`,
+ * where W and H are the map size times the tile size, plus one.
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    // Fonts and images need an application, but no display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication application{argc, argv};
+
+    std::FILE *raw = nullptr;
+    if (options.raw) {
+        raw = std::strcmp(options.raw, "-") == 0 ? stdout : std::fopen(options.raw, "wb");
+        if (!raw) {
+            std::cerr << "Can't write " << options.raw << "." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Pipeline pipeline{FRAMES_PER_THREAD * static_cast<std::size_t>(options.threads)};
+    // Each thread reports its own error, so they don't race
+    std::string makeError;
+    std::string error;
+    std::thread maker{makeFrames, std::cref(options), std::ref(pipeline), std::ref(makeError)};
+    std::vector<std::thread> drawers;
+    for (int i = 0; i < options.threads; ++i) {
+        drawers.emplace_back(drawFrames, std::cref(options), std::ref(pipeline));
+    }
+
+    // Once writing fails, the frames in flight are only drained
+    long frames = 0;
+    int rawBytes = 0;
+    EncodedFrame frame;
+    while (pipeline.frames.take(frame)) {
+        if (pipeline.stopping.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        try {
+            writeFrame(options, frame, raw, rawBytes);
+            ++frames;
+        } catch (const std::exception &exception) {
+            error = exception.what();
+            pipeline.stopping.store(true, std::memory_order_relaxed);
+        }
+    }
+    maker.join();
+    for (std::thread &drawer : drawers) {
+        drawer.join();
+    }
+    if (raw && raw != stdout && std::fclose(raw) != 0 && error.empty()) {
+        error = std::string{"Can't write "} + options.raw + ".";
+    }
+    if (error.empty()) {
+        error = makeError;
+    }
+    if (!error.empty()) {
+        std::cerr << error << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cerr << "frames: " << frames << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,21 @@
+#-------------------------------------------------
+#
+# Renders games to PNG frames or raw video, headlessly.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+CONFIG += console thread
+CONFIG -= app_bundle
+
+TARGET = tron-export
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += export.cpp \
+    boardpainter.cpp
+
+HEADERS  += boardpainter.h
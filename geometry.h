@@ -0,0 +1,38 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+//! A tile position on the map.
+struct Point
+{
+    int x;
+    int y;
+};
+
+inline auto operator==(Point a, Point b) -> bool
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+inline auto operator!=(Point a, Point b) -> bool
+{
+    return !(a == b);
+}
+
+//! Dimensions of the map in tiles.
+struct Size
+{
+    int width;
+    int height;
+};
+
+inline auto operator==(Size a, Size b) -> bool
+{
+    return a.width == b.width && a.height == b.height;
+}
+
+inline auto operator!=(Size a, Size b) -> bool
+{
+    return !(a == b);
+}
+
+#endif // GEOMETRY_H
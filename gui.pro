@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2013-07-27T14:37:19
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += thread
+
+TARGET = Tron
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += main.cpp\
+        mainwindow.cpp \
+    tronwidget.cpp \
+    boardpainter.cpp
+
+HEADERS  += mainwindow.h \
+    tronwidget.h \
+    boardpainter.h \
+    clamp.h
+
+FORMS    += mainwindow.ui
@@ -0,0 +1,103 @@
+#include "headtable.h"
+
+namespace {
+
+//! Get the table size for `playerCount` heads.
+auto tableSize(int playerCount) -> std::size_t
+{
+    // Keep the load factor at or under one half
+    std::size_t size = 16;
+    while (size < static_cast<std::size_t>(playerCount) * 2) {
+        size *= 2;
+    }
+    return size;
+}
+
+//! Get the slot to start looking for `key` in.
+auto homeSlot(std::uint64_t key, std::size_t mask) -> std::size_t
+{
+    // Fibonacci hashing spreads neighbouring tiles apart
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+} // namespace
+
+HeadTable::HeadTable(Size mapSize, int playerCount)
+    : mapWidth(mapSize.width)
+{
+    std::size_t size = tableSize(playerCount);
+    keys.assign(size, 0);
+    owners.assign(size, -1);
+    used.reserve(playerCount);
+    mask = size - 1;
+}
+
+auto HeadTable::claim(Point position, int player) -> int
+{
+    std::uint64_t key = static_cast<std::uint64_t>(position.y) * mapWidth + position.x + 1;
+    std::size_t slot = homeSlot(key, mask);
+    while (keys[slot] != 0) {
+        if (keys[slot] == key) {
+            return owners[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    keys[slot] = key;
+    owners[slot] = player;
+    used.push_back(slot);
+    return -1;
+}
+
+void HeadTable::clear()
+{
+    for (std::size_t slot : used) {
+        keys[slot] = 0;
+    }
+    used.clear();
+}
+
+ConcurrentHeadTable::ConcurrentHeadTable(Size mapSize, int playerCount)
+    : mapWidth(mapSize.width)
+{
+    std::size_t size = tableSize(playerCount);
+    slots.reset(new std::atomic<std::uint64_t>[size]);
+    for (std::size_t slot = 0; slot < size; ++slot) {
+        slots[slot].store(0, std::memory_order_relaxed);
+    }
+    mask = size - 1;
+}
+
+/*!
+ * Losing the race for a free slot just means looking at it again:
+ * it now holds either this tile, found as a tie, or another one to
+ * probe past.
+ */
+auto ConcurrentHeadTable::claim(Point position, int player, std::vector<std::size_t> &used) -> int
+{
+    std::uint64_t key = static_cast<std::uint64_t>(position.y) * mapWidth + position.x + 1;
+    std::uint64_t claim = key << PLAYER_BITS | static_cast<std::uint64_t>(player);
+    std::size_t slot = homeSlot(key, mask);
+    for (;;) {
+        std::uint64_t held = slots[slot].load(std::memory_order_relaxed);
+        if (held == 0) {
+            if (slots[slot].compare_exchange_strong(held, claim, std::memory_order_relaxed)) {
+                used.push_back(slot);
+                return -1;
+            }
+        }
+        if (held >> PLAYER_BITS == key) {
+            return static_cast<int>(held & ((std::uint64_t{1} << PLAYER_BITS) - 1));
+        }
+        if (held != 0) {
+            slot = (slot + 1) & mask;
+        }
+    }
+}
+
+void ConcurrentHeadTable::clear(std::vector<std::size_t> &used)
+{
+    for (std::size_t slot : used) {
+        slots[slot].store(0, std::memory_order_relaxed);
+    }
+    used.clear();
+}
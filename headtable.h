@@ -0,0 +1,81 @@
+#ifndef HEADTABLE_H
+#define HEADTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "geometry.h"
+
+//! Finds players whose heads landed on the same tile this tick.
+/*!
+ * An open-addressed hash table keyed by tile, sized for the player
+ * count rather than the map, so head-on collisions are found in one
+ * pass over the heads no matter how many players or how large the
+ * map. Only the slots used are cleared between ticks.
+ */
+class HeadTable
+{
+public:
+    HeadTable(Size mapSize, int playerCount);
+
+    //! Record that `player`'s head is at `position` (on the map).
+    /*!
+     * \return Index of a player already recorded at `position`,
+     * or -1 if there is none.
+     */
+    auto claim(Point position, int player) -> int;
+    //! Forget every claim.
+    void clear();
+
+private:
+    const int mapWidth;
+    //! Tile index + 1 of each slot's claim, or 0 if free.
+    std::vector<std::uint64_t> keys;
+    //! Player holding each slot.
+    std::vector<int> owners;
+    //! Slots to free in clear().
+    std::vector<std::size_t> used;
+    //! Table size - 1; the size is a power of two.
+    std::size_t mask;
+
+};
+
+//! A HeadTable that several threads can claim in at once.
+/*!
+ * Each slot holds the tile and the player that claimed it in one
+ * word, filled with a single compare-and-swap, so a claim is never
+ * seen half made and no thread ever waits for another. Each thread
+ * keeps its own list of the slots it filled for clear().
+ */
+class ConcurrentHeadTable
+{
+public:
+    ConcurrentHeadTable(Size mapSize, int playerCount);
+
+    //! Record that `player`'s head is at `position` (on the map).
+    /*!
+     * The slot filled, if any, is added to `used`.
+     * \return Index of a player already recorded at `position`,
+     * or -1 if there is none.
+     */
+    auto claim(Point position, int player, std::vector<std::size_t> &used) -> int;
+    //! Forget the claims in `used` and empty it.
+    /*!
+     * Not while anyone is claiming.
+     */
+    void clear(std::vector<std::size_t> &used);
+
+private:
+    //! Bits of a slot holding the player.
+    static const int PLAYER_BITS = 16;
+
+    const int mapWidth;
+    //! (Tile index + 1) << PLAYER_BITS | player, or 0 if free.
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+    std::size_t mask;
+
+};
+
+#endif // HEADTABLE_H
@@ -0,0 +1,79 @@
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "player.h"
+
+//! A direction key press waiting to be applied.
+struct InputEvent
+{
+    Player::Direction direction;
+    //! When the input was made, in steady_clock nanoseconds.
+    std::int64_t timestamp;
+};
+
+//! Bounded queue of one player's inputs.
+/*!
+ * A lock-free ring buffer for exactly one producer thread (the one
+ * reading the keyboard) and one consumer thread (the one running
+ * the simulation). When full, new inputs are dropped rather than
+ * overwriting ones not yet applied.
+ */
+class InputQueue
+{
+public:
+    static const std::size_t CAPACITY = 16;
+
+    //! Add `event` at the back (producer only).
+    /*!
+     * \return Whether there was room for it.
+     */
+    auto push(const InputEvent &event) -> bool;
+    //! Take the event at the front (consumer only).
+    /*!
+     * \return Whether there was one.
+     */
+    auto pop(InputEvent &event) -> bool;
+    //! Discard everything queued (consumer only).
+    void clear();
+
+private:
+    InputEvent events[CAPACITY];
+    //! Next slot to pop; written by the consumer.
+    std::atomic<std::size_t> head{0};
+    //! Next slot to push; written by the producer.
+    std::atomic<std::size_t> tail{0};
+
+};
+
+inline auto InputQueue::push(const InputEvent &event) -> bool
+{
+    std::size_t back = tail.load(std::memory_order_relaxed);
+    if (back - head.load(std::memory_order_acquire) == CAPACITY) {
+        return false;
+    }
+    events[back % CAPACITY] = event;
+    tail.store(back + 1, std::memory_order_release);
+    return true;
+}
+
+inline auto InputQueue::pop(InputEvent &event) -> bool
+{
+    std::size_t front = head.load(std::memory_order_relaxed);
+    if (front == tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    event = events[front % CAPACITY];
+    head.store(front + 1, std::memory_order_release);
+    return true;
+}
+
+inline void InputQueue::clear()
+{
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+#endif // INPUTQUEUE_H
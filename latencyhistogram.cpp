@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "latencyhistogram.h"
+#include "bits.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (std::atomic<std::uint64_t> &bucket : counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(std::int64_t nanoseconds)
+{
+    nanoseconds = std::max<std::int64_t>(nanoseconds, 0);
+    counts[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    // Only one writer, so no compare-and-swap loop is needed
+    if (nanoseconds > max.load(std::memory_order_relaxed)) {
+        max.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+auto LatencyHistogram::getCount() const -> std::uint64_t
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::percentile(double fraction) const -> std::int64_t
+{
+    // Count the buckets themselves, as `count` may be a sample ahead
+    std::uint64_t total = 0;
+    std::uint64_t seen[BUCKET_COUNT];
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen[i] = counts[i].load(std::memory_order_relaxed);
+        total += seen[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    std::uint64_t rank = std::max<std::uint64_t>(
+                1, static_cast<std::uint64_t>(std::ceil(fraction * total)));
+    std::uint64_t below = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        below += seen[i];
+        if (below >= rank) {
+            return std::min(bucketTop(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+auto LatencyHistogram::getMax() const -> std::int64_t
+{
+    return max.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Values below SUB_BUCKETS get a bucket each; above that, the top
+ * bit picks the power of two and the next three bits the part of it.
+ */
+auto LatencyHistogram::bucketOf(std::int64_t nanoseconds) -> int
+{
+    if (nanoseconds < SUB_BUCKETS) {
+        return static_cast<int>(nanoseconds);
+    }
+    int exponent = highestBit(static_cast<std::uint64_t>(nanoseconds));
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    int part = static_cast<int>(nanoseconds >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return (exponent - 2) * SUB_BUCKETS + part;
+}
+
+auto LatencyHistogram::bucketTop(int bucket) -> std::int64_t
+{
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    if (bucket == BUCKET_COUNT - 1) {
+        // Takes everything too big for the rest
+        return std::numeric_limits<std::int64_t>::max();
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    std::int64_t bottom = static_cast<std::int64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return bottom + (std::int64_t{1} << shift) - 1;
+}
@@ -0,0 +1,55 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+//! Counts how long something took, in nanoseconds, for percentiles.
+/*!
+ * Buckets are log-linear: every power of two is split into
+ * SUB_BUCKETS equal parts, so any value is reported to within an
+ * eighth of itself, from nanoseconds to minutes, in a few kilobytes.
+ * Counts are relaxed atomics, so one thread can record while others
+ * read percentiles without locks; a reader may see a record()
+ * half done, which shifts a percentile by at most one sample.
+ */
+class LatencyHistogram
+{
+public:
+    //! Buckets each power of two is split into.
+    static const int SUB_BUCKETS = 8;
+    //! Values from 2^MAX_EXPONENT ns (about 18 minutes) up share the last bucket.
+    static const int MAX_EXPONENT = 40;
+    static const int BUCKET_COUNT = (MAX_EXPONENT - 2) * SUB_BUCKETS;
+
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    auto operator=(const LatencyHistogram&) -> LatencyHistogram& = delete;
+
+    //! Count one sample of `nanoseconds` (one writer at a time).
+    void record(std::int64_t nanoseconds);
+
+    //! Get the number of samples recorded.
+    auto getCount() const -> std::uint64_t;
+    //! Get the smallest value at least `fraction` of samples don't exceed.
+    /*!
+     * Reported as the top of its bucket, but never above getMax();
+     * 0 if nothing has been recorded.
+     */
+    auto percentile(double fraction) const -> std::int64_t;
+    //! Get the largest sample recorded, or 0.
+    auto getMax() const -> std::int64_t;
+
+private:
+    std::atomic<std::uint64_t> counts[BUCKET_COUNT];
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::int64_t> max{0};
+
+    //! Get the bucket `nanoseconds` goes in.
+    static auto bucketOf(std::int64_t nanoseconds) -> int;
+    //! Get the largest value that goes in `bucket`.
+    static auto bucketTop(int bucket) -> std::int64_t;
+
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -1,12 +1,87 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QMessageBox>
+#include <QStringList>
+
+#include <cstdint>
+#include <stdexcept>
 
 #include "tronwidget.h"
 
+namespace {
+
+//! What to do instead of a game with local players and bots.
+struct Options
+{
+    NetConfig network;
+    bool networked{false};
+    //! Server and match to watch, if `match` isn't 0.
+    NetAddress server;
+    std::uint64_t match{0};
+};
+
+//! Read networked play and spectating options from `arguments`.
+/*!
+ * --seat N --peers HOST:PORT,HOST:PORT[,...], plus --latency MS,
+ * --jitter MS and --loss PCT to try the game over a bad network;
+ * or --watch HOST:PORT --match N to watch a tron-server match.
+ */
+void parseOptions(const QStringList &arguments, Options &options)
+{
+    NetConfig &config = options.network;
+    for (int i = 1; i + 1 < arguments.size(); i += 2) {
+        const QString &name = arguments[i];
+        const QString &value = arguments[i + 1];
+        if (name == "--peers") {
+#ifndef TRON_HAVE_SOCKETS
+            throw std::logic_error{"Networked play isn't available on this platform."};
+#endif
+            for (const QString &peer : value.split(',')) {
+                config.peers.push_back(NetAddress::parse(peer.toStdString()));
+            }
+            options.networked = true;
+        } else if (name == "--seat") {
+            config.localSeat = value.toInt();
+        } else if (name == "--latency") {
+            config.conditions.latency = std::chrono::milliseconds{value.toInt()};
+        } else if (name == "--jitter") {
+            config.conditions.jitter = std::chrono::milliseconds{value.toInt()};
+        } else if (name == "--loss") {
+            config.conditions.loss = value.toDouble() / 100.0;
+        } else if (name == "--watch") {
+#ifndef TRON_HAVE_SOCKETS
+            throw std::logic_error{"Spectating isn't available on this platform."};
+#endif
+            options.server = NetAddress::parse(value.toStdString());
+        } else if (name == "--match") {
+            options.match = value.toULongLong();
+        } else {
+            throw std::logic_error{"Unknown option " + name.toStdString() + "."};
+        }
+    }
+    if (options.networked && options.match != 0) {
+        throw std::logic_error{"Can't play and watch at once."};
+    }
+}
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     MainWindow w;
+    try {
+        Options options;
+        parseOptions(a.arguments(), options);
+        if (options.networked) {
+            w.setNetwork(options.network);
+        } else if (options.match != 0) {
+            w.setSpectator(options.server, options.match);
+        }
+    } catch (const std::logic_error &error) {
+        QMessageBox::critical(nullptr, "Tron", error.what());
+        return 1;
+    }
     w.show();
     
     return a.exec();
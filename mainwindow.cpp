@@ -12,28 +12,48 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    ui->playerCountSpinner->setMinimum(Tron::MIN_PLAYER_COUNT);
-    ui->playerCountSpinner->setMaximum(Tron::MAX_PLAYER_COUNT);
+    // Bots take any seats the players leave empty
+    ui->playerCountSpinner->setMinimum(0);
+    ui->playerCountSpinner->setMaximum(TronWidget::MAX_PLAYER_COUNT);
     ui->playerCountSpinner->setValue(Tron::MIN_PLAYER_COUNT);
     ui->playerCountSpinner->setSuffix(" Players");
 
+    ui->botCountSpinner->setMinimum(0);
+    ui->botCountSpinner->setMaximum(TronWidget::MAX_BOT_COUNT);
+    ui->botCountSpinner->setValue(0);
+    ui->botCountSpinner->setSuffix(" Bots");
+
     auto min_size = std::max(Tron::MIN_MAP_HEIGHT, Tron::MIN_MAP_WIDTH);
     auto max_size = std::min(Tron::MAX_MAP_HEIGHT, Tron::MAX_MAP_WIDTH);
+    auto default_size = std::min(Tron::DEFAULT_MAP_HEIGHT, Tron::DEFAULT_MAP_WIDTH);
     const auto INCREMENTS = 3;
     ui->mapSizeSpinner->setMinimum(min_size);
     ui->mapSizeSpinner->setMaximum(max_size);
-    ui->mapSizeSpinner->setValue(max_size);
-    ui->mapSizeSpinner->setSingleStep((max_size - min_size) / INCREMENTS);
+    ui->mapSizeSpinner->setValue(default_size);
+    ui->mapSizeSpinner->setSingleStep((default_size - min_size) / INCREMENTS);
     ui->mapSizeSpinner->setSuffix((" Squares"));
 
+    ui->tickIntervalSpinner->setMinimum(TronWidget::MIN_TICK_INTERVAL);
+    ui->tickIntervalSpinner->setMaximum(TronWidget::MAX_TICK_INTERVAL);
+    ui->tickIntervalSpinner->setValue(TronWidget::DEFAULT_TICK_INTERVAL);
+    ui->tickIntervalSpinner->setSingleStep(10);
+    ui->tickIntervalSpinner->setSuffix(" ms/Tick");
+
     connect(ui->playerCountSpinner, SIGNAL(valueChanged(int)),
             ui->tronWidget, SLOT(setPlayerCount(int)));
+    connect(ui->botCountSpinner, SIGNAL(valueChanged(int)),
+            ui->tronWidget, SLOT(setBotCount(int)));
 
     connect(ui->mapSizeSpinner, SIGNAL(valueChanged(int)),
             ui->tronWidget, SLOT(setMapHeight(int)));
     connect(ui->mapSizeSpinner, SIGNAL(valueChanged(int)),
             ui->tronWidget, SLOT(setMapWidth(int)));
 
+    connect(ui->tickIntervalSpinner, SIGNAL(valueChanged(int)),
+            ui->tronWidget, SLOT(setTickInterval(int)));
+    connect(ui->fastForwardCheckBox, SIGNAL(toggled(bool)),
+            ui->tronWidget, SLOT(setFastForward(bool)));
+
     connect(ui->startGameButton, SIGNAL(clicked()),
             ui->tronWidget, SLOT(start()));
 
@@ -46,10 +66,43 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+/*!
+ * Every peer brings one player and the game can't run ahead of the
+ * others, so the seat and speed-up settings go away.
+ */
+void MainWindow::setNetwork(const NetConfig &config)
+{
+    ui->tronWidget->setNetwork(config);
+    ui->playerCountLabel->hide();
+    ui->playerCountSpinner->hide();
+    ui->botCountLabel->hide();
+    ui->botCountSpinner->hide();
+    ui->fastForwardCheckBox->hide();
+    setWindowTitle(windowTitle() + QString{" - Seat %1"}.arg(config.localSeat + 1));
+}
+
+/*!
+ * The server picks the map and players, so every setting but speed
+ * goes away.
+ */
+void MainWindow::setSpectator(NetAddress server, std::uint64_t match)
+{
+    ui->tronWidget->setSpectator(server, match);
+    ui->playerCountLabel->hide();
+    ui->playerCountSpinner->hide();
+    ui->botCountLabel->hide();
+    ui->botCountSpinner->hide();
+    ui->mapSizeLabel->hide();
+    ui->mapSizeSpinner->hide();
+    ui->fastForwardCheckBox->hide();
+    setWindowTitle(windowTitle() + QString{" - Match %1"}.arg(match));
+}
+
 void MainWindow::tronGameInProgress(bool playing)
 {
     // Update settings control access
     ui->playerCountSpinner->setEnabled(!playing);
+    ui->botCountSpinner->setEnabled(!playing);
     ui->mapSizeSpinner->setEnabled(!playing);
     ui->colorButton_1->setEnabled(!playing);
     ui->colorButton_2->setEnabled(!playing);
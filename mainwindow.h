@@ -16,6 +16,11 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
+    //! Play over the network rather than with local players and bots.
+    void setNetwork(const NetConfig &config);
+    //! Watch a match on a tron-server rather than playing.
+    void setSpectator(NetAddress server, std::uint64_t match);
+
 private:
     void handleColorButton(int);
 
@@ -0,0 +1,57 @@
+#include <random>
+
+#include "match.h"
+#include "matchpool.h"
+#include "tron.h"
+
+namespace {
+
+//! Give each player of `tron` a controller made by `controllers`, seeded from `seed`.
+void seatControllers(Tron &tron, const std::vector<ControllerFactory> &controllers,
+                     std::uint32_t seed)
+{
+    // Give every seat its own seed so one bot's randomness
+    // doesn't depend on how often the others drew.
+    std::mt19937 seeds{seed};
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        tron.setController(i, controllers[i](seeds()));
+    }
+}
+
+} // namespace
+
+auto makeMatch(Size mapSize,
+               const std::vector<ControllerFactory> &controllers,
+               std::uint32_t seed) -> std::unique_ptr<Tron>
+{
+    std::unique_ptr<Tron> tron{new Tron{mapSize, static_cast<int>(controllers.size())}};
+    seatControllers(*tron, controllers, seed);
+    return tron;
+}
+
+auto playMatch(Size mapSize,
+               const std::vector<ControllerFactory> &controllers,
+               std::uint32_t seed,
+               ReplayRecorder *recorder,
+               int stepThreads,
+               MatchPool *pool) -> MatchResult
+{
+    std::unique_ptr<Tron> made;
+    MatchPool::Lease leased;
+    if (pool) {
+        leased = pool->acquire(mapSize, static_cast<int>(controllers.size()));
+        seatControllers(*leased, controllers, seed);
+    } else {
+        made = makeMatch(mapSize, controllers, seed);
+    }
+    Tron &tron = pool ? *leased : *made;
+    tron.setRecorder(recorder);
+    tron.setStepThreads(stepThreads);
+    MatchResult result{-1, 0};
+    do {
+        ++result.ticks;
+    } while (tron.step());
+
+    result.winner = tron.getWinner();
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "geometry.h"
+#include "controller.h"
+
+class MatchPool;
+class ReplayRecorder;
+class Tron;
+
+//! Outcome of one computer-played game.
+struct MatchResult
+{
+    //! Index of the winning player, or -1 for a tie.
+    int winner;
+    //! Number of ticks the game lasted.
+    long ticks;
+};
+
+//! Set up the game playMatch() plays, to step through by hand.
+auto makeMatch(Size mapSize,
+               const std::vector<ControllerFactory> &controllers,
+               std::uint32_t seed) -> std::unique_ptr<Tron>;
+
+//! Play a whole game with every player driven by a controller.
+/*!
+ * Player `i` is controlled by one made with `controllers[i]`. The
+ * same `seed` always produces the same game.
+ * \param recorder Records the game, if given.
+ * \param stepThreads Threads each tick may use; see Tron::setStepThreads().
+ * \param pool Where to get the game from and give it back to, if
+ * given; the game played is the same either way.
+ */
+auto playMatch(Size mapSize,
+               const std::vector<ControllerFactory> &controllers,
+               std::uint32_t seed,
+               ReplayRecorder *recorder = nullptr,
+               int stepThreads = 1,
+               MatchPool *pool = nullptr) -> MatchResult;
+
+#endif // MATCH_H
@@ -0,0 +1,82 @@
+#include "matchpool.h"
+
+void MatchPool::Return::operator()(Tron *tron) const
+{
+    pool->giveBack(tron);
+}
+
+MatchPool::MatchPool(std::size_t turns)
+    : turns(turns)
+{}
+
+void MatchPool::prepare(Size mapSize, int playerCount, int count)
+{
+    Shelf &shelf = shelfFor(mapSize, playerCount);
+    shelf.idle.reserve(count);
+    while (static_cast<int>(shelf.idle.size()) < count) {
+        shelf.idle.push_back(make(mapSize, playerCount));
+    }
+}
+
+auto MatchPool::acquire(Size mapSize, int playerCount) -> Lease
+{
+    Shelf &shelf = shelfFor(mapSize, playerCount);
+    std::unique_ptr<Tron> tron;
+    if (shelf.idle.empty()) {
+        tron = make(mapSize, playerCount);
+    } else {
+        tron = std::move(shelf.idle.back());
+        shelf.idle.pop_back();
+    }
+    return Lease{tron.release(), Return{this}};
+}
+
+auto MatchPool::getIdleCount() const -> int
+{
+    int count = 0;
+    for (const Shelf &shelf : shelves) {
+        count += static_cast<int>(shelf.idle.size());
+    }
+    return count;
+}
+
+/*!
+ * There are only ever a few kinds of match, so a linear search
+ * is quickest.
+ */
+auto MatchPool::shelfFor(Size mapSize, int playerCount) -> Shelf&
+{
+    for (Shelf &shelf : shelves) {
+        if (shelf.mapSize == mapSize && shelf.playerCount == playerCount) {
+            return shelf;
+        }
+    }
+    shelves.push_back(Shelf{mapSize, playerCount, {}});
+    return shelves.back();
+}
+
+auto MatchPool::make(Size mapSize, int playerCount) const -> std::unique_ptr<Tron>
+{
+    std::unique_ptr<Tron> tron{new Tron{mapSize, playerCount}};
+    tron->reserve(turns);
+    return tron;
+}
+
+/*!
+ * Controllers are dropped here rather than on reuse, so nothing
+ * they hold outlives the match.
+ */
+void MatchPool::giveBack(Tron *tron)
+{
+    std::unique_ptr<Tron> kept{tron};
+    for (int i = 0; i < tron->getPlayerCount(); ++i) {
+        tron->setController(i, nullptr);
+    }
+    tron->setRecorder(nullptr);
+    tron->setProfiler(nullptr);
+    tron->reset();
+    shelfFor(tron->getMapSize(), tron->getPlayerCount()).idle.push_back(std::move(kept));
+}
+
+// Constants
+const std::size_t MatchPool::DEFAULT_TURNS{64};
@@ -0,0 +1,78 @@
+#ifndef MATCHPOOL_H
+#define MATCHPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "geometry.h"
+#include "tron.h"
+
+//! Keeps finished games to hand out again, for playing many matches in a row.
+/*!
+ * A game given back is reset in place and kept, with its storage,
+ * until a match of the same map size and player count is wanted.
+ * Every game the pool makes reserves room up front (see
+ * Tron::reserve()), so once the pool holds as many games as are
+ * played at once, starting, playing and ending matches no longer
+ * allocates. Not safe to share between threads; give each thread
+ * its own pool.
+ */
+class MatchPool
+{
+public:
+    //! Gives a game back to the pool it came from.
+    struct Return
+    {
+        MatchPool *pool;
+
+        void operator()(Tron *tron) const;
+    };
+    //! A game on loan from a pool, given back when the lease ends.
+    /*!
+     * Must end before the pool is destroyed.
+     */
+    typedef std::unique_ptr<Tron, Return> Lease;
+
+    //! Turns per player reserved by default.
+    static const std::size_t DEFAULT_TURNS;
+
+    //! Make games with room for `turns` turns per player.
+    explicit MatchPool(std::size_t turns = DEFAULT_TURNS);
+    MatchPool(const MatchPool&) = delete;
+    auto operator=(const MatchPool&) -> MatchPool& = delete;
+
+    //! Have at least `count` games of this kind ready before they are needed.
+    void prepare(Size mapSize, int playerCount, int count);
+    //! Get a game that hasn't started, reusing one if there is one.
+    /*!
+     * A reused game has no controllers, recorder or profiler, and
+     * keeps the step threads and rewind limit it was given back
+     * with.
+     */
+    auto acquire(Size mapSize, int playerCount) -> Lease;
+    //! Get the number of games waiting to be handed out.
+    auto getIdleCount() const -> int;
+
+private:
+    //! Games of one map size and player count.
+    struct Shelf
+    {
+        Size mapSize;
+        int playerCount;
+        std::vector<std::unique_ptr<Tron>> idle;
+    };
+
+    const std::size_t turns;
+    std::vector<Shelf> shelves;
+
+    //! Get the shelf of games of this kind, adding it if need be.
+    auto shelfFor(Size mapSize, int playerCount) -> Shelf&;
+    //! Make a new game of this kind, with its storage reserved.
+    auto make(Size mapSize, int playerCount) const -> std::unique_ptr<Tron>;
+    //! Reset `tron` and keep it for later.
+    void giveBack(Tron *tron);
+
+};
+
+#endif // MATCHPOOL_H
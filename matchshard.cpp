@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "matchshard.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+//! Most ticks to play back to back to catch up after falling behind.
+const int MAX_CATCH_UP = 5;
+
+//! Pin the calling thread to `core`, if the platform allows it.
+void pinToCore(int core)
+{
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    // Not being pinned only costs cache misses, so failure is ignored
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(cores), &cores);
+#else
+    static_cast<void>(core);
+#endif
+}
+
+} // namespace
+
+MatchShard::MatchShard(std::chrono::milliseconds tickInterval, ControllerFactory bot,
+                       std::function<void()> notify)
+    : tickInterval(tickInterval)
+    , bot(bot)
+    , notify(std::move(notify))
+{
+    if (tickInterval.count() <= 0) {
+        throw std::logic_error{"Bad tick interval."};
+    }
+    if (!bot) {
+        throw std::logic_error{"Need a bot controller."};
+    }
+}
+
+MatchShard::~MatchShard()
+{
+    stop();
+}
+
+void MatchShard::hostBotMatches(const std::vector<std::uint64_t> &ids, Size mapSize,
+                                int playerCount)
+{
+    if (running) {
+        throw std::logic_error{"Shard already started."};
+    }
+    std::vector<std::uint64_t> bots(static_cast<std::size_t>(playerCount), 0);
+    pool.prepare(mapSize, playerCount, static_cast<int>(ids.size()));
+    for (std::uint64_t id : ids) {
+        create(id, mapSize, bots, true);
+    }
+}
+
+void MatchShard::start(int core)
+{
+    if (running) {
+        throw std::logic_error{"Shard already started."};
+    }
+    running = true;
+    thread = std::thread{[this, core] {
+        if (core >= 0) {
+            pinToCore(core);
+        }
+        run();
+    }};
+}
+
+void MatchShard::stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void MatchShard::post(Command command)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    inbox.push_back(std::move(command));
+}
+
+void MatchShard::collect(std::vector<Message> &messages)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    if (messages.empty()) {
+        messages.swap(outbox);
+    } else {
+        std::move(outbox.begin(), outbox.end(), std::back_inserter(messages));
+        outbox.clear();
+    }
+}
+
+/*!
+ * Ticks are kept to a fixed schedule; a shard that falls behind
+ * plays a few ticks back to back rather than slowing every match
+ * down, and gives up on catching up if it is hopelessly late.
+ */
+void MatchShard::run()
+{
+    std::vector<Command> commands;
+    std::vector<Message> messages;
+    Clock::time_point next = Clock::now();
+    while (running) {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            commands.swap(inbox);
+        }
+        handle(commands, messages);
+        commands.clear();
+        tick(messages);
+
+        if (!messages.empty()) {
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                std::move(messages.begin(), messages.end(), std::back_inserter(outbox));
+            }
+            messages.clear();
+            notify();
+        }
+
+        next += tickInterval;
+        Clock::time_point now = Clock::now();
+        if (now - next > MAX_CATCH_UP * tickInterval) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void MatchShard::handle(std::vector<Command> &commands, std::vector<Message> &messages)
+{
+    for (Command &command : commands) {
+        if (command.kind == Command::Kind::Create) {
+            create(command.match, command.mapSize, command.clients, false);
+            const Hosted &match = matches.back();
+            for (std::size_t seat = 0; seat < match.clients.size(); ++seat) {
+                if (match.clients[seat] == 0) {
+                    continue;
+                }
+                Size mapSize = match.tron->getMapSize();
+                std::string text = "START " + std::to_string(seat)
+                        + " " + std::to_string(match.clients.size())
+                        + " " + std::to_string(mapSize.width)
+                        + " " + std::to_string(mapSize.height)
+                        + " " + std::to_string(match.id) + "\n";
+                messages.push_back(Message{match.clients[seat],
+                                           std::make_shared<const std::string>(std::move(text)),
+                                           false});
+            }
+            continue;
+        }
+        // The match may have ended since the command was posted
+        auto found = matchIndex.find(command.match);
+        if (found == matchIndex.end()) {
+            if (command.kind == Command::Kind::Watch) {
+                messages.push_back(Message{command.clients.front(),
+                                           std::make_shared<const std::string>(
+                                               "ERROR No such match.\n"),
+                                           true});
+            }
+            continue;
+        }
+        Hosted &match = matches[found->second];
+        if (command.kind == Command::Kind::Watch) {
+            watch(match, command.clients.front(), messages);
+            continue;
+        }
+        if (command.kind == Command::Kind::Unwatch) {
+            match.viewers.erase(std::remove(match.viewers.begin(), match.viewers.end(),
+                                            command.clients.front()),
+                                match.viewers.end());
+            if (match.viewers.empty()) {
+                match.feed.reset();
+            }
+            continue;
+        }
+        if (command.seat < 0 || command.seat >= static_cast<int>(match.clients.size())
+                || match.clients[command.seat] == 0) {
+            continue;
+        }
+        if (command.kind == Command::Kind::Turn) {
+            match.tron->queueTurn(command.seat, command.direction, 0);
+        } else {
+            giveToBot(match, command.seat);
+        }
+    }
+}
+
+/*!
+ * Every client of a match gets the same line per tick, so it is
+ * formatted once and shared.
+ */
+void MatchShard::tick(std::vector<Message> &messages)
+{
+    long ticks = 0;
+    for (std::size_t i = 0; i < matches.size();) {
+        Hosted &match = matches[i];
+        Tron &tron = *match.tron;
+        int before = tron.getTick();
+        tron.step();
+        if (tron.getTick() == before) {
+            ++i;
+            continue;
+        }
+        ++ticks;
+        bool played = std::find_if(match.clients.begin(), match.clients.end(),
+                                    [](std::uint64_t client) { return client != 0; })
+                != match.clients.end();
+        if (played) {
+            std::string text = "TICK " + std::to_string(tron.getTick());
+            for (int player = 0; player < tron.getPlayerCount(); ++player) {
+                if (tron.getIsPlaying(player)) {
+                    Point position = tron.getPosition(player);
+                    text += " " + std::to_string(position.x) + "," + std::to_string(position.y);
+                } else {
+                    text += " -";
+                }
+            }
+            tell(match, text + "\n", false, messages);
+        }
+        if (match.feed) {
+            SpectatorFrame frame = match.feed->update(tron);
+            for (std::uint64_t viewer : match.viewers) {
+                messages.push_back(Message{viewer, frame, tron.gameIsOver()});
+            }
+        }
+        if (!tron.gameIsOver()) {
+            ++i;
+            continue;
+        }
+        if (played) {
+            tell(match, "OVER " + std::to_string(tron.getWinner()) + "\n", true, messages);
+        }
+        if (match.restart) {
+            std::uint64_t id = match.id;
+            Size mapSize = tron.getMapSize();
+            std::vector<std::uint64_t> clients = match.clients;
+            remove(i);
+            create(id, mapSize, clients, true);
+            // The new game is last and so gets its first tick this time round
+        } else {
+            remove(i);
+        }
+    }
+    tickCount += ticks;
+}
+
+void MatchShard::create(std::uint64_t id, Size mapSize, const std::vector<std::uint64_t> &clients,
+                        bool restart)
+{
+    MatchPool::Lease tron = pool.acquire(mapSize, static_cast<int>(clients.size()));
+    for (std::size_t seat = 0; seat < clients.size(); ++seat) {
+        if (clients[seat] == 0) {
+            tron->setController(static_cast<int>(seat), bot(nextSeed++));
+        }
+    }
+    matchIndex[id] = matches.size();
+    matches.push_back(Hosted{id, std::move(tron), clients, restart, nullptr, {}});
+    matchCount = static_cast<int>(matches.size());
+}
+
+void MatchShard::remove(std::size_t index)
+{
+    matchIndex.erase(matches[index].id);
+    if (index + 1 != matches.size()) {
+        matches[index] = std::move(matches.back());
+        matchIndex[matches[index].id] = index;
+    }
+    matches.pop_back();
+    matchCount = static_cast<int>(matches.size());
+}
+
+/*!
+ * The seat is played on rather than left idle: a player that
+ * never picked a first direction would hold up the game for good.
+ */
+void MatchShard::giveToBot(Hosted &match, int seat)
+{
+    match.clients[seat] = 0;
+    match.tron->setController(seat, bot(nextSeed++));
+}
+
+/*!
+ * A feed is only kept for matches with viewers, and only has to
+ * be started for the first one; later ones catch up from it.
+ */
+void MatchShard::watch(Hosted &match, std::uint64_t viewer, std::vector<Message> &messages)
+{
+    if (!match.feed) {
+        match.feed.reset(new SpectatorFeed);
+        match.feed->update(*match.tron);
+    }
+    messages.push_back(Message{viewer, std::make_shared<const std::string>("WATCHING\n"), false});
+    std::vector<SpectatorFrame> frames;
+    match.feed->catchUp(frames);
+    for (SpectatorFrame &frame : frames) {
+        messages.push_back(Message{viewer, std::move(frame), false});
+    }
+    match.viewers.push_back(viewer);
+}
+
+void MatchShard::tell(const Hosted &match, const std::string &text, bool last,
+                      std::vector<Message> &messages)
+{
+    std::shared_ptr<const std::string> shared = std::make_shared<const std::string>(text);
+    for (std::uint64_t client : match.clients) {
+        if (client != 0) {
+            messages.push_back(Message{client, shared, last});
+        }
+    }
+}
+
+auto MatchShard::getMatchCount() const -> int
+{
+    return matchCount;
+}
+
+auto MatchShard::getTickCount() const -> long
+{
+    return tickCount;
+}
@@ -0,0 +1,153 @@
+#ifndef MATCHSHARD_H
+#define MATCHSHARD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "controller.h"
+#include "matchpool.h"
+#include "spectatorfeed.h"
+#include "tron.h"
+
+//! Many matches advanced together by one thread, for a server.
+/*!
+ * Every tick the shard's thread takes all commands posted since the
+ * last one, steps each of its matches once and hands the messages
+ * for connected clients back in one batch. Commands and messages
+ * cross threads under a mutex held only to swap a vector, so the
+ * cost is per tick, not per match or per message.
+ *
+ * Matches with spectators also keep a SpectatorFeed; each tick's
+ * frame is encoded once and the same buffer is queued for every
+ * viewer. Games come from a MatchPool, so matches that end are
+ * reset and reused rather than freed and allocated again.
+ */
+class MatchShard
+{
+public:
+    //! Something for the shard to do, posted from another thread.
+    struct Command
+    {
+        enum class Kind {Create, Turn, Leave, Watch, Unwatch};
+
+        Kind kind;
+        std::uint64_t match;
+        //! Seat turning or leaving.
+        int seat;
+        Player::Direction direction;
+        //! Map of a match to create.
+        Size mapSize;
+        //! Client in each seat of a match to create, 0 for bots, or
+        //! the one viewer starting or stopping watching.
+        std::vector<std::uint64_t> clients;
+    };
+
+    //! Text or spectator frames for a client.
+    struct Message
+    {
+        std::uint64_t client;
+        //! Shared by every client of a match that gets the same bytes.
+        std::shared_ptr<const std::string> text;
+        //! Whether the client's match is over after this.
+        bool last;
+    };
+
+    //! Create a shard ticking every `tickInterval`.
+    /*!
+     * \param bot Makes the controllers of bot seats, and of seats
+     * whose client left.
+     * \param notify Called on the shard's thread when messages are
+     * ready to collect().
+     */
+    MatchShard(std::chrono::milliseconds tickInterval, ControllerFactory bot,
+               std::function<void()> notify);
+    ~MatchShard();
+    MatchShard(const MatchShard&) = delete;
+    auto operator=(const MatchShard&) -> MatchShard& = delete;
+
+    //! Keep a match of bots going under each id, for load testing (before start() only).
+    void hostBotMatches(const std::vector<std::uint64_t> &ids, Size mapSize, int playerCount);
+    //! Start ticking on a thread pinned to `core`, or unpinned if negative.
+    void start(int core);
+    //! Stop ticking and wait for the thread to finish.
+    void stop();
+
+    //! Queue `command` for the next tick (any thread).
+    void post(Command command);
+    //! Move every message produced so far to the end of `messages`.
+    void collect(std::vector<Message> &messages);
+
+    //! Get the number of matches being played (any thread).
+    auto getMatchCount() const -> int;
+    //! Get the number of match ticks played so far (any thread).
+    auto getTickCount() const -> long;
+
+private:
+    //! One match and who is playing it.
+    struct Hosted
+    {
+        std::uint64_t id;
+        MatchPool::Lease tron;
+        //! Client in each seat, 0 for bots.
+        std::vector<std::uint64_t> clients;
+        //! Whether to start a new game when this one ends.
+        bool restart;
+        //! Encodes the game for `viewers`, once there are any.
+        std::unique_ptr<SpectatorFeed> feed;
+        std::vector<std::uint64_t> viewers;
+    };
+
+    const std::chrono::milliseconds tickInterval;
+    const ControllerFactory bot;
+    const std::function<void()> notify;
+
+    // Only touched by the shard's thread
+    //! Where games come from; outlives `matches`.
+    MatchPool pool;
+    std::vector<Hosted> matches;
+    //! Index into `matches` of each match id.
+    std::unordered_map<std::uint64_t, std::size_t> matchIndex;
+    //! Seed for the next bot made.
+    std::uint32_t nextSeed{1};
+
+    std::mutex mutex;
+    //! Commands posted and not yet taken (guarded by `mutex`).
+    std::vector<Command> inbox;
+    //! Messages produced and not yet collected (guarded by `mutex`).
+    std::vector<Message> outbox;
+
+    std::atomic<int> matchCount{0};
+    std::atomic<long> tickCount{0};
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    //! Shard thread body.
+    void run();
+    //! Apply the commands posted since the last tick.
+    void handle(std::vector<Command> &commands, std::vector<Message> &messages);
+    //! Step every match once, reporting to clients in `messages`.
+    void tick(std::vector<Message> &messages);
+    //! Start a match with `clients` in its seats.
+    void create(std::uint64_t id, Size mapSize, const std::vector<std::uint64_t> &clients,
+                bool restart);
+    //! Drop match `index`, moving the last match into its place.
+    void remove(std::size_t index);
+    //! Hand seat `seat` of `match` to a bot.
+    void giveToBot(Hosted &match, int seat);
+    //! Start sending `match` to `viewer`, from a snapshot.
+    void watch(Hosted &match, std::uint64_t viewer, std::vector<Message> &messages);
+    //! Queue `text` for every client of `match`.
+    static void tell(const Hosted &match, const std::string &text, bool last,
+                     std::vector<Message> &messages);
+
+};
+
+#endif // MATCHSHARD_H
@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "minimaxbot.h"
+#include "zobrist.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+typedef std::chrono::steady_clock Clock;
+
+const int INFINITE_SCORE = 1 << 30;
+//! Score of a won game, less a point per ply so quicker wins score higher.
+const int WIN_SCORE = 1 << 20;
+//! Deepest a search can go, in plies.
+const int MAX_PLY = 1024;
+//! Nodes between looks at the clock.
+const long CLOCK_INTERVAL = 1024;
+//! Zobrist feature tag for "our move is chosen, the rival's isn't".
+const std::uint64_t REPLY_TAG = std::uint64_t{4} << 56;
+
+//! One thread's search of a duel.
+class Search
+{
+public:
+    Search(const Tron &tron, int player, int rival, TranspositionTable &table,
+           std::atomic<bool> &stopping, Clock::time_point deadline)
+        : tron(tron)
+        , player(player)
+        , rival(rival)
+        , table(table)
+        , stopping(stopping)
+        , deadline(deadline)
+        , window(MinimaxBot::EVALUATION_RADIUS)
+        , moves(tron.getPlayerCount(), Direction::None)
+    {}
+
+    //! Search every move `depth` ticks deep.
+    /*!
+     * \return Whether the search finished before being stopped.
+     */
+    auto searchRoot(int depth, Direction &best, int &bestScore) -> bool;
+
+    long nodes{0};
+
+private:
+    Tron tron;
+    const int player;
+    const int rival;
+    TranspositionTable &table;
+    std::atomic<bool> &stopping;
+    //! When to stop, or the epoch for no limit.
+    const Clock::time_point deadline;
+    SearchWindow window;
+    //! Directions handed to Tron::makeMove().
+    std::vector<Direction> moves;
+
+    //! Value of the position with our move to choose.
+    auto value(int depth, int alpha, int beta, int ply) -> int;
+    //! Value of the position once we have chosen `ours`.
+    auto reply(int depth, int alpha, int beta, int ply, Direction ours) -> int;
+    //! Score the position from our point of view.
+    auto evaluate() -> int;
+    //! Fill `options` with `who`'s moves, most promising first.
+    auto orderMoves(int who, Direction hint, Direction options[4]) const -> int;
+    //! Count a node and check if the search should give up.
+    auto shouldStop() -> bool;
+
+};
+
+//! Make mate scores relative to the node they are stored at.
+auto toTable(int score, int ply) -> int
+{
+    if (score > WIN_SCORE - MAX_PLY) {
+        return score + ply;
+    } else if (score < -WIN_SCORE + MAX_PLY) {
+        return score - ply;
+    }
+    return score;
+}
+
+//! Undo toTable() for the node at `ply`.
+auto fromTable(int score, int ply) -> int
+{
+    if (score > WIN_SCORE - MAX_PLY) {
+        return score - ply;
+    } else if (score < -WIN_SCORE + MAX_PLY) {
+        return score + ply;
+    }
+    return score;
+}
+
+//! Narrow [alpha, beta] with a stored entry.
+/*!
+ * \return Whether the entry settles the node's value by itself.
+ */
+auto useEntry(const TranspositionTable::Entry &entry, int depth, int ply,
+              int &alpha, int &beta, int &score) -> bool
+{
+    if (entry.depth < depth) {
+        return false;
+    }
+    score = fromTable(entry.score, ply);
+    if (entry.bound == TranspositionTable::Bound::Exact) {
+        return true;
+    } else if (entry.bound == TranspositionTable::Bound::Lower) {
+        alpha = std::max(alpha, score);
+    } else if (entry.bound == TranspositionTable::Bound::Upper) {
+        beta = std::min(beta, score);
+    }
+    return alpha >= beta;
+}
+
+auto boundOf(int score, int alpha, int beta) -> TranspositionTable::Bound
+{
+    if (score <= alpha) {
+        return TranspositionTable::Bound::Upper;
+    } else if (score >= beta) {
+        return TranspositionTable::Bound::Lower;
+    }
+    return TranspositionTable::Bound::Exact;
+}
+
+auto Search::shouldStop() -> bool
+{
+    if (++nodes % CLOCK_INTERVAL == 0
+            && deadline != Clock::time_point{} && Clock::now() >= deadline) {
+        stopping.store(true, std::memory_order_relaxed);
+    }
+    return stopping.load(std::memory_order_relaxed);
+}
+
+/*!
+ * Moves that don't crash straight away come first, after the best
+ * move from the table; reversing is never an option.
+ */
+auto Search::orderMoves(int who, Direction hint, Direction options[4]) const -> int
+{
+    static const Direction DIRECTIONS[] = {
+        Direction::Up, Direction::Down, Direction::Left, Direction::Right
+    };
+    Direction current = tron.getDirection(who);
+    Point head = tron.getPosition(who);
+    int count = 0;
+    int safe = 0;
+    for (Direction direction : DIRECTIONS) {
+        if (direction == Player::opposite(current)) {
+            continue;
+        }
+        options[count] = direction;
+        if (!tron.isBlocked(Player::advance(head, direction))) {
+            std::swap(options[count], options[safe++]);
+        }
+        ++count;
+    }
+    Direction *found = std::find(options, options + count, hint);
+    if (found != options + count) {
+        std::rotate(options, found, found + 1);
+    }
+    return count;
+}
+
+auto Search::searchRoot(int depth, Direction &best, int &bestScore) -> bool
+{
+    TranspositionTable::Entry entry;
+    Direction hint = table.probe(tron.getHash(), entry) ? entry.move : Direction::None;
+    Direction options[4];
+    int count = orderMoves(player, hint, options);
+    int alpha = -INFINITE_SCORE;
+    Direction found = options[0];
+    for (int i = 0; i < count; ++i) {
+        int score = reply(depth, alpha, INFINITE_SCORE, 0, options[i]);
+        if (stopping.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (score > alpha) {
+            alpha = score;
+            found = options[i];
+        }
+    }
+    table.store(tron.getHash(), TranspositionTable::Entry{
+                    toTable(alpha, 0), depth, TranspositionTable::Bound::Exact, found});
+    best = found;
+    bestScore = alpha;
+    return true;
+}
+
+auto Search::value(int depth, int alpha, int beta, int ply) -> int
+{
+    if (shouldStop()) {
+        return 0;
+    }
+    if (tron.gameIsOver()) {
+        int winner = tron.getWinner();
+        return winner == player ? WIN_SCORE - ply : winner < 0 ? 0 : -WIN_SCORE + ply;
+    }
+    if (depth == 0) {
+        return evaluate();
+    }
+
+    std::uint64_t key = tron.getHash();
+    int originalAlpha = alpha;
+    int originalBeta = beta;
+    TranspositionTable::Entry entry;
+    Direction hint = Direction::None;
+    if (table.probe(key, entry)) {
+        int score;
+        if (useEntry(entry, depth, ply, alpha, beta, score)) {
+            return score;
+        }
+        hint = entry.move;
+    }
+
+    Direction options[4];
+    int count = orderMoves(player, hint, options);
+    int best = -INFINITE_SCORE;
+    Direction bestMove = options[0];
+    for (int i = 0; i < count && alpha < beta; ++i) {
+        int score = reply(depth, alpha, beta, ply, options[i]);
+        if (score > best) {
+            best = score;
+            bestMove = options[i];
+        }
+        alpha = std::max(alpha, score);
+    }
+    if (!stopping.load(std::memory_order_relaxed)) {
+        table.store(key, TranspositionTable::Entry{
+                        toTable(best, ply), depth, boundOf(best, originalAlpha, originalBeta), bestMove});
+    }
+    return best;
+}
+
+auto Search::reply(int depth, int alpha, int beta, int ply, Direction ours) -> int
+{
+    std::uint64_t key = tron.getHash() ^ zobristKey(REPLY_TAG | static_cast<std::uint64_t>(ours));
+    int originalAlpha = alpha;
+    int originalBeta = beta;
+    TranspositionTable::Entry entry;
+    Direction hint = Direction::None;
+    if (table.probe(key, entry)) {
+        int score;
+        if (useEntry(entry, depth, ply, alpha, beta, score)) {
+            return score;
+        }
+        hint = entry.move;
+    }
+
+    Direction options[4];
+    int count = orderMoves(rival, hint, options);
+    int best = INFINITE_SCORE;
+    Direction bestMove = options[0];
+    for (int i = 0; i < count && alpha < beta; ++i) {
+        // Deeper plies reuse `moves`, so set both every time
+        moves[player] = ours;
+        moves[rival] = options[i];
+        tron.makeMove(moves);
+        int score = value(depth - 1, alpha, beta, ply + 1);
+        tron.unmakeMove();
+        if (score < best) {
+            best = score;
+            bestMove = options[i];
+        }
+        beta = std::min(beta, score);
+    }
+    if (!stopping.load(std::memory_order_relaxed)) {
+        table.store(key, TranspositionTable::Entry{
+                        toTable(best, ply), depth, boundOf(best, originalAlpha, originalBeta), bestMove});
+    }
+    return best;
+}
+
+/*!
+ * With both heads in one window, a single search settles who gets
+ * where first. Further apart they can't contest anything the
+ * window would see, so each just counts its own room.
+ */
+auto Search::evaluate() -> int
+{
+    Point ours = tron.getPosition(player);
+    Point theirs = tron.getPosition(rival);
+    const int reach = 2 * MinimaxBot::EVALUATION_RADIUS;
+    if (std::abs(ours.x - theirs.x) <= reach && std::abs(ours.y - theirs.y) <= reach) {
+        window.load(tron, Point{(ours.x + theirs.x) / 2, (ours.y + theirs.y) / 2});
+        return window.balance(ours, theirs);
+    }
+    window.load(tron, ours);
+    int room = window.balance(ours, theirs);
+    window.load(tron, theirs);
+    return room - window.balance(theirs, ours);
+}
+
+} // namespace
+
+MinimaxBot::MinimaxBot(int depth, int threadCount, std::chrono::milliseconds budget)
+    : depth(std::max(1, std::min(depth, MAX_PLY / 2 - 1)))
+    , threadCount(std::max(1, threadCount))
+    , budget(budget)
+{}
+
+auto MinimaxBot::decide(const Tron &tron, int player) -> Player::Direction
+{
+    if (tron.getPlayingCount() != 2) {
+        return fallback.decide(tron, player);
+    }
+    int rival = 0;
+    while (rival == player || !tron.getIsPlaying(rival)) {
+        ++rival;
+    }
+
+    Clock::time_point deadline{};
+    if (budget > std::chrono::milliseconds::zero()) {
+        deadline = Clock::now() + budget;
+    }
+    stopping.store(false);
+
+    // Helpers start a tick deeper every other thread, so they get
+    // ahead of the main search and fill the table for it.
+    std::vector<std::unique_ptr<Search>> helpers;
+    std::vector<std::thread> threads;
+    for (int t = 1; t < threadCount; ++t) {
+        helpers.emplace_back(new Search{tron, player, rival, table, stopping, deadline});
+    }
+    for (int t = 1; t < threadCount; ++t) {
+        Search *helper = helpers[t - 1].get();
+        int start = 1 + t % 2;
+        threads.emplace_back([this, helper, start]() {
+            Direction move;
+            int score;
+            for (int d = start; d <= depth && helper->searchRoot(d, move, score); ++d) {}
+        });
+    }
+
+    Search search{tron, player, rival, table, stopping, deadline};
+    Direction best = Direction::None;
+    for (int d = 1; d <= depth; ++d) {
+        Direction move;
+        int score;
+        if (!search.searchRoot(d, move, score)) {
+            break;
+        }
+        best = move;
+        if (std::abs(score) > WIN_SCORE - MAX_PLY) {
+            // The outcome is settled; deeper won't change it
+            break;
+        }
+    }
+    stopping.store(true);
+    nodeCount = search.nodes;
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+        nodeCount += helpers[t]->nodes;
+    }
+    if (best == Direction::None) {
+        // Out of time before the first pass finished
+        return fallback.decide(tron, player);
+    }
+    return best;
+}
+
+auto MinimaxBot::getNodeCount() const -> long
+{
+    return nodeCount;
+}
+
+// Constants
+const int MinimaxBot::DEFAULT_DEPTH{6};
+const int MinimaxBot::EVALUATION_RADIUS{12};
@@ -0,0 +1,59 @@
+#ifndef MINIMAXBOT_H
+#define MINIMAXBOT_H
+
+#include <atomic>
+#include <chrono>
+
+#include "bots.h"
+#include "transpositiontable.h"
+
+//! Searches duels move by move with alpha-beta minimax.
+/*!
+ * Each tick is searched as our move followed by the rival's reply,
+ * so the rival is assumed to react to whatever we do. Iterative
+ * deepening searches one tick deeper at a time, leaving best moves
+ * in the transposition table to order the next, deeper pass.
+ * Leaves are scored by Voronoi balance: tiles we reach first less
+ * tiles the rival reaches first.
+ *
+ * Helper threads search the same position alongside the main one,
+ * sharing only the table, so whatever one thread learns cuts the
+ * others' work. With more than two players in play the bot falls
+ * back to a VoronoiBot.
+ */
+class MinimaxBot : public Controller
+{
+public:
+    //! Default search depth, in ticks.
+    static const int DEFAULT_DEPTH;
+    //! Radius of the window leaves are scored in.
+    static const int EVALUATION_RADIUS;
+
+    //! Create a bot searching `depth` ticks ahead.
+    /*!
+     * \param threadCount searching threads, including the caller's.
+     * \param budget time to stop deepening after, or zero to always
+     * reach `depth`; with one thread and no budget, decisions are
+     * reproducible.
+     */
+    explicit MinimaxBot(int depth = DEFAULT_DEPTH, int threadCount = 1,
+                        std::chrono::milliseconds budget = std::chrono::milliseconds::zero());
+
+    auto decide(const Tron &tron, int player) -> Player::Direction override;
+
+    //! Get the number of positions visited by the last decision.
+    auto getNodeCount() const -> long;
+
+private:
+    const int depth;
+    const int threadCount;
+    const std::chrono::milliseconds budget;
+    TranspositionTable table;
+    VoronoiBot fallback;
+    //! Tells every searching thread to give up.
+    std::atomic<bool> stopping{false};
+    long nodeCount{0};
+
+};
+
+#endif // MINIMAXBOT_H
@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "controller.h"
+#include "rollbacksession.h"
+#include "tron.h"
+
+namespace {
+
+struct Options
+{
+    NetConfig net;
+    Size mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
+    int tickInterval = 80;
+    ControllerFactory controller = findController("voronoi");
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " --seat N --peers HOST:PORT,HOST:PORT[,...] [options]\n"
+              << "  --seat N      seat played here, indexing --peers\n"
+              << "  --peers LIST  address of every peer in seat order, the same for all\n"
+              << "  --width W     map width in tiles\n"
+              << "  --height H    map height in tiles\n"
+              << "  --tick MS     milliseconds per tick (default 80)\n"
+              << "  --latency MS  delay added to every datagram sent\n"
+              << "  --jitter MS   up to this much more delay, at random\n"
+              << "  --loss PCT    percentage of datagrams to drop\n"
+              << "  --timeout MS  give up on a peer unheard for this long (default 5000)\n"
+              << "  --bot NAME    controller of the local seat (default voronoi):";
+    for (const NamedController &controller : builtinControllers()) {
+        std::cerr << " " << controller.name;
+    }
+    std::cerr << "\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--peers") == 0) {
+            std::istringstream list{argv[i + 1]};
+            std::string peer;
+            while (std::getline(list, peer, ',')) {
+                options.net.peers.push_back(NetAddress::parse(peer));
+            }
+        } else if (std::strcmp(argv[i], "--bot") == 0) {
+            options.controller = findController(argv[i + 1]);
+            if (!options.controller) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--seat") == 0) {
+            options.net.localSeat = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--width") == 0) {
+            options.mapSize.width = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--height") == 0) {
+            options.mapSize.height = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--tick") == 0) {
+            options.tickInterval = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--latency") == 0) {
+            options.net.conditions.latency = std::chrono::milliseconds{value};
+        } else if (std::strcmp(argv[i], "--jitter") == 0) {
+            options.net.conditions.jitter = std::chrono::milliseconds{value};
+        } else if (std::strcmp(argv[i], "--timeout") == 0) {
+            options.net.silenceTimeout = std::chrono::milliseconds{value};
+        } else if (std::strcmp(argv[i], "--loss") == 0) {
+            options.net.conditions.loss = std::strtod(argv[i + 1], nullptr) / 100.0;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options.net.peers.size() >= 2 && options.tickInterval > 0;
+}
+
+} // namespace
+
+//! Plays one seat of a networked game with a bot, for testing netcode.
+/*!
+ * Start one instance per seat, on one machine or several; when the
+ * game ends every instance should print the same hash.
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        Tron tron{options.mapSize, static_cast<int>(options.net.peers.size())};
+        RollbackSession session{tron, options.net};
+        std::unique_ptr<Controller> bot = options.controller(
+                    static_cast<std::uint32_t>(options.net.localSeat) + 1);
+
+        typedef std::chrono::steady_clock Clock;
+        Clock::duration interval = std::chrono::milliseconds{options.tickInterval};
+        Clock::time_point next = Clock::now();
+        for (;;) {
+            if (session.isStarted() && tron.getIsPlaying(options.net.localSeat)) {
+                session.queueTurn(bot->decide(tron, options.net.localSeat));
+            }
+            if (!session.update()) {
+                break;
+            }
+            next += interval;
+            std::this_thread::sleep_until(next);
+        }
+
+        if (session.getLostSeat() >= 0) {
+            std::cerr << "Lost seat " << session.getLostSeat() << " at tick "
+                      << tron.getTick() << ": nothing heard from it for too long." << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << "ticks:     " << tron.getTick() << "\n"
+                  << "winner:    " << tron.getWinner() << "\n"
+                  << "hash:      " << std::hex << tron.getHash() << std::dec << "\n"
+                  << "rollbacks: " << session.getRollbackCount() << "\n"
+                  << "replayed:  " << session.getReplayedTicks() << "\n"
+                  << "waits:     " << session.getWaitCount() << std::endl;
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Plays one seat of a networked game with a bot,
+# to test netcode between instances.
+#
+#-------------------------------------------------
+
+CONFIG -= qt app_bundle
+CONFIG += console thread
+
+TARGET = tron-netplay
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += netplay.cpp
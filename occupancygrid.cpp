@@ -0,0 +1,61 @@
+#include "occupancygrid.h"
+
+OccupancyGrid::OccupancyGrid(Size size)
+    : size(size)
+    , chunksWide((size.width + CHUNK_SIZE - 1) / CHUNK_SIZE)
+    , chunks(static_cast<std::size_t>(chunksWide)
+             * ((size.height + CHUNK_SIZE - 1) / CHUNK_SIZE), nullptr)
+{}
+
+OccupancyGrid::OccupancyGrid(const OccupancyGrid &other)
+    : size(other.size)
+    , chunksWide(other.chunksWide)
+    , chunks(other.chunks.size(), nullptr)
+    , chunkCount(other.chunkCount)
+{
+    // One slab for all of them
+    Chunk *copies = chunkCount > 0 ? arena.allocate(chunkCount) : nullptr;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        if (other.chunks[i]) {
+            *copies = *other.chunks[i];
+            chunks[i] = copies++;
+        }
+    }
+}
+
+void OccupancyGrid::clear()
+{
+    for (Chunk *chunk : chunks) {
+        if (chunk) {
+            *chunk = Chunk();
+        }
+    }
+}
+
+/*!
+ * The chunks missing are taken from one slab, next to each other.
+ */
+void OccupancyGrid::allocateAll()
+{
+    std::size_t missing = chunks.size() - static_cast<std::size_t>(chunkCount);
+    if (missing == 0) {
+        return;
+    }
+    Chunk *fresh = arena.allocate(missing);
+    for (Chunk *&chunk : chunks) {
+        if (!chunk) {
+            chunk = fresh++;
+        }
+    }
+    chunkCount = static_cast<int>(chunks.size());
+}
+
+auto OccupancyGrid::getSize() const -> Size
+{
+    return size;
+}
+
+auto OccupancyGrid::getChunkCount() const -> int
+{
+    return chunkCount;
+}
@@ -0,0 +1,148 @@
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "geometry.h"
+
+//! Bit-packed record of which map tiles are covered by a trail.
+/*!
+ * One bit per tile, so a collision check is a single load and
+ * mask no matter how long the game has run. The map is split into
+ * square chunks that are only allocated once something is drawn
+ * in them, so memory grows with the area covered by trails rather
+ * than with the size of the map. Chunks come from an Arena and
+ * live as long as the grid.
+ */
+class OccupancyGrid
+{
+public:
+    //! Width and height of a chunk in tiles; one 64-bit word per row.
+    static const int CHUNK_SIZE = 64;
+
+    explicit OccupancyGrid(Size size);
+    //! Copy every chunk of `other`.
+    OccupancyGrid(const OccupancyGrid &other);
+
+    //! Check if the tile at `position` is occupied.
+    auto test(Point position) const -> bool;
+    //! Mark the tile at `position` as occupied.
+    void set(Point position);
+    //! Like set(), but safe while other threads do the same.
+    /*!
+     * Nothing else may touch the grid meanwhile, and chunks aren't
+     * allocated: if the chunk holding `position` isn't yet, nothing
+     * is set, and set() has to be called once the others are done.
+     * \return Whether the tile was set.
+     */
+    auto setConcurrently(Point position) -> bool;
+    //! Mark the tile at `position` as free again.
+    /*!
+     * Chunks stay allocated, so undoing and redoing moves never
+     * allocates.
+     */
+    void reset(Point position);
+    //! Mark every tile as free.
+    /*!
+     * Chunks stay allocated, so a new game on the same grid
+     * doesn't allocate for the area the last one covered.
+     */
+    void clear();
+    //! Allocate every chunk now, so that set() never allocates.
+    void allocateAll();
+    //! Get the occupancy of tiles 64 * `word` to 64 * `word` + 63 of row `y`.
+    /*!
+     * Bit `i` is tile 64 * `word` + `i`, as in a Bitboard; chunks
+     * are 64 tiles wide, so this is one chunk row.
+     */
+    auto getWord(int y, int word) const -> std::uint64_t;
+
+    auto getSize() const -> Size; //!< Get size in tiles.
+    //! Get the number of chunks allocated so far.
+    auto getChunkCount() const -> int;
+
+private:
+    //! Occupancy bits of a CHUNK_SIZE square, one word per row.
+    struct Chunk
+    {
+        std::uint64_t rows[CHUNK_SIZE];
+    };
+
+    //! Size of the grid in tiles.
+    const Size size;
+    //! Width of the grid in chunks.
+    const int chunksWide;
+    //! Where chunks are allocated.
+    Arena<Chunk> arena;
+    //! Chunks in row-major order; null until first written.
+    std::vector<Chunk*> chunks;
+    //! Number of non-null `chunks`.
+    int chunkCount{0};
+
+    //! Get index into `chunks` of the chunk holding `position`.
+    auto chunkIndex(Point position) const -> std::size_t;
+
+};
+
+// test(), set(), setConcurrently(), reset() and getWord() are on hot paths, keep them inline.
+
+inline auto OccupancyGrid::chunkIndex(Point position) const -> std::size_t
+{
+    return static_cast<std::size_t>(position.y / CHUNK_SIZE) * chunksWide
+            + position.x / CHUNK_SIZE;
+}
+
+inline auto OccupancyGrid::test(Point position) const -> bool
+{
+    const Chunk *chunk = chunks[chunkIndex(position)];
+    if (!chunk) {
+        return false;
+    }
+    return (chunk->rows[position.y % CHUNK_SIZE] >> (position.x % CHUNK_SIZE)) & 1u;
+}
+
+inline void OccupancyGrid::set(Point position)
+{
+    Chunk *&chunk = chunks[chunkIndex(position)];
+    if (!chunk) {
+        chunk = arena.allocate();
+        ++chunkCount;
+    }
+    chunk->rows[position.y % CHUNK_SIZE] |= std::uint64_t{1} << (position.x % CHUNK_SIZE);
+}
+
+inline auto OccupancyGrid::setConcurrently(Point position) -> bool
+{
+    Chunk *chunk = chunks[chunkIndex(position)];
+    if (!chunk) {
+        return false;
+    }
+    std::uint64_t &row = chunk->rows[position.y % CHUNK_SIZE];
+    std::uint64_t bit = std::uint64_t{1} << (position.x % CHUNK_SIZE);
+    // Neighbouring tiles share a word, so set the bit atomically
+#if defined(__GNUC__)
+    __atomic_fetch_or(&row, bit, __ATOMIC_RELAXED);
+#else
+    reinterpret_cast<std::atomic<std::uint64_t>&>(row).fetch_or(bit, std::memory_order_relaxed);
+#endif
+    return true;
+}
+
+inline auto OccupancyGrid::getWord(int y, int word) const -> std::uint64_t
+{
+    const Chunk *chunk = chunks[static_cast<std::size_t>(y / CHUNK_SIZE) * chunksWide + word];
+    return chunk ? chunk->rows[y % CHUNK_SIZE] : 0;
+}
+
+inline void OccupancyGrid::reset(Point position)
+{
+    Chunk *chunk = chunks[chunkIndex(position)];
+    if (chunk) {
+        chunk->rows[position.y % CHUNK_SIZE] &= ~(std::uint64_t{1} << (position.x % CHUNK_SIZE));
+    }
+}
+
+#endif // OCCUPANCYGRID_H
@@ -0,0 +1,104 @@
+#include "policy.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+
+auto isHorizontal(Direction direction) -> bool
+{
+    return direction == Direction::Left || direction == Direction::Right;
+}
+
+//! Collect the directions a player may take without reversing.
+/*!
+ * Reversing is always a collision with our own trail.
+ * \return Number of candidates written to `out`.
+ */
+auto candidates(Direction current, Direction out[4]) -> int
+{
+    int count = 0;
+    if (current != Direction::None) {
+        out[count++] = current;
+    }
+    if (current == Direction::None || isHorizontal(current)) {
+        out[count++] = Direction::Up;
+        out[count++] = Direction::Down;
+    }
+    if (current == Direction::None || !isHorizontal(current)) {
+        out[count++] = Direction::Left;
+        out[count++] = Direction::Right;
+    }
+    return count;
+}
+
+} // namespace
+
+auto randomPolicy(const Tron &tron, int player,
+                  std::mt19937 &rng) -> Player::Direction
+{
+    Direction current = tron.getDirection(player);
+    Point position = tron.getPosition(player);
+    if (current != Direction::None
+            && !tron.isBlocked(Player::advance(position, current))
+            && rng() % 8 != 0) {
+        return current;
+    }
+    Direction options[4];
+    int count = candidates(current, options);
+    Direction open[4];
+    int openCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (options[i] != current
+                && !tron.isBlocked(Player::advance(position, options[i]))) {
+            open[openCount++] = options[i];
+        }
+    }
+    if (openCount == 0) {
+        return options[0];
+    }
+    return open[rng() % openCount];
+}
+
+auto cautiousPolicy(const Tron &tron, int player,
+                    std::mt19937 &rng) -> Player::Direction
+{
+    Direction current = tron.getDirection(player);
+    Point position = tron.getPosition(player);
+    if (current != Direction::None
+            && !tron.isBlocked(Player::advance(position, current))) {
+        return current;
+    }
+    Direction options[4];
+    int count = candidates(current, options);
+    Direction best = options[rng() % count];
+    int bestRun = -1;
+    for (int i = 0; i < count; ++i) {
+        int run = tron.freeRun(position, options[i]);
+        if (run > bestRun) {
+            best = options[i];
+            bestRun = run;
+        }
+    }
+    return best;
+}
+
+auto spaciousPolicy(const Tron &tron, int player,
+                    std::mt19937 &rng) -> Player::Direction
+{
+    Direction options[4];
+    int count = candidates(tron.getDirection(player), options);
+    // Start from a random candidate so ties don't always
+    // break the same way.
+    int offset = rng() % count;
+    Direction best = options[offset];
+    int bestRun = -1;
+    for (int i = 0; i < count; ++i) {
+        Direction direction = options[(offset + i) % count];
+        int run = tron.freeRun(tron.getPosition(player), direction);
+        if (run > bestRun) {
+            best = direction;
+            bestRun = run;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,23 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <random>
+
+#include "tron.h"
+
+//! Chooses the next direction for a computer-controlled player.
+/*!
+ * Called once per tick, before Tron::step(), with the index of
+ * every player still in play. All randomness must come from the supplied
+ * generator so that seeded games are reproducible.
+ */
+typedef auto (*Policy)(const Tron &, int, std::mt19937 &) -> Player::Direction;
+
+//! Mostly straight, turning at random or when about to crash.
+auto randomPolicy(const Tron &, int, std::mt19937 &) -> Player::Direction;
+//! Straight until blocked, then turn towards the longer free run.
+auto cautiousPolicy(const Tron &, int, std::mt19937 &) -> Player::Direction;
+//! Always head in the direction with the longest free run.
+auto spaciousPolicy(const Tron &, int, std::mt19937 &) -> Player::Direction;
+
+#endif // POLICY_H
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <atomic>
+
+#include "rayindex.h"
+#include "bits.h"
+
+namespace {
+
+//! Get the number of summary words for lines `length` tiles long.
+auto markWords(int length) -> int
+{
+    int words = (length + 63) / 64;
+    return (words + 63) / 64;
+}
+
+//! Set `bit` in `word` while other threads may do the same.
+void orConcurrently(std::uint64_t &word, std::uint64_t bit)
+{
+#if defined(__GNUC__)
+    __atomic_fetch_or(&word, bit, __ATOMIC_RELAXED);
+#else
+    reinterpret_cast<std::atomic<std::uint64_t>&>(word).fetch_or(bit, std::memory_order_relaxed);
+#endif
+}
+
+} // namespace
+
+RayIndex::RayIndex(const OccupancyGrid &rows)
+    : rows(rows)
+    , columns(Size{rows.getSize().height, rows.getSize().width})
+    , size(rows.getSize())
+    , rowMarkWords(markWords(size.width))
+    , columnMarkWords(markWords(size.height))
+    , rowMarks(static_cast<std::size_t>(size.height) * rowMarkWords, 0)
+    , columnMarks(static_cast<std::size_t>(size.width) * columnMarkWords, 0)
+{}
+
+RayIndex::RayIndex(const OccupancyGrid &rows, const RayIndex &other)
+    : rows(rows)
+    , columns(other.columns)
+    , size(other.size)
+    , rowMarkWords(other.rowMarkWords)
+    , columnMarkWords(other.columnMarkWords)
+    , rowMarks(other.rowMarks)
+    , columnMarks(other.columnMarks)
+{}
+
+void RayIndex::set(Point position)
+{
+    columns.set(Point{position.y, position.x});
+    rowMarks[static_cast<std::size_t>(position.y) * rowMarkWords + position.x / 4096]
+            |= std::uint64_t{1} << (position.x / 64 % 64);
+    columnMarks[static_cast<std::size_t>(position.x) * columnMarkWords + position.y / 4096]
+            |= std::uint64_t{1} << (position.y / 64 % 64);
+}
+
+auto RayIndex::setConcurrently(Point position) -> bool
+{
+    if (!columns.setConcurrently(Point{position.y, position.x})) {
+        return false;
+    }
+    orConcurrently(rowMarks[static_cast<std::size_t>(position.y) * rowMarkWords + position.x / 4096],
+                   std::uint64_t{1} << (position.x / 64 % 64));
+    orConcurrently(columnMarks[static_cast<std::size_t>(position.x) * columnMarkWords + position.y / 4096],
+                   std::uint64_t{1} << (position.y / 64 % 64));
+    return true;
+}
+
+void RayIndex::reset(Point position)
+{
+    columns.reset(Point{position.y, position.x});
+    if (rows.getWord(position.y, position.x / 64) == 0) {
+        rowMarks[static_cast<std::size_t>(position.y) * rowMarkWords + position.x / 4096]
+                &= ~(std::uint64_t{1} << (position.x / 64 % 64));
+    }
+    if (columns.getWord(position.x, position.y / 64) == 0) {
+        columnMarks[static_cast<std::size_t>(position.x) * columnMarkWords + position.y / 4096]
+                &= ~(std::uint64_t{1} << (position.y / 64 % 64));
+    }
+}
+
+void RayIndex::clear()
+{
+    columns.clear();
+    std::fill(rowMarks.begin(), rowMarks.end(), 0);
+    std::fill(columnMarks.begin(), columnMarks.end(), 0);
+}
+
+void RayIndex::allocateAll()
+{
+    columns.allocateAll();
+}
+
+auto RayIndex::freeRun(Point from, Player::Direction direction) const -> int
+{
+    if (from.x < 0 || from.y < 0 || from.x >= size.width || from.y >= size.height) {
+        return 0;
+    }
+    int obstacle;
+    switch (direction) {
+    case Player::Direction::Right:
+        obstacle = from.x + 1 < size.width
+                ? nextSet(rows, rowMarksOf(from.y), from.y, from.x + 1) : -1;
+        return (obstacle < 0 ? size.width : obstacle) - from.x - 1;
+    case Player::Direction::Left:
+        obstacle = from.x > 0 ? previousSet(rows, rowMarksOf(from.y), from.y, from.x - 1) : -1;
+        return from.x - obstacle - 1;
+    case Player::Direction::Down:
+        obstacle = from.y + 1 < size.height
+                ? nextSet(columns, columnMarksOf(from.x), from.x, from.y + 1) : -1;
+        return (obstacle < 0 ? size.height : obstacle) - from.y - 1;
+    case Player::Direction::Up:
+        obstacle = from.y > 0 ? previousSet(columns, columnMarksOf(from.x), from.x, from.y - 1) : -1;
+        return from.y - obstacle - 1;
+    default:
+        return 0;
+    }
+}
+
+/*!
+ * Rows are searched outwards from `from`, the nearest obstacle in
+ * each found in one lookup either way, until they are further off
+ * than the best found. The cap and the edge of the map bound the
+ * search, so it takes at most 2 * MAX_OBSTACLE_DISTANCE rows
+ * however large the map is.
+ */
+auto RayIndex::obstacleDistance(Point from) const -> int
+{
+    if (from.x < 0 || from.y < 0 || from.x >= size.width || from.y >= size.height) {
+        return 0;
+    }
+    int best = std::min(std::min(from.x + 1, size.width - from.x),
+                        std::min(from.y + 1, size.height - from.y));
+    best = std::min(best, MAX_OBSTACLE_DISTANCE);
+    for (int dy = 0; dy < best; ++dy) {
+        for (int y : {from.y - dy, from.y + dy}) {
+            const std::uint64_t *marks = rowMarksOf(y);
+            int right = nextSet(rows, marks, y, from.x);
+            if (right >= 0) {
+                best = std::min(best, dy + right - from.x);
+            }
+            int left = previousSet(rows, marks, y, from.x);
+            if (left >= 0) {
+                best = std::min(best, dy + from.x - left);
+            }
+        }
+    }
+    return best;
+}
+
+auto RayIndex::nextSet(const OccupancyGrid &grid, const std::uint64_t *marks,
+                       int line, int from) -> int
+{
+    int word = from / 64;
+    std::uint64_t bits = grid.getWord(line, word) & (~std::uint64_t{0} << (from % 64));
+    if (bits) {
+        return word * 64 + lowestBit(bits);
+    }
+    // Words past the end of the line are never marked
+    int next = word + 1;
+    int markCount = markWords(grid.getSize().width);
+    for (int m = next / 64; m < markCount; ++m) {
+        std::uint64_t marked = marks[m];
+        if (m == next / 64) {
+            marked &= ~std::uint64_t{0} << (next % 64);
+        }
+        if (marked) {
+            int found = m * 64 + lowestBit(marked);
+            return found * 64 + lowestBit(grid.getWord(line, found));
+        }
+    }
+    return -1;
+}
+
+auto RayIndex::previousSet(const OccupancyGrid &grid, const std::uint64_t *marks,
+                           int line, int from) -> int
+{
+    int word = from / 64;
+    std::uint64_t bits = grid.getWord(line, word) & (~std::uint64_t{0} >> (63 - from % 64));
+    if (bits) {
+        return word * 64 + highestBit(bits);
+    }
+    int previous = word - 1;
+    for (int m = previous / 64; previous >= 0 && m >= 0; --m) {
+        std::uint64_t marked = marks[m];
+        if (m == previous / 64) {
+            marked &= ~std::uint64_t{0} >> (63 - previous % 64);
+        }
+        if (marked) {
+            int found = m * 64 + highestBit(marked);
+            return found * 64 + highestBit(grid.getWord(line, found));
+        }
+    }
+    return -1;
+}
+
+auto RayIndex::rowMarksOf(int y) const -> const std::uint64_t*
+{
+    return &rowMarks[static_cast<std::size_t>(y) * rowMarkWords];
+}
+
+auto RayIndex::columnMarksOf(int x) const -> const std::uint64_t*
+{
+    return &columnMarks[static_cast<std::size_t>(x) * columnMarkWords];
+}
+
+// Constants
+const int RayIndex::MAX_OBSTACLE_DISTANCE{32};
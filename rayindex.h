@@ -0,0 +1,94 @@
+#ifndef RAYINDEX_H
+#define RAYINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "occupancygrid.h"
+#include "player.h"
+
+//! Answers how far a straight line gets before hitting a trail or the edge.
+/*!
+ * Works alongside an OccupancyGrid of the rows, which it reads but
+ * doesn't own, and keeps a transposed grid of the columns, so
+ * every row and every column is a line of bits. Each line also has
+ * a summary with a bit per 64-tile word saying whether anything is
+ * in it, so the next obstacle along a line is found by looking at
+ * a word of the line, a summary word or two (three for the widest
+ * maps), and one more word of the line, however far away it is.
+ * Free runs between obstacles are the gaps between those bits.
+ *
+ * Must be told of every tile set or reset in the row grid, after
+ * the row grid has been changed.
+ */
+class RayIndex
+{
+public:
+    //! Farthest obstacleDistance() looks; anything further is reported as this.
+    static const int MAX_OBSTACLE_DISTANCE;
+
+    //! Index the rows of `rows`, which must be empty and outlive this.
+    explicit RayIndex(const OccupancyGrid &rows);
+    //! Copy `other`, indexing `rows`, which must hold the same tiles.
+    RayIndex(const OccupancyGrid &rows, const RayIndex &other);
+    RayIndex(const RayIndex &other) = delete;
+
+    //! Take in that the tile at `position` is now occupied.
+    void set(Point position);
+    //! Like set(), but safe while other threads do the same.
+    /*!
+     * As with OccupancyGrid::setConcurrently(), nothing is set if
+     * the column chunk holding `position` isn't allocated yet, and
+     * set() has to be called once the others are done.
+     * \return Whether the tile was set.
+     */
+    auto setConcurrently(Point position) -> bool;
+    //! Take in that the tile at `position` is free again.
+    void reset(Point position);
+    //! Take in that every tile is free.
+    void clear();
+    //! Allocate all the storage that set() may need now.
+    void allocateAll();
+
+    //! Count free tiles from `from` in `direction` up to an obstacle.
+    /*!
+     * `from` itself isn't counted; 0 if it is off the map.
+     */
+    auto freeRun(Point from, Player::Direction direction) const -> int;
+    //! Get the fewest steps from `from` to an obstacle, ignoring what is in between.
+    /*!
+     * Obstacles are occupied tiles and tiles just off the map, so
+     * this is 0 if `from` is occupied or off the map. Capped at
+     * MAX_OBSTACLE_DISTANCE, so it never looks at more than that
+     * many rows each way.
+     */
+    auto obstacleDistance(Point from) const -> int;
+
+private:
+    const OccupancyGrid &rows;
+    //! Column `x` of the map is row `x` of this grid.
+    OccupancyGrid columns;
+    const Size size;
+    //! Summary words per row and per column.
+    const int rowMarkWords;
+    const int columnMarkWords;
+    //! Bit `w` of a row's summary is set if its word `w` isn't empty.
+    std::vector<std::uint64_t> rowMarks;
+    //! Like `rowMarks`, for the words of `columns`.
+    std::vector<std::uint64_t> columnMarks;
+
+    //! Get the first set bit at or after `from` in `line` of `grid`, or -1.
+    static auto nextSet(const OccupancyGrid &grid, const std::uint64_t *marks,
+                        int line, int from) -> int;
+    //! Get the last set bit at or before `from` in `line` of `grid`, or -1.
+    static auto previousSet(const OccupancyGrid &grid, const std::uint64_t *marks,
+                            int line, int from) -> int;
+    //! Get the summary of row `y`.
+    auto rowMarksOf(int y) const -> const std::uint64_t*;
+    //! Get the summary of column `x`.
+    auto columnMarksOf(int x) const -> const std::uint64_t*;
+
+};
+
+#endif // RAYINDEX_H
@@ -0,0 +1,81 @@
+#ifndef REORDERBUFFER_H
+#define REORDERBUFFER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//! Numbered items put in any order by some threads, taken in order by others.
+/*!
+ * Item `index` goes in slot `index % capacity`, so at most
+ * `capacity` items are held at once: put() waits while its item is
+ * that far ahead of the next one to be taken. Any number of threads
+ * may put and take. As long as items are started in order (say, by
+ * taking them from another ReorderBuffer), the one taken next is
+ * always being worked on, so nobody waits forever.
+ */
+template <typename T>
+class ReorderBuffer
+{
+public:
+    //! Hold up to `capacity` items at once.
+    explicit ReorderBuffer(std::size_t capacity)
+        : slots(capacity)
+        , filled(capacity, false)
+    {
+    }
+
+    //! Store item `index`, once it's less than `capacity` past the next one taken.
+    void put(std::size_t index, T item)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        changed.wait(lock, [this, index] { return index < next + slots.size(); });
+        slots[index % slots.size()] = std::move(item);
+        filled[index % slots.size()] = true;
+        changed.notify_all();
+    }
+
+    //! Wait for the next item in order and move it into `item`.
+    /*!
+     * \return Whether there was one; false once every item before
+     * the count given to close() has been taken.
+     */
+    auto take(T &item) -> bool
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        changed.wait(lock, [this] { return next >= end || filled[next % slots.size()]; });
+        if (next >= end) {
+            return false;
+        }
+        item = std::move(slots[next % slots.size()]);
+        filled[next % slots.size()] = false;
+        ++next;
+        changed.notify_all();
+        return true;
+    }
+
+    //! Say that `count` items are all there will be.
+    void close(std::size_t count)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        end = count;
+        changed.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    //! Notified whenever an item is put or taken, or the end is set.
+    std::condition_variable changed;
+    std::vector<T> slots;
+    std::vector<bool> filled;
+    //! Index of the next item to be taken.
+    std::size_t next{0};
+    //! Number of items in all, once closed.
+    std::size_t end{std::numeric_limits<std::size_t>::max()};
+
+};
+
+#endif // REORDERBUFFER_H
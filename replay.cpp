@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRON_HAVE_MMAP
+#endif
+
+#include "boardcodec.h"
+#include "replay.h"
+#include "tron.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+
+const std::uint32_t MAGIC = 0x524e5254; // "TRNR"
+const std::uint32_t VERSION = 2;
+
+// Header words
+enum : std::size_t {
+    MAGIC_WORD,
+    VERSION_WORD,
+    BYTE_SIZE_WORD,
+    WIDTH_WORD,
+    HEIGHT_WORD,
+    PLAYER_COUNT_WORD,
+    TICK_COUNT_WORD,
+    KEYFRAME_INTERVAL_WORD,
+    KEYFRAME_COUNT_WORD,
+    HEADER_WORDS
+};
+const std::size_t KEYFRAME_WORDS = 4;
+
+void putWord(std::vector<std::uint8_t> &out, std::uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+} // namespace
+
+ReplayRecorder::ReplayRecorder(Size mapSize, int playerCount, int keyframeInterval)
+    : mapSize(mapSize)
+    , playerCount(playerCount)
+    , keyframeInterval(std::max(0, keyframeInterval))
+    , runBytes((playerCount + 3) / 4)
+    , run(runBytes, 0)
+{}
+
+/*!
+ * Ticks where nobody turns only lengthen the current run, so a
+ * game costs a few bytes per turn taken rather than per tick.
+ */
+void ReplayRecorder::record(const Tron &tron)
+{
+    if (tickCount == 0 && (tron.getMapSize() != mapSize
+                           || tron.getPlayerCount() != playerCount)) {
+        throw std::logic_error{"Recorder set up for another game."};
+    }
+    if (keyframeInterval > 0 && tickCount > 0 && tickCount % keyframeInterval == 0) {
+        snapshot(tron);
+    }
+
+    std::vector<std::uint8_t> packed(runBytes, 0);
+    for (int i = 0; i < playerCount; ++i) {
+        packed[i / 4] |= packDirection(tron.getDirection(i)) << (i % 4 * 2);
+    }
+    if (runLength > 0 && packed != run) {
+        flushRun();
+    }
+    run.swap(packed);
+    ++runLength;
+
+    if (keyframeInterval > 0 && tickCount > 0 && tickCount % keyframeInterval == 0) {
+        // The run holding this tick will be written where the stream ends now
+        keyframes.push_back(static_cast<std::uint32_t>(stream.size()));
+        keyframes.push_back(static_cast<std::uint32_t>(runLength - 1));
+        keyframes.push_back(static_cast<std::uint32_t>(tickCount));
+    }
+    ++tickCount;
+}
+
+auto ReplayRecorder::getTickCount() const -> int
+{
+    return tickCount;
+}
+
+void ReplayRecorder::flushRun()
+{
+    putVarint(stream, static_cast<std::uint32_t>(runLength));
+    stream.insert(stream.end(), run.begin(), run.end());
+    runLength = 0;
+}
+
+/*!
+ * The board is stored as encodeBoard() lays it out, so a snapshot
+ * grows with the number of turns taken, not tiles covered.
+ */
+void ReplayRecorder::snapshot(const Tron &tron)
+{
+    keyframes.push_back(static_cast<std::uint32_t>(snapshots.size()));
+    encodeBoard(tron, snapshots);
+}
+
+/*!
+ * Header words, in order: magic, version, size of the replay in
+ * bytes, map width, map height, player count, tick count, keyframe
+ * interval and keyframe count.
+ */
+void ReplayRecorder::write(std::ostream &out) const
+{
+    std::vector<std::uint8_t> tail;
+    if (runLength > 0) {
+        putVarint(tail, static_cast<std::uint32_t>(runLength));
+        tail.insert(tail.end(), run.begin(), run.end());
+    }
+    std::size_t keyframeCount = keyframes.size() / KEYFRAME_WORDS;
+    std::size_t streamStart = (HEADER_WORDS + keyframes.size()) * 4;
+    std::size_t snapshotStart = streamStart + stream.size() + tail.size();
+    std::size_t byteSize = snapshotStart + snapshots.size();
+    if (byteSize > UINT32_MAX) {
+        throw std::logic_error{"Replay too large."};
+    }
+
+    std::vector<std::uint8_t> header;
+    putWord(header, MAGIC);
+    putWord(header, VERSION);
+    putWord(header, static_cast<std::uint32_t>(byteSize));
+    putWord(header, static_cast<std::uint32_t>(mapSize.width));
+    putWord(header, static_cast<std::uint32_t>(mapSize.height));
+    putWord(header, static_cast<std::uint32_t>(playerCount));
+    putWord(header, static_cast<std::uint32_t>(tickCount));
+    putWord(header, static_cast<std::uint32_t>(keyframeInterval));
+    putWord(header, static_cast<std::uint32_t>(keyframeCount));
+    for (std::size_t k = 0; k < keyframes.size(); k += KEYFRAME_WORDS) {
+        putWord(header, static_cast<std::uint32_t>(streamStart + keyframes[k + 1]));
+        putWord(header, keyframes[k + 2]);
+        putWord(header, static_cast<std::uint32_t>(snapshotStart + keyframes[k]));
+        putWord(header, keyframes[k + 3]);
+    }
+
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out.write(reinterpret_cast<const char*>(stream.data()), stream.size());
+    out.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+    out.write(reinterpret_cast<const char*>(snapshots.data()), snapshots.size());
+}
+
+Replay::Replay(const std::uint8_t *data, std::size_t size)
+    : data(data)
+    , size(size)
+{
+    if (size < HEADER_WORDS * 4 || word(MAGIC_WORD) != MAGIC) {
+        throw std::logic_error{"Not a replay."};
+    }
+    if (word(VERSION_WORD) != VERSION) {
+        throw std::logic_error{"Unsupported replay version."};
+    }
+    std::size_t byteSize = word(BYTE_SIZE_WORD);
+    std::size_t keyframeCount = word(KEYFRAME_COUNT_WORD);
+    if (byteSize > size
+            || keyframeCount > byteSize / 4
+            || (HEADER_WORDS + KEYFRAME_WORDS * keyframeCount) * 4 > byteSize
+            || (keyframeCount > 0 && word(KEYFRAME_INTERVAL_WORD) == 0)) {
+        throw std::logic_error{"Corrupt replay."};
+    }
+    this->size = byteSize;
+}
+
+auto Replay::word(std::size_t index) const -> std::uint32_t
+{
+    const std::uint8_t *bytes = data + index * 4;
+    return static_cast<std::uint32_t>(bytes[0])
+            | static_cast<std::uint32_t>(bytes[1]) << 8
+            | static_cast<std::uint32_t>(bytes[2]) << 16
+            | static_cast<std::uint32_t>(bytes[3]) << 24;
+}
+
+auto Replay::getMapSize() const -> Size
+{
+    return Size{static_cast<int>(word(WIDTH_WORD)), static_cast<int>(word(HEIGHT_WORD))};
+}
+
+auto Replay::getPlayerCount() const -> int
+{
+    return static_cast<int>(word(PLAYER_COUNT_WORD));
+}
+
+auto Replay::getTickCount() const -> int
+{
+    return static_cast<int>(word(TICK_COUNT_WORD));
+}
+
+auto Replay::getByteSize() const -> std::size_t
+{
+    return size;
+}
+
+ReplayPlayer::ReplayPlayer(const Replay &replay)
+    : replay(replay)
+    , directions(replay.getPlayerCount(), Direction::None)
+{
+    seek(0);
+}
+
+auto ReplayPlayer::getTron() const -> const Tron&
+{
+    return *tron;
+}
+
+auto ReplayPlayer::getTick() const -> int
+{
+    return tick;
+}
+
+auto ReplayPlayer::step() -> bool
+{
+    if (tick >= replay.getTickCount()) {
+        return false;
+    }
+    if (runLeft == 0) {
+        readRun();
+    }
+    for (int i = 0; i < replay.getPlayerCount(); ++i) {
+        tron->turn(i, directions[i]);
+    }
+    tron->step();
+    --runLeft;
+    ++tick;
+    return tick < replay.getTickCount();
+}
+
+void ReplayPlayer::seek(int target)
+{
+    target = std::max(0, std::min(target, replay.getTickCount()));
+    int interval = static_cast<int>(replay.word(KEYFRAME_INTERVAL_WORD));
+    int keyframeCount = static_cast<int>(replay.word(KEYFRAME_COUNT_WORD));
+    int keyframe = interval > 0 ? std::min(target / interval, keyframeCount) - 1 : -1;
+    int keyframeTick = (keyframe + 1) * interval;
+
+    if (!tron || target < tick || (keyframe >= 0 && keyframeTick > tick)) {
+        if (keyframe >= 0) {
+            restore(keyframe);
+        } else {
+            tron.reset(new Tron{replay.getMapSize(), replay.getPlayerCount()});
+            tick = 0;
+            offset = (HEADER_WORDS + KEYFRAME_WORDS * keyframeCount) * 4;
+            runLeft = 0;
+        }
+    }
+    while (tick < target) {
+        step();
+    }
+}
+
+void ReplayPlayer::readRun()
+{
+    runLeft = static_cast<int>(getVarint(replay.data, replay.size, offset));
+    std::size_t runBytes = (directions.size() + 3) / 4;
+    if (runLeft == 0 || offset + runBytes > replay.size) {
+        throw std::logic_error{"Corrupt replay."};
+    }
+    for (std::size_t i = 0; i < directions.size(); ++i) {
+        directions[i] = unpackDirection(replay.data[offset + i / 4] >> (i % 4 * 2));
+    }
+    offset += runBytes;
+}
+
+/*!
+ * The snapshot is of the board just before the keyframe's tick is
+ * played, so the game carries on from that tick.
+ */
+void ReplayPlayer::restore(int keyframe)
+{
+    std::size_t entry = HEADER_WORDS + KEYFRAME_WORDS * keyframe;
+    int at = static_cast<int>(replay.word(entry + 3));
+    if (at != (keyframe + 1) * static_cast<int>(replay.word(KEYFRAME_INTERVAL_WORD))) {
+        throw std::logic_error{"Corrupt replay."};
+    }
+    std::size_t snapshot = replay.word(entry + 2);
+    std::unique_ptr<Tron> restored{new Tron{replay.getMapSize(), replay.getPlayerCount()}};
+    decodeBoard(replay.data, replay.size, snapshot, *restored);
+    restored->placeTick(at);
+    tron = std::move(restored);
+    tick = at;
+    offset = replay.word(entry);
+    readRun();
+    runLeft -= static_cast<int>(replay.word(entry + 1));
+}
+
+ReplayFile::ReplayFile(const std::string &path)
+{
+#ifdef TRON_HAVE_MMAP
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error{"Can't open " + path + "."};
+    }
+    struct stat status;
+    if (::fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        size = static_cast<std::size_t>(status.st_size);
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            data = static_cast<const std::uint8_t*>(mapping);
+        }
+    }
+    ::close(descriptor);
+    if (size > 0 && !data) {
+        throw std::runtime_error{"Can't map " + path + "."};
+    }
+#else
+    std::ifstream in{path, std::ios::binary};
+    if (!in) {
+        throw std::runtime_error{"Can't open " + path + "."};
+    }
+    buffer.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    try {
+        for (std::size_t at = 0; at < size; at += Replay{data + at, size - at}.getByteSize()) {
+            offsets.push_back(at);
+        }
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+ReplayFile::~ReplayFile()
+{
+    unmap();
+}
+
+void ReplayFile::unmap()
+{
+#ifdef TRON_HAVE_MMAP
+    if (data) {
+        ::munmap(const_cast<std::uint8_t*>(data), size);
+        data = nullptr;
+    }
+#endif
+}
+
+auto ReplayFile::getReplayCount() const -> std::size_t
+{
+    return offsets.size();
+}
+
+auto ReplayFile::getReplay(std::size_t index) const -> Replay
+{
+    return Replay{data + offsets.at(index), size - offsets.at(index)};
+}
+
+// Constants
+const int ReplayRecorder::DEFAULT_KEYFRAME_INTERVAL{1024};
@@ -0,0 +1,192 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "player.h"
+
+class Tron;
+
+/*! \file
+ * Games are deterministic, so a replay only stores the map size,
+ * the player count and the direction of every player at every
+ * tick; playing it back means running the moves through Tron again.
+ *
+ * Layout, all integers little-endian:
+ *
+ *     header     HEADER_WORDS 32-bit words, see ReplayRecorder::write()
+ *     keyframes  4 words per keyframe: stream offset, ticks of that
+ *                run already played, snapshot offset, tick of the
+ *                game
+ *     stream     runs: varint tick count, then 2 bits per player
+ *     snapshots  one per keyframe, see ReplayRecorder::snapshot()
+ *
+ * Offsets count from the start of the replay. Replays can be
+ * concatenated into one corpus file; each header gives the size of
+ * its replay so the next one can be found without decoding this one.
+ */
+
+//! Writes a replay of a game as Tron plays it.
+/*!
+ * Hand it to Tron::setRecorder() before the first move; every move
+ * of the game is then recorded until the recorder is removed.
+ */
+class ReplayRecorder
+{
+public:
+    //! Ticks between keyframes, so seeking never replays more.
+    static const int DEFAULT_KEYFRAME_INTERVAL;
+
+    //! Record a game on `mapSize` with `playerCount` players.
+    /*!
+     * \param keyframeInterval Ticks between keyframes, or 0 for
+     * none; keyframes make seeking quick but cost room.
+     */
+    ReplayRecorder(Size mapSize, int playerCount,
+                   int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+    //! Note the directions `tron` is about to move its players in.
+    /*!
+     * Called by Tron::step() just before each move.
+     */
+    void record(const Tron &tron);
+    //! Get the number of ticks recorded.
+    auto getTickCount() const -> int;
+    //! Write the replay so far to `out`.
+    void write(std::ostream &out) const;
+
+private:
+    const Size mapSize;
+    const int playerCount;
+    const int keyframeInterval;
+    //! Bytes holding one tick's directions.
+    const int runBytes;
+    int tickCount{0};
+
+    //! Directions of the run not yet written to `stream`, packed.
+    std::vector<std::uint8_t> run;
+    //! Ticks in `run`.
+    int runLength{0};
+    std::vector<std::uint8_t> stream;
+    //! Four words per keyframe, snapshot offsets relative to `snapshots`.
+    std::vector<std::uint32_t> keyframes;
+    std::vector<std::uint8_t> snapshots;
+
+    //! Move `run` to the end of `stream`.
+    void flushRun();
+    //! Append the state of every player in `tron` to `snapshots`.
+    void snapshot(const Tron &tron);
+
+};
+
+//! A recorded game held in memory someone else owns.
+/*!
+ * Cheap to create and copy: nothing is decoded up front, only the
+ * header is checked.
+ */
+class Replay
+{
+public:
+    //! View the replay starting at `data`, of at most `size` bytes.
+    /*!
+     * Throws if the bytes don't start with a valid replay header.
+     */
+    Replay(const std::uint8_t *data, std::size_t size);
+
+    auto getMapSize() const -> Size; //!< Get map size in tiles.
+    auto getPlayerCount() const -> int; //!< Get player count.
+    //! Get the number of moves in the game.
+    auto getTickCount() const -> int;
+    //! Get the number of bytes the replay takes up.
+    auto getByteSize() const -> std::size_t;
+
+private:
+    friend class ReplayPlayer;
+
+    const std::uint8_t *data;
+    std::size_t size;
+
+    //! Get 32-bit word `index` from the start of the replay.
+    auto word(std::size_t index) const -> std::uint32_t;
+
+};
+
+//! Plays a replay back through Tron.
+class ReplayPlayer
+{
+public:
+    //! Set up the game at tick 0; `replay`'s bytes must outlive this.
+    explicit ReplayPlayer(const Replay &replay);
+
+    //! Get the game as of the current tick.
+    auto getTron() const -> const Tron&;
+    //! Get the number of moves played so far.
+    auto getTick() const -> int;
+    //! Play the next move.
+    /*!
+     * \return Whether any moves are left.
+     */
+    auto step() -> bool;
+    //! Go to `tick`, clamped to the length of the game.
+    /*!
+     * Starts from the last keyframe before `tick` unless that is
+     * further back than the current tick, then plays forward.
+     */
+    void seek(int tick);
+
+private:
+    const Replay replay;
+    std::unique_ptr<Tron> tron;
+    int tick{0};
+    //! Offset of the next run in the stream.
+    std::size_t offset;
+    //! Ticks left of the current run.
+    int runLeft{0};
+    //! Directions of the current run.
+    std::vector<Player::Direction> directions;
+
+    //! Decode the run at `offset`.
+    void readRun();
+    //! Rebuild the game from keyframe `keyframe`.
+    void restore(int keyframe);
+
+};
+
+//! Memory-maps a file of replays.
+/*!
+ * Replays are read straight from the mapping, so opening even a
+ * large corpus only walks from one header to the next.
+ */
+class ReplayFile
+{
+public:
+    explicit ReplayFile(const std::string &path);
+    ~ReplayFile();
+    ReplayFile(const ReplayFile&) = delete;
+    auto operator=(const ReplayFile&) -> ReplayFile& = delete;
+
+    //! Get the number of replays in the file.
+    auto getReplayCount() const -> std::size_t;
+    //! Get replay `index`, valid while the file is open.
+    auto getReplay(std::size_t index) const -> Replay;
+
+private:
+    const std::uint8_t *data{nullptr};
+    std::size_t size{0};
+    //! Where each replay starts.
+    std::vector<std::size_t> offsets;
+    //! File contents, where memory-mapping isn't available.
+    std::vector<std::uint8_t> buffer;
+
+    //! Release the mapping, if any.
+    void unmap();
+
+};
+
+#endif // REPLAY_H
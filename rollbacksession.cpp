@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "rollbacksession.h"
+
+namespace {
+
+typedef Player::Direction Direction;
+
+/* Datagram layout, integers little-endian:
+ *
+ *     0  magic, 'T'
+ *     1  version
+ *     2  seat of the sender
+ *     3  ticks the sender is ahead of the receiver, signed
+ *     4  map width, 16 bits
+ *     6  map height, 16 bits
+ *     8  inputs of the receiver's seat the sender has, 32 bits
+ *    12  tick of the first input, 32 bits
+ *    16  input count, 16 bits
+ *    18  one Direction per input
+ */
+const std::uint8_t MAGIC = 'T';
+const std::uint8_t VERSION = 1;
+const std::size_t HEADER_SIZE = 18;
+//! Most inputs in one datagram; more go in the next.
+const std::size_t MAX_INPUTS = UdpChannel::MAX_DATAGRAM_SIZE - HEADER_SIZE;
+//! Updates to keep answering peers after the game has finished.
+const int LINGER_UPDATES = 25;
+//! Fewest ticks between ticks skipped to let the others catch up.
+const int SKIP_INTERVAL = 8;
+
+auto get16(const std::uint8_t *bytes) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8;
+}
+
+auto get32(const std::uint8_t *bytes) -> std::uint32_t
+{
+    return get16(bytes) | get16(bytes + 2) << 16;
+}
+
+void put16(std::uint8_t *bytes, std::uint32_t value)
+{
+    bytes[0] = static_cast<std::uint8_t>(value);
+    bytes[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void put32(std::uint8_t *bytes, std::uint32_t value)
+{
+    put16(bytes, value);
+    put16(bytes + 2, value >> 16);
+}
+
+//! Check if `direction` is a turn a player heading `current` can make.
+auto isTurn(Direction direction, Direction current) -> bool
+{
+    return direction != Direction::None
+            && direction != current
+            && direction != Player::opposite(current);
+}
+
+//! Get a direction from `position` that circles the map's centre.
+/*!
+ * Starting positions are symmetric about the centre, so nobody
+ * starts off heading straight for anyone else.
+ */
+auto startDirection(Point position, Size mapSize) -> Direction
+{
+    bool left = 2 * position.x < mapSize.width;
+    bool top = 2 * position.y < mapSize.height;
+    if (top) {
+        return left ? Direction::Right : Direction::Down;
+    }
+    return left ? Direction::Up : Direction::Left;
+}
+
+} // namespace
+
+RollbackSession::RollbackSession(Tron &tron, const NetConfig &config)
+    : tron(tron)
+    , config(config)
+    , seatCount(static_cast<int>(config.peers.size()))
+    , channel(config.localSeat >= 0 && config.localSeat < seatCount
+              ? config.peers[config.localSeat].port : 0)
+    , inputs(seatCount)
+    , acknowledged(seatCount, 0)
+    , remoteAdvantage(seatCount, 0)
+    , heard(seatCount, false)
+    , lastHeard(seatCount)
+{
+    if (config.localSeat < 0 || config.localSeat >= seatCount) {
+        throw std::logic_error{"Bad local seat."};
+    }
+    if (seatCount != tron.getPlayerCount()) {
+        throw std::logic_error{"Need one peer per player."};
+    }
+    if (tron.getTick() != 0) {
+        throw std::logic_error{"Game already started."};
+    }
+    channel.setConditions(config.conditions, static_cast<std::uint32_t>(config.localSeat));
+    tron.setRewindLimit(std::max(1, config.maxRollback));
+    for (int i = 0; i < seatCount; ++i) {
+        tron.turn(i, startDirection(tron.getPosition(i), tron.getMapSize()));
+    }
+    heard[config.localSeat] = true;
+}
+
+void RollbackSession::queueTurn(Player::Direction direction)
+{
+    localTurns.push(InputEvent{direction, 0});
+}
+
+auto RollbackSession::update() -> bool
+{
+    receive();
+    if (lostSeat < 0 && !isFinished()) {
+        lostSeat = findSilentSeat();
+    }
+    if (lostSeat >= 0) {
+        return false;
+    }
+    int tick = tron.getTick();
+    if (mispredicted < tick) {
+        // Back to the first tick we guessed wrong, and forward again
+        tron.rewind(tick - mispredicted);
+        ++rollbackCount;
+        while (tron.getTick() < tick && !tron.gameIsOver()) {
+            simulate();
+            ++replayedTicks;
+        }
+    }
+    if (started && !tron.gameIsOver()) {
+        if (mayAdvance()) {
+            std::vector<std::uint8_t> &ours = inputs[config.localSeat];
+            // A game thought over and then rewound already has our inputs
+            if (ours.size() == static_cast<std::size_t>(tron.getTick())) {
+                ours.push_back(static_cast<std::uint8_t>(nextLocalInput()));
+            }
+            simulate();
+        } else {
+            ++waitCount;
+        }
+    }
+    mispredicted = tron.getTick();
+    send();
+
+    if (!isFinished()) {
+        lingered = 0;
+        return true;
+    }
+    bool settled = true;
+    for (int seat = 0; seat < seatCount; ++seat) {
+        settled = settled && (seat == config.localSeat
+                              || acknowledged[seat] >= inputs[config.localSeat].size());
+    }
+    return !settled && ++lingered < LINGER_UPDATES;
+}
+
+void RollbackSession::receive()
+{
+    NetAddress from;
+    std::vector<std::uint8_t> datagram;
+    Size mapSize = tron.getMapSize();
+    while (channel.receive(from, datagram)) {
+        if (datagram.size() < HEADER_SIZE
+                || datagram[0] != MAGIC || datagram[1] != VERSION) {
+            continue;
+        }
+        int seat = datagram[2];
+        // Only listen to peers at their own address, playing the same map
+        if (seat >= seatCount || seat == config.localSeat
+                || from != config.peers[seat]
+                || get16(&datagram[4]) != static_cast<std::uint32_t>(mapSize.width)
+                || get16(&datagram[6]) != static_cast<std::uint32_t>(mapSize.height)) {
+            continue;
+        }
+        heard[seat] = true;
+        lastHeard[seat] = std::chrono::steady_clock::now();
+        started = std::find(heard.begin(), heard.end(), false) == heard.end();
+        remoteAdvantage[seat] = static_cast<std::int8_t>(datagram[3]);
+        acknowledged[seat] = std::max<std::size_t>(
+                    acknowledged[seat],
+                    std::min<std::size_t>(get32(&datagram[8]), inputs[config.localSeat].size()));
+        readInputs(seat, datagram);
+    }
+}
+
+/*!
+ * Inputs we already have are skipped; a datagram that starts past
+ * the end of what we have leaves a gap and is ignored, as the next
+ * one will repeat what was missed.
+ */
+void RollbackSession::readInputs(int seat, const std::vector<std::uint8_t> &datagram)
+{
+    std::size_t first = get32(&datagram[12]);
+    std::size_t count = get16(&datagram[16]);
+    std::vector<std::uint8_t> &known = inputs[seat];
+    if (HEADER_SIZE + count > datagram.size() || first > known.size()) {
+        return;
+    }
+    for (std::size_t i = known.size() - first; i < count; ++i) {
+        std::uint8_t input = datagram[HEADER_SIZE + i];
+        if (input > static_cast<std::uint8_t>(Direction::Right)) {
+            return;
+        }
+        int tick = static_cast<int>(known.size());
+        known.push_back(input);
+        // Ticks already played guessed this seat went straight on
+        if (tick < tron.getTick() && input != static_cast<std::uint8_t>(Direction::None)) {
+            mispredicted = std::min(mispredicted, tick);
+        }
+    }
+}
+
+void RollbackSession::send()
+{
+    Size mapSize = tron.getMapSize();
+    const std::vector<std::uint8_t> &ours = inputs[config.localSeat];
+    std::vector<std::uint8_t> datagram;
+    for (int seat = 0; seat < seatCount; ++seat) {
+        if (seat == config.localSeat) {
+            continue;
+        }
+        std::size_t first = acknowledged[seat];
+        std::size_t count = std::min(ours.size() - first, MAX_INPUTS);
+        datagram.assign(HEADER_SIZE, 0);
+        datagram[0] = MAGIC;
+        datagram[1] = VERSION;
+        datagram[2] = static_cast<std::uint8_t>(config.localSeat);
+        datagram[3] = static_cast<std::uint8_t>(
+                    static_cast<std::int8_t>(std::max(-128, std::min(advantageOver(seat), 127))));
+        put16(&datagram[4], static_cast<std::uint32_t>(mapSize.width));
+        put16(&datagram[6], static_cast<std::uint32_t>(mapSize.height));
+        put32(&datagram[8], static_cast<std::uint32_t>(inputs[seat].size()));
+        put32(&datagram[12], static_cast<std::uint32_t>(first));
+        put16(&datagram[16], static_cast<std::uint32_t>(count));
+        datagram.insert(datagram.end(), ours.begin() + first, ours.begin() + first + count);
+        channel.send(config.peers[seat], datagram.data(), datagram.size());
+    }
+}
+
+/*!
+ * A peer that has sent inputs past the current tick isn't needed
+ * yet, even if quiet: it may have finished and left while this
+ * peer is still catching up.
+ */
+auto RollbackSession::findSilentSeat() const -> int
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (int seat = 0; seat < seatCount; ++seat) {
+        if (seat != config.localSeat && heard[seat] && advantageOver(seat) >= 0
+                && now - lastHeard[seat] > config.silenceTimeout) {
+            return seat;
+        }
+    }
+    return -1;
+}
+
+/*!
+ * Peers start up to a one-way trip apart and their clocks drift,
+ * so one can end up ahead of the rest, guessing more and rolling
+ * back further. Each tells the others how far ahead of them it
+ * is; whoever is further ahead than the other skips a tick.
+ */
+auto RollbackSession::mayAdvance() -> bool
+{
+    for (int seat = 0; seat < seatCount; ++seat) {
+        if (seat == config.localSeat) {
+            continue;
+        }
+        int advantage = advantageOver(seat);
+        if (advantage >= config.maxRollback) {
+            return false;
+        }
+        // What the other said is a trip old, so give it time to catch up
+        if (advantage - remoteAdvantage[seat] >= 2 && sinceSkip >= SKIP_INTERVAL) {
+            sinceSkip = 0;
+            return false;
+        }
+    }
+    ++sinceSkip;
+    return true;
+}
+
+/*!
+ * Like Tron::applyInputs(): turns that would change nothing are
+ * skipped without using up the tick.
+ */
+auto RollbackSession::nextLocalInput() -> Player::Direction
+{
+    Direction current = tron.getDirection(config.localSeat);
+    InputEvent event;
+    while (localTurns.pop(event)) {
+        if (tron.getIsPlaying(config.localSeat) && isTurn(event.direction, current)) {
+            return event.direction;
+        }
+    }
+    return Direction::None;
+}
+
+void RollbackSession::simulate()
+{
+    std::size_t tick = static_cast<std::size_t>(tron.getTick());
+    for (int seat = 0; seat < seatCount; ++seat) {
+        Direction input = tick < inputs[seat].size()
+                ? static_cast<Direction>(inputs[seat][tick]) : Direction::None;
+        if (tron.getIsPlaying(seat) && isTurn(input, tron.getDirection(seat))) {
+            tron.turn(seat, input);
+        }
+    }
+    tron.step();
+}
+
+auto RollbackSession::advantageOver(int seat) const -> int
+{
+    return tron.getTick() - static_cast<int>(inputs[seat].size());
+}
+
+auto RollbackSession::getLocalSeat() const -> int
+{
+    return config.localSeat;
+}
+
+auto RollbackSession::isStarted() const -> bool
+{
+    return started;
+}
+
+auto RollbackSession::isFinished() const -> bool
+{
+    return tron.gameIsOver() && getConfirmedTick() >= tron.getTick();
+}
+
+auto RollbackSession::getLostSeat() const -> int
+{
+    return lostSeat;
+}
+
+auto RollbackSession::getConfirmedTick() const -> int
+{
+    int confirmed = tron.getTick();
+    for (const std::vector<std::uint8_t> &known : inputs) {
+        confirmed = std::min(confirmed, static_cast<int>(known.size()));
+    }
+    return confirmed;
+}
+
+auto RollbackSession::getRollbackCount() const -> long
+{
+    return rollbackCount;
+}
+
+auto RollbackSession::getReplayedTicks() const -> long
+{
+    return replayedTicks;
+}
+
+auto RollbackSession::getWaitCount() const -> long
+{
+    return waitCount;
+}
+
+// Constants
+const int NetConfig::ROLLBACK_WINDOW{32};
+const std::chrono::milliseconds NetConfig::SILENCE_TIMEOUT{5000};
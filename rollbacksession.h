@@ -0,0 +1,146 @@
+#ifndef ROLLBACKSESSION_H
+#define ROLLBACKSESSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "tron.h"
+#include "inputqueue.h"
+#include "udpchannel.h"
+
+//! How to take part in a networked game.
+struct NetConfig
+{
+    //! Address of every peer, one per seat, the same list for all.
+    std::vector<NetAddress> peers;
+    //! Seat played here; its address is the port listened on.
+    int localSeat{0};
+    //! Trouble to simulate on datagrams sent from here.
+    LinkConditions conditions;
+    //! Most ticks a peer's input may be predicted before waiting for it.
+    int maxRollback{ROLLBACK_WINDOW};
+    //! Longest a peer may go unheard before it is given up as lost.
+    std::chrono::milliseconds silenceTimeout{SILENCE_TIMEOUT};
+
+    static const int ROLLBACK_WINDOW;
+    static const std::chrono::milliseconds SILENCE_TIMEOUT;
+};
+
+//! Keeps one Tron in step with the same game on other machines.
+/*!
+ * Every peer plays one seat. Each tick its turn (or lack of one)
+ * is sent to all the others over UDP, and nobody waits to hear
+ * back: seats played elsewhere are predicted to go straight on.
+ * When a turn arrives for a tick already simulated, the game is
+ * rewound to that tick and played forward again with it, which
+ * is only correct because Tron is fully deterministic.
+ *
+ * Datagrams carry every input the receiver hasn't acknowledged
+ * yet, so lost ones need no resending of their own. A peer only
+ * stops to wait when another has gone quiet for longer than the
+ * rollback window, and holds back a tick now and then if it is
+ * further ahead of the others than they are of it.
+ *
+ * A peer that quits or drops off the network can't be told apart
+ * from one that is only slow, so once one has gone unheard for
+ * longer than the silence timeout the session ends, and
+ * getLostSeat() says who was lost. The game can't go on without
+ * that seat's inputs, as the others would no longer agree on it.
+ */
+class RollbackSession
+{
+public:
+    //! Play `config.localSeat` of `tron`, a game that hasn't started.
+    /*!
+     * `tron` needs a seat per peer and is driven by update() from
+     * now on. Every player is started heading round the map, as
+     * there is no waiting for everyone to press a key.
+     */
+    RollbackSession(Tron &tron, const NetConfig &config);
+
+    //! Queue a turn for the local seat (one input thread only).
+    void queueTurn(Player::Direction direction);
+    //! Exchange inputs and play the next tick, if it's time to.
+    /*!
+     * Call once per tick. After the game is over, keep calling it
+     * until it returns false so the other peers can finish too.
+     * \return Whether this peer still has a part to play; false
+     * as well once a peer is lost.
+     */
+    auto update() -> bool;
+
+    auto getLocalSeat() const -> int; //!< Get the seat played here.
+    //! Check if every peer has been heard from.
+    auto isStarted() const -> bool;
+    //! Check if the game is over with every input known.
+    auto isFinished() const -> bool;
+    //! Get the seat of the peer that went quiet and ended the session, or -1.
+    /*!
+     * Peers not heard from at all yet are waited for however long
+     * they take, as they may not have been started yet.
+     */
+    auto getLostSeat() const -> int;
+    //! Get the number of ticks every seat's input is known for.
+    auto getConfirmedTick() const -> int;
+    //! Get how many times the game was rewound to correct a guess.
+    auto getRollbackCount() const -> long;
+    //! Get how many ticks were played again after rewinding.
+    auto getReplayedTicks() const -> long;
+    //! Get how many updates waited rather than playing a tick.
+    auto getWaitCount() const -> long;
+
+private:
+    Tron &tron;
+    const NetConfig config;
+    const int seatCount;
+    UdpChannel channel;
+    //! Turns made here, waiting to be given a tick.
+    InputQueue localTurns;
+    //! Direction each seat turned to at each tick, or None.
+    /*!
+     * Only inputs actually received are here, in order, so each
+     * list's length is how many ticks of that seat are known.
+     */
+    std::vector<std::vector<std::uint8_t>> inputs;
+    //! How many of our inputs each peer has acknowledged.
+    std::vector<std::size_t> acknowledged;
+    //! How many ticks each peer said it was ahead of us.
+    std::vector<int> remoteAdvantage;
+    //! Whether each peer has been heard from.
+    std::vector<bool> heard;
+    //! When each peer was last heard from.
+    std::vector<std::chrono::steady_clock::time_point> lastHeard;
+    bool started{false};
+    //! Seat of the peer given up as lost, or -1.
+    int lostSeat{-1};
+    //! Earliest tick simulated with a wrong guess, or the current tick.
+    int mispredicted{0};
+    //! Updates since the game finished.
+    int lingered{0};
+    //! Ticks played since one was last skipped to let others catch up.
+    int sinceSkip{0};
+    long rollbackCount{0};
+    long replayedTicks{0};
+    long waitCount{0};
+
+    //! Read every datagram waiting and note what it tells us.
+    void receive();
+    //! Take in the inputs of one datagram from `seat`.
+    void readInputs(int seat, const std::vector<std::uint8_t> &datagram);
+    //! Send each peer the inputs it hasn't acknowledged.
+    void send();
+    //! Get a peer heard from before but not for the silence timeout, or -1.
+    auto findSilentSeat() const -> int;
+    //! Check if we may play another tick without waiting.
+    auto mayAdvance() -> bool;
+    //! Pick the local seat's input for the next tick.
+    auto nextLocalInput() -> Player::Direction;
+    //! Apply the inputs known or guessed for the next tick and step.
+    void simulate();
+    //! Get how many ticks ahead we are of what `seat` has sent.
+    auto advantageOver(int seat) const -> int;
+
+};
+
+#endif // ROLLBACKSESSION_H
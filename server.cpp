@@ -0,0 +1,671 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "controller.h"
+#include "matchshard.h"
+#include "tron.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef MatchShard::Command Command;
+
+//! Most seats in a match a client may ask for.
+const int MAX_SEATS = 16;
+//! Longest side of a map a client may ask for.
+const int MAX_MAP_SIDE = 1000;
+
+struct Options
+{
+    std::uint16_t port = 4500;
+    int workers = std::max(1u, std::thread::hardware_concurrency());
+    int tickInterval = 80;
+    ControllerFactory bot = findController("cautious");
+    int botMatches = 0;
+    int players = 2;
+    Size mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
+    int statsInterval = 0;
+    int duration = 0;
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  --port P         TCP port to listen on (default 4500)\n"
+              << "  --workers N      match threads, one per core (default: all cores)\n"
+              << "  --tick MS        milliseconds per tick (default 80)\n"
+              << "  --bot-matches N  keep N matches of bots going, for load testing\n"
+              << "  --players N      seats in each bot match (default 2)\n"
+              << "  --size N         N x N map for bot matches\n"
+              << "  --stats S        print load every S seconds\n"
+              << "  --duration S     stop after S seconds (default: run until killed)\n"
+              << "  --bot NAME       controller of bot seats (default cautious):";
+    for (const NamedController &controller : builtinControllers()) {
+        std::cerr << " " << controller.name;
+    }
+    std::cerr << "\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--port") == 0) {
+            options.port = static_cast<std::uint16_t>(value);
+        } else if (std::strcmp(argv[i], "--workers") == 0) {
+            options.workers = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--tick") == 0) {
+            options.tickInterval = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--bot") == 0) {
+            options.bot = findController(argv[i + 1]);
+            if (!options.bot) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--bot-matches") == 0) {
+            options.botMatches = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--players") == 0) {
+            options.players = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--size") == 0) {
+            options.mapSize = Size{static_cast<int>(value), static_cast<int>(value)};
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            options.statsInterval = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--duration") == 0) {
+            options.duration = static_cast<int>(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options.workers > 0 && options.tickInterval > 0 && options.botMatches >= 0;
+}
+
+//! Check if a match of `playerCount` on `mapSize` may be played.
+auto isPlayable(Size mapSize, int playerCount) -> bool
+{
+    return playerCount >= Tron::MIN_PLAYER_COUNT && playerCount <= MAX_SEATS
+            && mapSize.width >= Tron::MIN_MAP_WIDTH && mapSize.width <= MAX_MAP_SIDE
+            && mapSize.height >= Tron::MIN_MAP_HEIGHT && mapSize.height <= MAX_MAP_SIDE;
+}
+
+//! Parse a direction as sent by clients.
+auto parseDirection(const std::string &text) -> Player::Direction
+{
+    if (text == "U") {
+        return Player::Direction::Up;
+    } else if (text == "D") {
+        return Player::Direction::Down;
+    } else if (text == "L") {
+        return Player::Direction::Left;
+    } else if (text == "R") {
+        return Player::Direction::Right;
+    }
+    return Player::Direction::None;
+}
+
+//! Accepts clients, pairs them up and relays between them and the shards.
+/*!
+ * One thread runs every socket through epoll; matches never touch
+ * a socket, and this thread never touches a match. A client is a
+ * TCP connection speaking lines of text:
+ *
+ *     -> JOIN [players [width height]]   queue for a match
+ *     -> TURN U|D|L|R                    turn, once playing
+ *     -> WATCH match                     spectate a match
+ *     <- START seat players width height match
+ *     <- TICK tick x,y ...               head of every seat, - if out
+ *     <- OVER winner                     -1 for a tie
+ *     <- WATCHING                        spectator frames follow
+ *     <- ERROR message
+ *
+ * Seats of clients that disconnect are played on by a bot. After
+ * WATCHING the connection carries nothing but spectator feed
+ * frames, and is closed when the match ends.
+ *
+ * A match id says which shard hosts it, so nothing has to keep
+ * track of where matches are.
+ */
+class Server
+{
+public:
+    explicit Server(const Options &options);
+    ~Server();
+    Server(const Server&) = delete;
+    auto operator=(const Server&) -> Server& = delete;
+
+    //! Serve until `duration` has passed, or forever if it's zero.
+    void run(std::chrono::seconds duration);
+
+private:
+    //! Where a client is up to.
+    struct Client
+    {
+        int descriptor;
+        //! Received and not yet a whole line.
+        std::string input;
+        //! Lines waiting for the socket to take them.
+        std::deque<std::shared_ptr<const std::string>> output;
+        //! Bytes of the first line of `output` already sent.
+        std::size_t sent{0};
+        //! Bytes in `output` not yet sent.
+        std::size_t backlog{0};
+        //! Whether epoll is watching for the socket becoming writable.
+        bool blocked{false};
+        //! Match being played or watched, or 0.
+        std::uint64_t match{0};
+        MatchShard *shard{nullptr};
+        int seat{0};
+        //! Whether it's waiting in a lobby.
+        bool waiting{false};
+        //! Whether it's spectating `match`.
+        bool watching{false};
+        //! Whether to hang up once `output` is sent.
+        bool closing{false};
+        std::tuple<int, int, int> lobby;
+    };
+
+    const Options options;
+    int listener{-1};
+    int epoll{-1};
+    //! Signalled by shards with messages to collect.
+    int wake{-1};
+    std::vector<std::unique_ptr<MatchShard>> shards;
+    std::unordered_map<std::uint64_t, Client> clients;
+    //! Clients waiting for a match, by seat count and map size.
+    std::map<std::tuple<int, int, int>, std::vector<std::uint64_t>> lobbies;
+    std::uint64_t nextClient{FIRST_CLIENT};
+    //! Next match id, before spreading ids over the shards.
+    std::uint64_t nextMatch{1};
+    std::vector<MatchShard::Message> messages;
+
+    void accept();
+    //! Read what `client` sent and act on each whole line.
+    void receive(std::uint64_t id);
+    //! Act on each whole line `id` has sent, keeping the rest.
+    /*!
+     * Drops the client if the rest is longer than MAX_LINE.
+     * \return Whether the client is still connected.
+     */
+    auto takeLines(std::uint64_t id) -> bool;
+    void command(std::uint64_t id, const std::string &line);
+    void join(std::uint64_t id, int playerCount, Size mapSize);
+    void watch(std::uint64_t id, std::uint64_t match);
+    //! Pick an id for a new match on shard `shard`.
+    auto newMatch(std::size_t shard) -> std::uint64_t;
+    //! Hand messages from the shards to their clients.
+    void deliver();
+    //! Queue `text` for `client` and send what the socket will take.
+    void queue(std::uint64_t id, std::shared_ptr<const std::string> text);
+    //! Send as much of the backlog of `id` as the socket will take.
+    /*!
+     * \return Whether the client is still connected.
+     */
+    auto flush(std::uint64_t id) -> bool;
+    void drop(std::uint64_t id);
+    void printStats(long ticks, std::chrono::duration<double> elapsed);
+
+    //! epoll data of the listening socket and the wake-up event.
+    static const std::uint64_t LISTENER;
+    static const std::uint64_t WAKE;
+    static const std::uint64_t FIRST_CLIENT;
+    //! Most bytes a slow client may fall behind by before it's dropped.
+    static const std::size_t MAX_BACKLOG;
+    //! Longest line a client may send.
+    static const std::size_t MAX_LINE;
+};
+
+Server::Server(const Options &options)
+    : options(options)
+{
+    listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    epoll = ::epoll_create1(0);
+    wake = ::eventfd(0, EFD_NONBLOCK);
+    if (listener < 0 || epoll < 0 || wake < 0) {
+        throw std::runtime_error{"Can't create sockets."};
+    }
+    int yes = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(options.port);
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0
+            || ::listen(listener, SOMAXCONN) != 0) {
+        throw std::runtime_error{"Can't listen on TCP port " + std::to_string(options.port) + "."};
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+    event.data.u64 = WAKE;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, wake, &event);
+
+    int wakeDescriptor = wake;
+    std::function<void()> notify = [wakeDescriptor] {
+        std::uint64_t one = 1;
+        ssize_t written = ::write(wakeDescriptor, &one, sizeof(one));
+        static_cast<void>(written);
+    };
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < options.workers; ++i) {
+        shards.emplace_back(new MatchShard{std::chrono::milliseconds{options.tickInterval},
+                                           options.bot, notify});
+    }
+    // Bot matches are numbered from 1, so they're easy to watch
+    std::vector<std::vector<std::uint64_t>> botMatches(shards.size());
+    for (int id = 1; id <= options.botMatches; ++id) {
+        botMatches[id % shards.size()].push_back(static_cast<std::uint64_t>(id));
+    }
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        shards[i]->hostBotMatches(botMatches[i], options.mapSize, options.players);
+    }
+    nextMatch = static_cast<std::uint64_t>(options.botMatches) / shards.size() + 1;
+    for (int i = 0; i < options.workers; ++i) {
+        shards[i]->start(i % cores);
+    }
+}
+
+Server::~Server()
+{
+    for (std::unique_ptr<MatchShard> &shard : shards) {
+        shard->stop();
+    }
+    for (auto &entry : clients) {
+        ::close(entry.second.descriptor);
+    }
+    ::close(wake);
+    ::close(epoll);
+    ::close(listener);
+}
+
+void Server::run(std::chrono::seconds duration)
+{
+    Clock::time_point started = Clock::now();
+    Clock::time_point lastStats = started;
+    long lastTicks = 0;
+    std::vector<epoll_event> events(256);
+    for (;;) {
+        Clock::time_point now = Clock::now();
+        if (duration.count() > 0 && now - started >= duration) {
+            break;
+        }
+        if (options.statsInterval > 0
+                && now - lastStats >= std::chrono::seconds{options.statsInterval}) {
+            long ticks = 0;
+            for (const std::unique_ptr<MatchShard> &shard : shards) {
+                ticks += shard->getTickCount();
+            }
+            printStats(ticks - lastTicks, now - lastStats);
+            lastStats = now;
+            lastTicks = ticks;
+        }
+
+        // Wake up at least once a second to check the time
+        int count = ::epoll_wait(epoll, events.data(), static_cast<int>(events.size()), 1000);
+        if (count < 0 && errno != EINTR) {
+            throw std::runtime_error{"epoll_wait failed."};
+        }
+        for (int i = 0; i < count; ++i) {
+            std::uint64_t id = events[i].data.u64;
+            if (id == LISTENER) {
+                accept();
+            } else if (id == WAKE) {
+                std::uint64_t signalled;
+                ssize_t read = ::read(wake, &signalled, sizeof(signalled));
+                static_cast<void>(read);
+                deliver();
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                drop(id);
+            } else {
+                if ((events[i].events & EPOLLOUT) && !flush(id)) {
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    receive(id);
+                }
+            }
+        }
+    }
+
+    long ticks = 0;
+    for (const std::unique_ptr<MatchShard> &shard : shards) {
+        ticks += shard->getTickCount();
+    }
+    printStats(ticks, Clock::now() - started);
+}
+
+void Server::accept()
+{
+    for (;;) {
+        int descriptor = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK);
+        if (descriptor < 0) {
+            return;
+        }
+        std::uint64_t id = nextClient++;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        ::epoll_ctl(epoll, EPOLL_CTL_ADD, descriptor, &event);
+        clients.emplace(id, Client{});
+        clients[id].descriptor = descriptor;
+    }
+}
+
+/*!
+ * Lines are acted on after every read, so a client is dropped as
+ * soon as what's left of its input runs past MAX_LINE, rather than
+ * after it has filled memory with one endless line.
+ */
+void Server::receive(std::uint64_t id)
+{
+    char buffer[4096];
+    for (;;) {
+        auto found = clients.find(id);
+        if (found == clients.end()) {
+            return;
+        }
+        ssize_t size = ::recv(found->second.descriptor, buffer, sizeof(buffer), 0);
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            drop(id);
+            return;
+        }
+        if (size < 0) {
+            return;
+        }
+        found->second.input.append(buffer, static_cast<std::size_t>(size));
+        if (!takeLines(id)) {
+            return;
+        }
+    }
+}
+
+auto Server::takeLines(std::uint64_t id) -> bool
+{
+    std::unordered_map<std::uint64_t, Client>::iterator found;
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    // Commands may drop the client, so look it up again for every line
+    while ((found = clients.find(id)) != clients.end()
+           && (end = found->second.input.find('\n', start)) != std::string::npos) {
+        std::string line = found->second.input.substr(start, end - start);
+        start = end + 1;
+        command(id, line);
+    }
+    if (found == clients.end()) {
+        return false;
+    }
+    found->second.input.erase(0, start);
+    if (found->second.input.size() > MAX_LINE) {
+        drop(id);
+        return false;
+    }
+    return true;
+}
+
+void Server::command(std::uint64_t id, const std::string &line)
+{
+    Client &client = clients[id];
+    std::istringstream words{line};
+    std::string verb;
+    words >> verb;
+    if (verb == "JOIN") {
+        int playerCount = 2;
+        Size mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
+        if (words >> playerCount) {
+            words >> mapSize.width >> mapSize.height;
+        }
+        if (client.match != 0 || client.waiting) {
+            queue(id, std::make_shared<const std::string>("ERROR Already joined.\n"));
+        } else if (!isPlayable(mapSize, playerCount)) {
+            queue(id, std::make_shared<const std::string>("ERROR Bad match.\n"));
+        } else {
+            join(id, playerCount, mapSize);
+        }
+    } else if (verb == "TURN") {
+        std::string direction;
+        words >> direction;
+        Command turn{Command::Kind::Turn, client.match, client.seat, parseDirection(direction),
+                     Size{0, 0}, {}};
+        if (client.match == 0 || client.watching || turn.direction == Player::Direction::None) {
+            queue(id, std::make_shared<const std::string>("ERROR Bad turn.\n"));
+        } else {
+            client.shard->post(std::move(turn));
+        }
+    } else if (verb == "WATCH") {
+        std::uint64_t match = 0;
+        if (client.match != 0 || client.waiting) {
+            queue(id, std::make_shared<const std::string>("ERROR Already joined.\n"));
+        } else if (!(words >> match) || match == 0) {
+            queue(id, std::make_shared<const std::string>("ERROR Bad match.\n"));
+        } else {
+            watch(id, match);
+        }
+    } else if (!verb.empty()) {
+        queue(id, std::make_shared<const std::string>("ERROR Unknown command.\n"));
+    }
+}
+
+/*!
+ * A full lobby becomes a match on whichever shard has fewest, so
+ * load stays even as matches come and go.
+ */
+void Server::join(std::uint64_t id, int playerCount, Size mapSize)
+{
+    std::tuple<int, int, int> key{playerCount, mapSize.width, mapSize.height};
+    std::vector<std::uint64_t> &lobby = lobbies[key];
+    lobby.push_back(id);
+    clients[id].waiting = true;
+    clients[id].lobby = key;
+    if (static_cast<int>(lobby.size()) < playerCount) {
+        return;
+    }
+
+    std::size_t index = static_cast<std::size_t>(std::min_element(
+                shards.begin(), shards.end(),
+                [](const std::unique_ptr<MatchShard> &a, const std::unique_ptr<MatchShard> &b) {
+        return a->getMatchCount() < b->getMatchCount();
+    }) - shards.begin());
+    MatchShard *shard = shards[index].get();
+    std::uint64_t match = newMatch(index);
+    for (std::size_t seat = 0; seat < lobby.size(); ++seat) {
+        Client &client = clients[lobby[seat]];
+        client.waiting = false;
+        client.match = match;
+        client.shard = shard;
+        client.seat = static_cast<int>(seat);
+    }
+    shard->post(Command{Command::Kind::Create, match, 0, Player::Direction::None,
+                        mapSize, std::move(lobby)});
+    lobbies.erase(key);
+}
+
+void Server::watch(std::uint64_t id, std::uint64_t match)
+{
+    Client &client = clients[id];
+    client.match = match;
+    client.shard = shards[match % shards.size()].get();
+    client.watching = true;
+    client.shard->post(Command{Command::Kind::Watch, match, 0, Player::Direction::None,
+                               Size{0, 0}, {id}});
+}
+
+/*!
+ * Ids are handed out so that `id % shards.size()` is the shard.
+ */
+auto Server::newMatch(std::size_t shard) -> std::uint64_t
+{
+    return nextMatch++ * shards.size() + shard;
+}
+
+void Server::deliver()
+{
+    for (std::unique_ptr<MatchShard> &shard : shards) {
+        shard->collect(messages);
+    }
+    for (MatchShard::Message &message : messages) {
+        auto found = clients.find(message.client);
+        if (found == clients.end()) {
+            continue;
+        }
+        if (message.last && found->second.watching) {
+            found->second.closing = true;
+        } else if (message.last) {
+            found->second.match = 0;
+            found->second.shard = nullptr;
+        }
+        queue(message.client, std::move(message.text));
+    }
+    messages.clear();
+}
+
+void Server::queue(std::uint64_t id, std::shared_ptr<const std::string> text)
+{
+    Client &client = clients[id];
+    bool idle = client.output.empty();
+    client.backlog += text->size();
+    client.output.push_back(std::move(text));
+    if (client.backlog > MAX_BACKLOG) {
+        drop(id);
+    } else if (idle) {
+        flush(id);
+    }
+}
+
+/*!
+ * Only clients with something left to send are watched for the
+ * socket becoming writable, so idle ones cost nothing.
+ */
+auto Server::flush(std::uint64_t id) -> bool
+{
+    auto found = clients.find(id);
+    if (found == clients.end()) {
+        return false;
+    }
+    Client &client = found->second;
+    while (!client.output.empty()) {
+        const std::string &text = *client.output.front();
+        ssize_t size = ::send(client.descriptor, text.data() + client.sent,
+                              text.size() - client.sent, MSG_NOSIGNAL);
+        if (size < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                drop(id);
+                return false;
+            }
+            break;
+        }
+        client.sent += static_cast<std::size_t>(size);
+        client.backlog -= static_cast<std::size_t>(size);
+        if (client.sent == text.size()) {
+            client.output.pop_front();
+            client.sent = 0;
+        }
+    }
+    if (client.output.empty() && client.closing) {
+        drop(id);
+        return false;
+    }
+    bool blocked = !client.output.empty();
+    if (blocked != client.blocked) {
+        client.blocked = blocked;
+        epoll_event event{};
+        event.events = EPOLLIN | (blocked ? EPOLLOUT : 0u);
+        event.data.u64 = id;
+        ::epoll_ctl(epoll, EPOLL_CTL_MOD, client.descriptor, &event);
+    }
+    return true;
+}
+
+void Server::drop(std::uint64_t id)
+{
+    auto found = clients.find(id);
+    if (found == clients.end()) {
+        return;
+    }
+    Client &client = found->second;
+    if (client.waiting) {
+        std::vector<std::uint64_t> &lobby = lobbies[client.lobby];
+        lobby.erase(std::find(lobby.begin(), lobby.end(), id));
+        if (lobby.empty()) {
+            lobbies.erase(client.lobby);
+        }
+    } else if (client.watching && !client.closing) {
+        client.shard->post(Command{Command::Kind::Unwatch, client.match, 0,
+                                   Player::Direction::None, Size{0, 0}, {id}});
+    } else if (client.match != 0) {
+        client.shard->post(Command{Command::Kind::Leave, client.match, client.seat,
+                                   Player::Direction::None, Size{0, 0}, {}});
+    }
+    ::epoll_ctl(epoll, EPOLL_CTL_DEL, client.descriptor, nullptr);
+    ::close(client.descriptor);
+    clients.erase(found);
+}
+
+void Server::printStats(long ticks, std::chrono::duration<double> elapsed)
+{
+    int matches = 0;
+    for (const std::unique_ptr<MatchShard> &shard : shards) {
+        matches += shard->getMatchCount();
+    }
+    double seconds = std::max(elapsed.count(), 1e-9);
+    std::cout << "matches: " << matches
+              << "  clients: " << clients.size()
+              << "  match ticks/s: " << static_cast<long>(ticks / seconds) << std::endl;
+}
+
+// Constants
+const std::uint64_t Server::LISTENER{0};
+const std::uint64_t Server::WAKE{1};
+const std::uint64_t Server::FIRST_CLIENT{2};
+const std::size_t Server::MAX_BACKLOG{1 << 20};
+const std::size_t Server::MAX_LINE{256};
+
+} // namespace
+
+//! Hosts many matches at once for clients connecting over TCP.
+/*!
+ * Matches are spread over a fixed set of worker threads, each
+ * pinned to a core and stepping all of its matches in one batch
+ * per tick; a single epoll loop handles every connection.
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (!isPlayable(options.mapSize, options.players)) {
+            throw std::logic_error{"Bad bot match."};
+        }
+        Server server{options};
+        server.run(std::chrono::seconds{options.duration});
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Dedicated server hosting many matches at once
+# for clients over TCP. Linux only (epoll).
+#
+#-------------------------------------------------
+
+CONFIG -= qt app_bundle
+CONFIG += console thread
+
+TARGET = tron-server
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += server.cpp \
+    matchshard.cpp
+
+HEADERS += matchshard.h
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "match.h"
+#include "matchpool.h"
+#include "replay.h"
+#include "tron.h"
+
+namespace {
+
+struct Options
+{
+    long games = 1000;
+    std::uint32_t seed = 1;
+    Size mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
+    int playerCount = Tron::MIN_PLAYER_COUNT;
+    ControllerFactory controller = findController("random");
+    //! File to write replays of every game to, if any.
+    const char *record = nullptr;
+    //! Ticks between keyframes of recorded replays.
+    int keyframeInterval = ReplayRecorder::DEFAULT_KEYFRAME_INTERVAL;
+    //! File of replays to check instead of playing, if any.
+    const char *check = nullptr;
+    //! Threads each tick may use.
+    int stepThreads = 1;
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  --games N     number of games to play (default 1000)\n"
+              << "  --seed S      seed of the first game (default 1)\n"
+              << "  --width W     map width in tiles\n"
+              << "  --height H    map height in tiles\n"
+              << "  --players P   players per game\n"
+              << "  --record FILE write replays of every game to FILE\n"
+              << "  --keyframe-interval N  ticks between replay keyframes (default 1024)\n"
+              << "  --check FILE  check that seeking in the replays in FILE matches playing them\n"
+              << "  --step-threads N  split each tick of big arenas across N threads\n"
+              << "  --bot NAME    controller for every player (default random):";
+    for (const NamedController &controller : builtinControllers()) {
+        std::cerr << " " << controller.name;
+    }
+    std::cerr << "\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--bot") == 0) {
+            options.controller = findController(argv[i + 1]);
+            if (!options.controller) {
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--record") == 0) {
+            options.record = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--keyframe-interval") == 0) {
+            options.keyframeInterval = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            options.check = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--games") == 0) {
+            options.games = value;
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(value);
+        } else if (std::strcmp(argv[i], "--width") == 0) {
+            options.mapSize.width = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--height") == 0) {
+            options.mapSize.height = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--players") == 0) {
+            options.playerCount = static_cast<int>(value);
+        } else if (std::strcmp(argv[i], "--step-threads") == 0) {
+            options.stepThreads = static_cast<int>(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+//! Check if `a` and `b` are the same game at the same tick.
+auto sameGame(const Tron &a, const Tron &b) -> bool
+{
+    if (a.getTick() != b.getTick() || a.getHash() != b.getHash()) {
+        return false;
+    }
+    for (int i = 0; i < a.getPlayerCount(); ++i) {
+        if (a.getPosition(i) != b.getPosition(i)
+                || a.getDirection(i) != b.getDirection(i)
+                || a.getIsPlaying(i) != b.getIsPlaying(i)
+                || a.getTrail(i).size() != b.getTrail(i).size()
+                || !std::equal(a.getTrail(i).begin(), a.getTrail(i).end(), b.getTrail(i).begin())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * Every replay is played through one tick at a time, and at each
+ * tick a second player seeks there from the start, so keyframes
+ * are restored wherever there are any.
+ * \return The number of replays where seeking went wrong.
+ */
+auto checkReplays(const char *path) -> long
+{
+    ReplayFile file{path};
+    long failed = 0;
+    for (std::size_t r = 0; r < file.getReplayCount(); ++r) {
+        Replay replay = file.getReplay(r);
+        ReplayPlayer played{replay};
+        ReplayPlayer seeking{replay};
+        for (int tick = 0; tick <= replay.getTickCount(); ++tick) {
+            seeking.seek(0);
+            seeking.seek(tick);
+            if (seeking.getTick() != tick || !sameGame(played.getTron(), seeking.getTron())) {
+                std::cerr << "Replay " << r << ": seeking to tick " << tick
+                          << " doesn't match playing to it." << std::endl;
+                ++failed;
+                break;
+            }
+            played.step();
+        }
+    }
+    std::cout << "replays:   " << file.getReplayCount() << "\n"
+              << "failed:    " << failed << std::endl;
+    return failed;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (options.check) {
+        try {
+            return checkReplays(options.check) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        } catch (const std::exception &error) {
+            std::cerr << error.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    long ticks = 0;
+    long draws = 0;
+    auto begin = std::chrono::steady_clock::now();
+    try {
+        std::ofstream replays;
+        if (options.record) {
+            replays.open(options.record, std::ios::binary);
+        }
+        std::vector<ControllerFactory> seats(options.playerCount, options.controller);
+        // Every game is played in the same Tron, reset in between
+        MatchPool pool;
+        for (long game = 0; game < options.games; ++game) {
+            std::uint32_t seed = options.seed + static_cast<std::uint32_t>(game);
+            ReplayRecorder recorder{options.mapSize, options.playerCount, options.keyframeInterval};
+            MatchResult result = playMatch(options.mapSize, seats, seed,
+                                           options.record ? &recorder : nullptr,
+                                           options.stepThreads, &pool);
+            if (options.record) {
+                recorder.write(replays);
+            }
+            ticks += result.ticks;
+            if (result.winner < 0) {
+                ++draws;
+            }
+        }
+        if (options.record && !replays) {
+            throw std::runtime_error{std::string{"Can't write "} + options.record + "."};
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "games:     " << options.games << "\n"
+              << "ticks:     " << ticks << "\n"
+              << "draws:     " << draws << "\n"
+              << "seconds:   " << elapsed.count() << "\n"
+              << "games/sec: " << options.games / elapsed.count() << "\n"
+              << "ticks/sec: " << ticks / elapsed.count() << std::endl;
+    return EXIT_SUCCESS;
+}
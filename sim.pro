@@ -0,0 +1,16 @@
+#-------------------------------------------------
+#
+# Plays seeded games headlessly and reports throughput.
+#
+#-------------------------------------------------
+
+CONFIG -= qt app_bundle
+CONFIG += console
+
+TARGET = tron-sim
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += sim.cpp
@@ -0,0 +1,55 @@
+#ifndef SNAPSHOTEXCHANGE_H
+#define SNAPSHOTEXCHANGE_H
+
+#include <atomic>
+
+//! Hands the newest value of `T` from one writer thread to one reader.
+/*!
+ * A double buffer with a spare slot: the writer fills back() and
+ * publish()es it, the reader acquire()s the newest published value
+ * and reads it through front(). Slots are swapped with a single
+ * atomic exchange, so neither side ever waits for or copies from
+ * the other, and front() stays untouched until the next acquire().
+ */
+template <typename T>
+class SnapshotExchange
+{
+public:
+    //! Get the slot the writer is filling (writer only).
+    auto back() -> T& { return slots[backIndex]; }
+    //! Make back() the newest value and start on a fresh slot (writer only).
+    void publish()
+    {
+        unsigned previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = previous & INDEX;
+    }
+
+    //! Take the newest published value, if there is one (reader only).
+    /*!
+     * \return Whether front() changed.
+     */
+    auto acquire() -> bool
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        unsigned previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX;
+        return true;
+    }
+    //! Get the value last taken by acquire() (reader only).
+    auto front() const -> const T& { return slots[frontIndex]; }
+
+private:
+    static const unsigned INDEX = 3;
+    static const unsigned FRESH = 4;
+
+    T slots[3];
+    //! Slot index of the published value, plus FRESH until it is read.
+    std::atomic<unsigned> middle{1};
+    unsigned backIndex{0};
+    unsigned frontIndex{2};
+
+};
+
+#endif // SNAPSHOTEXCHANGE_H
@@ -0,0 +1,233 @@
+#include <stdexcept>
+
+#include "boardcodec.h"
+#include "spectatorfeed.h"
+
+namespace {
+
+const std::uint8_t SNAPSHOT = 'S';
+const std::uint8_t DELTA = 'D';
+//! Size, kind and the shortest tick.
+const std::size_t MIN_FRAME_SIZE = 6;
+
+//! Start a frame of `kind` at `tick`, leaving room for its size.
+auto beginFrame(std::uint8_t kind, int tick) -> std::vector<std::uint8_t>
+{
+    std::vector<std::uint8_t> frame(4, 0);
+    frame.push_back(kind);
+    putVarint(frame, static_cast<std::uint32_t>(tick));
+    return frame;
+}
+
+//! Fill in the size of `frame` and share it.
+auto endFrame(const std::vector<std::uint8_t> &frame) -> SpectatorFrame
+{
+    std::string bytes(frame.begin(), frame.end());
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<char>(frame.size() >> (8 * i));
+    }
+    return std::make_shared<const std::string>(std::move(bytes));
+}
+
+} // namespace
+
+SpectatorFeed::SpectatorFeed(int snapshotInterval)
+    : snapshotInterval(snapshotInterval > 0 ? snapshotInterval : DEFAULT_SNAPSHOT_INTERVAL)
+{}
+
+/*!
+ * A snapshot is only sent to existing viewers when the game has
+ * jumped; the periodic ones just replace the catch-up history, so
+ * its length is bounded by the snapshot interval.
+ */
+auto SpectatorFeed::update(const Tron &tron) -> SpectatorFrame
+{
+    int now = tron.getTick();
+    if (now == tick && !history.empty()) {
+        return nullptr;
+    }
+    SpectatorFrame frame;
+    if (now == tick + 1 && !history.empty()) {
+        frame = delta(tron);
+        if (now % snapshotInterval == 0) {
+            history.clear();
+            history.push_back(snapshot(tron));
+        } else {
+            history.push_back(frame);
+        }
+    } else {
+        frame = snapshot(tron);
+        history.clear();
+        history.push_back(frame);
+    }
+
+    tick = now;
+    playing.resize(tron.getPlayerCount());
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        playing[i] = tron.getIsPlaying(i);
+    }
+    return frame;
+}
+
+void SpectatorFeed::catchUp(std::vector<SpectatorFrame> &frames) const
+{
+    frames.insert(frames.end(), history.begin(), history.end());
+}
+
+auto SpectatorFeed::snapshot(const Tron &tron) const -> SpectatorFrame
+{
+    std::vector<std::uint8_t> frame = beginFrame(SNAPSHOT, tron.getTick());
+    Size mapSize = tron.getMapSize();
+    putVarint(frame, static_cast<std::uint32_t>(mapSize.width));
+    putVarint(frame, static_cast<std::uint32_t>(mapSize.height));
+    putVarint(frame, static_cast<std::uint32_t>(tron.getPlayerCount()));
+    encodeBoard(tron, frame);
+    return endFrame(frame);
+}
+
+auto SpectatorFeed::delta(const Tron &tron) const -> SpectatorFrame
+{
+    std::vector<std::uint8_t> frame = beginFrame(DELTA, tron.getTick());
+    std::size_t packed = 0;
+    std::vector<std::uint32_t> knockedOut;
+    for (int i = 0; i < tron.getPlayerCount(); ++i) {
+        if (!playing[i]) {
+            continue;
+        }
+        if (packed % 4 == 0) {
+            frame.push_back(0);
+        }
+        frame.back() |= static_cast<std::uint8_t>(
+                    packDirection(tron.getDirection(i)) << (packed % 4 * 2));
+        ++packed;
+        if (!tron.getIsPlaying(i)) {
+            knockedOut.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    putVarint(frame, static_cast<std::uint32_t>(knockedOut.size()));
+    for (std::uint32_t player : knockedOut) {
+        putVarint(frame, player);
+    }
+    return endFrame(frame);
+}
+
+auto SpectatorView::frameSize(const std::uint8_t *data, std::size_t available) -> std::size_t
+{
+    if (available < 4) {
+        return 0;
+    }
+    std::size_t size = static_cast<std::size_t>(data[0])
+            | static_cast<std::size_t>(data[1]) << 8
+            | static_cast<std::size_t>(data[2]) << 16
+            | static_cast<std::size_t>(data[3]) << 24;
+    if (size < MIN_FRAME_SIZE || size > MAX_FRAME_SIZE) {
+        throw std::runtime_error{"Corrupt spectator feed."};
+    }
+    return size;
+}
+
+void SpectatorView::apply(const std::uint8_t *frame, std::size_t size)
+{
+    if (size < MIN_FRAME_SIZE || frameSize(frame, size) != size) {
+        throw std::runtime_error{"Corrupt spectator feed."};
+    }
+    try {
+        if (frame[4] == SNAPSHOT) {
+            applySnapshot(frame, size, 5);
+        } else if (frame[4] == DELTA) {
+            if (tron) {
+                applyDelta(frame, size, 5);
+            }
+        } else {
+            throw std::runtime_error{"Corrupt spectator feed."};
+        }
+    } catch (const std::logic_error&) {
+        // Frames come off the network, so bad ones aren't a bug here
+        throw std::runtime_error{"Corrupt spectator feed."};
+    }
+}
+
+void SpectatorView::applySnapshot(const std::uint8_t *frame, std::size_t size, std::size_t offset)
+{
+    int at = static_cast<int>(getVarint(frame, size, offset));
+    Size mapSize;
+    mapSize.width = static_cast<int>(getVarint(frame, size, offset));
+    mapSize.height = static_cast<int>(getVarint(frame, size, offset));
+    int playerCount = static_cast<int>(getVarint(frame, size, offset));
+    if (tron && (mapSize != tron->getMapSize() || playerCount != tron->getPlayerCount())) {
+        throw std::runtime_error{"Spectator feed changed game."};
+    }
+    // Tron throws on a bad map size or player count
+    std::unique_ptr<Tron> restored{new Tron{mapSize, playerCount}};
+    decodeBoard(frame, size, offset, *restored);
+    restored->placeTick(at);
+    tron = std::move(restored);
+    tick = at;
+    ++snapshotCount;
+}
+
+/*!
+ * The viewer's game plays each delta's moves itself, so who gets
+ * knocked out follows from the rules; the list sent along only
+ * confirms it.
+ */
+void SpectatorView::applyDelta(const std::uint8_t *frame, std::size_t size, std::size_t offset)
+{
+    if (static_cast<int>(getVarint(frame, size, offset)) != tick + 1) {
+        throw std::runtime_error{"Spectator feed out of step."};
+    }
+    std::vector<int> moved;
+    for (int i = 0; i < tron->getPlayerCount(); ++i) {
+        if (!tron->getIsPlaying(i)) {
+            continue;
+        }
+        std::size_t packed = moved.size();
+        if (offset + packed / 4 >= size) {
+            throw std::runtime_error{"Corrupt spectator feed."};
+        }
+        tron->turn(i, unpackDirection(frame[offset + packed / 4] >> (packed % 4 * 2)));
+        moved.push_back(i);
+    }
+    offset += (moved.size() + 3) / 4;
+    tron->step();
+
+    std::uint32_t knockedOut = getVarint(frame, size, offset);
+    std::uint32_t confirmed = 0;
+    for (int i : moved) {
+        if (!tron->getIsPlaying(i)) {
+            if (confirmed == knockedOut
+                    || getVarint(frame, size, offset) != static_cast<std::uint32_t>(i)) {
+                throw std::runtime_error{"Spectator feed out of step."};
+            }
+            ++confirmed;
+        }
+    }
+    if (confirmed != knockedOut) {
+        throw std::runtime_error{"Spectator feed out of step."};
+    }
+    ++tick;
+}
+
+auto SpectatorView::isSynced() const -> bool
+{
+    return tron != nullptr;
+}
+
+auto SpectatorView::getTron() const -> const Tron&
+{
+    return *tron;
+}
+
+auto SpectatorView::getTick() const -> int
+{
+    return tick;
+}
+
+auto SpectatorView::getSnapshotCount() const -> long
+{
+    return snapshotCount;
+}
+
+// Constants
+const int SpectatorFeed::DEFAULT_SNAPSHOT_INTERVAL{256};
+const std::size_t SpectatorView::MAX_FRAME_SIZE{16 << 20};
@@ -0,0 +1,113 @@
+#ifndef SPECTATORFEED_H
+#define SPECTATORFEED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tron.h"
+
+/*! \file
+ * A spectator feed sends a game to viewers one small frame per
+ * tick. Frames are self-delimiting so a stream of them can go
+ * straight down a socket; integers little-endian:
+ *
+ *     0  frame size in bytes, these 4 included, 32 bits
+ *     4  kind, 'S' for a snapshot or 'D' for a delta
+ *     5  tick the frame brings the game to, varint
+ *
+ * A snapshot then has the map width, height and player count as
+ * varints and the board as encodeBoard() lays it out. A delta has
+ * the direction every player in play moved, 2 bits each packed
+ * four to a byte in player order, which is all it takes to know
+ * the tile each left behind and where its head is now; then the
+ * number of players knocked out this tick and each one's index,
+ * as varints.
+ */
+
+//! One encoded frame, shared by every viewer it is sent to.
+typedef std::shared_ptr<const std::string> SpectatorFrame;
+
+//! Encodes a game for any number of viewers as it is played.
+/*!
+ * Each tick is encoded once, however many viewers there are;
+ * the frame is shared, not copied, so sending it to hundreds of
+ * viewers costs a pointer each. Viewers arriving part way through
+ * are caught up from the latest snapshot, taken every so often,
+ * and the deltas since.
+ */
+class SpectatorFeed
+{
+public:
+    //! Ticks between snapshots for viewers to catch up from.
+    static const int DEFAULT_SNAPSHOT_INTERVAL;
+
+    explicit SpectatorFeed(int snapshotInterval = DEFAULT_SNAPSHOT_INTERVAL);
+
+    //! Encode what `tron` did since the last call.
+    /*!
+     * Call after each step(). A game that has moved other than one
+     * tick forward since the last call (the first call, a rewind,
+     * a missed tick) is sent whole as a snapshot.
+     * \return The frame for every viewer, or null if nothing changed.
+     */
+    auto update(const Tron &tron) -> SpectatorFrame;
+    //! Append the frames a viewer joining now needs, oldest first.
+    void catchUp(std::vector<SpectatorFrame> &frames) const;
+
+private:
+    const int snapshotInterval;
+    //! Tick of the game when last updated, or -1.
+    int tick{-1};
+    //! Whether each player was in play when last updated.
+    std::vector<std::uint8_t> playing;
+    //! The latest snapshot and every delta since.
+    std::vector<SpectatorFrame> history;
+
+    auto snapshot(const Tron &tron) const -> SpectatorFrame;
+    auto delta(const Tron &tron) const -> SpectatorFrame;
+};
+
+//! Rebuilds a game from spectator feed frames.
+class SpectatorView
+{
+public:
+    //! Largest frame accepted.
+    static const std::size_t MAX_FRAME_SIZE;
+
+    //! Get the size of the frame at the start of `data`.
+    /*!
+     * \return The size, or 0 if fewer than 4 bytes are available.
+     * \throw std::runtime_error if it can't be a frame.
+     */
+    static auto frameSize(const std::uint8_t *data, std::size_t available) -> std::size_t;
+
+    //! Bring the game up to date with one whole frame.
+    /*!
+     * Deltas arriving before the first snapshot are skipped. Later
+     * snapshots replace the game, and must be of the same map size
+     * and player count as the first.
+     * \throw std::runtime_error if the frame is corrupt or out of step.
+     */
+    void apply(const std::uint8_t *frame, std::size_t size);
+    //! Check if a snapshot has been seen, so there is a game to show.
+    auto isSynced() const -> bool;
+    //! Get the game as of the last frame (only once synced).
+    auto getTron() const -> const Tron&;
+    //! Get the tick of the last frame.
+    auto getTick() const -> int;
+    //! Get how many snapshots have been applied, each replacing the game.
+    auto getSnapshotCount() const -> long;
+
+private:
+    std::unique_ptr<Tron> tron;
+    int tick{0};
+    long snapshotCount{0};
+
+    void applySnapshot(const std::uint8_t *frame, std::size_t size, std::size_t offset);
+    void applyDelta(const std::uint8_t *frame, std::size_t size, std::size_t offset);
+};
+
+#endif // SPECTATORFEED_H
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+
+#include "spectatorlink.h"
+
+#ifdef TRON_HAVE_SOCKETS
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+//! What the server answers a WATCH with before the frames start.
+const std::string WATCHING = "WATCHING\n";
+
+} // namespace
+
+/*!
+ * The server answers with a line of text, then switches to frames
+ * for the rest of the connection.
+ */
+SpectatorLink::SpectatorLink(NetAddress server, std::uint64_t match)
+{
+    descriptor = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (descriptor < 0) {
+        throw std::runtime_error{"Can't create TCP socket."};
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(server.host);
+    address.sin_port = htons(server.port);
+    std::string request = "WATCH " + std::to_string(match) + "\n";
+    if (::connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || ::send(descriptor, request.data(), request.size(), MSG_NOSIGNAL)
+            != static_cast<ssize_t>(request.size())
+            || ::fcntl(descriptor, F_SETFL, ::fcntl(descriptor, F_GETFL) | O_NONBLOCK) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error{"Can't connect to server."};
+    }
+
+    try {
+        Clock::time_point deadline = Clock::now() + CONNECT_TIMEOUT;
+        bool answered = false;
+        while (!view.isSynced()) {
+            std::chrono::milliseconds left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - Clock::now());
+            pollfd ready{descriptor, POLLIN, 0};
+            if (left.count() <= 0 || ::poll(&ready, 1, static_cast<int>(left.count())) <= 0) {
+                throw std::runtime_error{"Server didn't answer."};
+            }
+            receive();
+            auto newline = std::find(buffer.begin(), buffer.end(), '\n');
+            if (!answered && newline != buffer.end()) {
+                std::string answer(buffer.begin(), newline + 1);
+                buffer.erase(buffer.begin(), newline + 1);
+                if (answer != WATCHING) {
+                    answer.pop_back();
+                    throw std::runtime_error{"Server said: " + answer};
+                }
+                answered = true;
+            }
+            if (answered) {
+                applyFrames();
+            }
+            if (!open && !view.isSynced()) {
+                throw std::runtime_error{"Server hung up."};
+            }
+        }
+    } catch (...) {
+        ::close(descriptor);
+        throw;
+    }
+}
+
+SpectatorLink::~SpectatorLink()
+{
+    ::close(descriptor);
+}
+
+void SpectatorLink::receive()
+{
+    std::uint8_t chunk[4096];
+    for (;;) {
+        ssize_t size = ::recv(descriptor, chunk, sizeof(chunk), 0);
+        if (size > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + size);
+        } else {
+            // Closed, failed, or (EAGAIN) nothing more for now
+            open = open && size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            return;
+        }
+    }
+}
+
+#else
+
+SpectatorLink::SpectatorLink(NetAddress, std::uint64_t)
+{
+    throw std::runtime_error{"No networking on this platform."};
+}
+
+SpectatorLink::~SpectatorLink()
+{}
+
+void SpectatorLink::receive()
+{
+    open = false;
+}
+
+#endif // TRON_HAVE_SOCKETS
+
+auto SpectatorLink::poll() -> bool
+{
+    if (open) {
+        receive();
+        applyFrames();
+    }
+    return open;
+}
+
+auto SpectatorLink::getView() const -> const SpectatorView&
+{
+    return view;
+}
+
+void SpectatorLink::applyFrames()
+{
+    std::size_t offset = 0;
+    std::size_t size;
+    while ((size = SpectatorView::frameSize(buffer.data() + offset, buffer.size() - offset)) != 0
+           && offset + size <= buffer.size()) {
+        view.apply(buffer.data() + offset, size);
+        offset += size;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+}
+
+// Constants
+const std::chrono::milliseconds SpectatorLink::CONNECT_TIMEOUT{5000};
@@ -0,0 +1,50 @@
+#ifndef SPECTATORLINK_H
+#define SPECTATORLINK_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "spectatorfeed.h"
+#include "udpchannel.h"
+
+//! Watches a match on a tron-server over TCP.
+class SpectatorLink
+{
+public:
+    //! Longest to wait for the server to send a game to watch.
+    static const std::chrono::milliseconds CONNECT_TIMEOUT;
+
+    //! Connect to `server` and wait until there is a game to show.
+    /*!
+     * \throw std::runtime_error if the server can't be reached,
+     * refuses or says nothing in time, or there is no networking
+     * (see TRON_HAVE_SOCKETS).
+     */
+    SpectatorLink(NetAddress server, std::uint64_t match);
+    ~SpectatorLink();
+    SpectatorLink(const SpectatorLink&) = delete;
+    auto operator=(const SpectatorLink&) -> SpectatorLink& = delete;
+
+    //! Take in every frame that has arrived, without waiting.
+    /*!
+     * \return Whether the server is still sending.
+     */
+    auto poll() -> bool;
+    //! Get the game being watched.
+    auto getView() const -> const SpectatorView&;
+
+private:
+    int descriptor{-1};
+    //! Received and not yet a whole frame.
+    std::vector<std::uint8_t> buffer;
+    SpectatorView view;
+    bool open{true};
+
+    //! Read what has arrived into `buffer`.
+    void receive();
+    //! Apply every whole frame in `buffer`.
+    void applyFrames();
+};
+
+#endif // SPECTATORLINK_H
@@ -0,0 +1,104 @@
+#include <iomanip>
+
+#include "tickprofiler.h"
+
+TickProfiler::TickProfiler()
+    : epoch(Clock::now())
+{
+    for (StageRecord &stage : stages) {
+        stage.trace.reset(new TraceEvent[TRACE_CAPACITY]);
+        for (int i = 0; i < TRACE_CAPACITY; ++i) {
+            stage.trace[i].begin.store(0, std::memory_order_relaxed);
+            stage.trace[i].duration.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/*!
+ * The ring slot is filled before `written` is released, so a reader
+ * that acquires `written` sees every timing it counts.
+ */
+void TickProfiler::record(Stage stage, Clock::time_point begin, Clock::time_point end)
+{
+    StageRecord &record = stages[static_cast<int>(stage)];
+    std::chrono::nanoseconds duration = end - begin;
+    record.histogram.record(duration.count());
+
+    std::uint64_t index = record.written.load(std::memory_order_relaxed);
+    TraceEvent &event = record.trace[index % TRACE_CAPACITY];
+    event.begin.store(std::chrono::nanoseconds{begin - epoch}.count(), std::memory_order_relaxed);
+    event.duration.store(duration.count(), std::memory_order_relaxed);
+    record.written.store(index + 1, std::memory_order_release);
+}
+
+void TickProfiler::dropTicks(long ticks)
+{
+    droppedTicks.fetch_add(ticks, std::memory_order_relaxed);
+}
+
+auto TickProfiler::getHistogram(Stage stage) const -> const LatencyHistogram&
+{
+    return stages[static_cast<int>(stage)].histogram;
+}
+
+auto TickProfiler::getDroppedTicks() const -> long
+{
+    return droppedTicks.load(std::memory_order_relaxed);
+}
+
+auto TickProfiler::stageName(Stage stage) -> const char*
+{
+    switch (stage) {
+    case Stage::Input:
+        return "input";
+    case Stage::Move:
+        return "move";
+    case Stage::Collision:
+        return "collision";
+    case Stage::Tick:
+        return "tick";
+    case Stage::Draw:
+        return "draw";
+    case Stage::Paint:
+        return "paint";
+    case Stage::Frame:
+        return "frame";
+    }
+    return "?";
+}
+
+/*!
+ * Each stage gets a track of its own, named for the stage, with
+ * complete ("X") events in microseconds. Stages run on different
+ * threads and frames span other stages, so sharing tracks would
+ * break the nesting the trace viewers expect.
+ */
+void TickProfiler::writeTrace(std::ostream &out) const
+{
+    out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedTicks\":"
+        << getDroppedTicks() << "},\"traceEvents\":[";
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        const char *name = stageName(static_cast<Stage>(s));
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << s + 1 << ",\"args\":{\"name\":\"" << name << "\"}}";
+        first = false;
+
+        const StageRecord &record = stages[s];
+        std::uint64_t written = record.written.load(std::memory_order_acquire);
+        std::uint64_t oldest = written > static_cast<std::uint64_t>(TRACE_CAPACITY)
+                ? written - TRACE_CAPACITY : 0;
+        for (std::uint64_t i = oldest; i < written; ++i) {
+            const TraceEvent &event = record.trace[i % TRACE_CAPACITY];
+            out << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << s + 1
+                << ",\"ts\":" << event.begin.load(std::memory_order_relaxed) / 1000.0
+                << ",\"dur\":" << event.duration.load(std::memory_order_relaxed) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+// Constants
+// About a minute of ticks and frames at 60 per second
+const int TickProfiler::TRACE_CAPACITY{4096};
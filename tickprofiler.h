@@ -0,0 +1,121 @@
+#ifndef TICKPROFILER_H
+#define TICKPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+#include "latencyhistogram.h"
+
+//! Times each stage of the tick and frame pipeline, for finding stutter.
+/*!
+ * Every stage has a LatencyHistogram, and a ring of its most recent
+ * timings that can be written out as a Chrome trace (chrome://tracing
+ * or Perfetto) with writeTrace(). Each stage is timed by one thread
+ * only, but any thread may read the results while it runs; nothing
+ * locks.
+ */
+class TickProfiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Stage {
+        //! Applying queued turns and asking controllers, in Tron::step().
+        Input,
+        //! Moving every player, in Tron::step().
+        Move,
+        //! Finding and eliminating crashed players, in Tron::step().
+        Collision,
+        //! One whole tick of TronRunner, including publishing the frame.
+        Tick,
+        //! Drawing a new frame's tiles into the viewer's board.
+        Draw,
+        //! Painting the viewer.
+        Paint,
+        //! Time from one frame shown to the next.
+        Frame,
+    };
+    static const int STAGE_COUNT = 7;
+    //! Most recent timings of each stage kept for the trace.
+    static const int TRACE_CAPACITY;
+
+    //! Times one stage from construction to destruction, if there's a profiler.
+    class StageTimer
+    {
+    public:
+        StageTimer(TickProfiler *profiler, Stage stage);
+        ~StageTimer();
+        StageTimer(const StageTimer&) = delete;
+        auto operator=(const StageTimer&) -> StageTimer& = delete;
+
+    private:
+        TickProfiler *profiler;
+        Stage stage;
+        Clock::time_point begin;
+    };
+
+    TickProfiler();
+
+    //! Record `stage` running from `begin` to `end` (its one thread only).
+    void record(Stage stage, Clock::time_point begin, Clock::time_point end);
+    //! Count `ticks` skipped to catch up after a stall.
+    void dropTicks(long ticks);
+
+    //! Get the timings of `stage` so far.
+    auto getHistogram(Stage stage) const -> const LatencyHistogram&;
+    //! Get the number of ticks skipped so far.
+    auto getDroppedTicks() const -> long;
+    //! Get a short lower-case name for `stage`.
+    static auto stageName(Stage stage) -> const char*;
+
+    //! Write the recent timings of every stage as Chrome trace JSON.
+    /*!
+     * A timing overwritten while this runs may come out mixed with
+     * the one that replaced it.
+     */
+    void writeTrace(std::ostream &out) const;
+
+private:
+    //! One timing, relative to `epoch`, in nanoseconds.
+    struct TraceEvent
+    {
+        std::atomic<std::int64_t> begin;
+        std::atomic<std::int64_t> duration;
+    };
+
+    //! Timings of one stage.
+    struct StageRecord
+    {
+        LatencyHistogram histogram;
+        std::unique_ptr<TraceEvent[]> trace;
+        //! Timings ever recorded; the newest is at (written - 1) % TRACE_CAPACITY.
+        std::atomic<std::uint64_t> written{0};
+    };
+
+    //! When the profiler was made, which trace times count from.
+    Clock::time_point epoch;
+    StageRecord stages[STAGE_COUNT];
+    std::atomic<long> droppedTicks{0};
+
+};
+
+inline TickProfiler::StageTimer::StageTimer(TickProfiler *profiler, Stage stage)
+    : profiler(profiler)
+    , stage(stage)
+{
+    if (profiler) {
+        begin = Clock::now();
+    }
+}
+
+inline TickProfiler::StageTimer::~StageTimer()
+{
+    if (profiler) {
+        profiler->record(stage, begin, Clock::now());
+    }
+}
+
+#endif // TICKPROFILER_H
@@ -0,0 +1,6 @@
+#include "tilelog.h"
+
+TileLog::TileLog(std::size_t capacity)
+    : blocks((capacity + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , capacity(capacity)
+{}
@@ -0,0 +1,85 @@
+#ifndef TILELOG_H
+#define TILELOG_H
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "geometry.h"
+
+//! A map tile taken by a player's trail.
+struct OccupiedTile
+{
+    Point position;
+    int player;
+};
+
+//! Append-only list of trail tiles, in the order they were taken.
+/*!
+ * Storage comes in fixed-size blocks allocated as the log grows,
+ * and entries never move once written. One thread may append while
+ * others read entries it has already published (e.g. by a release
+ * store of the size); readers need no locks.
+ */
+class TileLog
+{
+public:
+    //! Entries per storage block.
+    static const std::size_t BLOCK_SIZE = 4096;
+
+    //! Create a log able to hold `capacity` entries.
+    explicit TileLog(std::size_t capacity);
+
+    //! Add `tile` at the end (writer only).
+    /*!
+     * \throw std::logic_error if the log is full.
+     */
+    void append(const OccupiedTile &tile);
+    //! Get the number of entries (writer only).
+    auto size() const -> std::size_t;
+    //! Get the most entries the log can hold.
+    auto getCapacity() const -> std::size_t;
+    //! Get entry `index`, which must already be published.
+    auto operator[](std::size_t index) const -> const OccupiedTile&;
+
+private:
+    //! Block table, sized for the full capacity up front so it
+    //! never reallocates under a reader.
+    std::vector<std::unique_ptr<OccupiedTile[]>> blocks;
+    //! Most entries that may be written.
+    std::size_t capacity;
+    //! Number of entries written.
+    std::size_t count{0};
+
+};
+
+inline void TileLog::append(const OccupiedTile &tile)
+{
+    if (count >= capacity) {
+        throw std::logic_error{"Tile log full."};
+    }
+    std::unique_ptr<OccupiedTile[]> &block = blocks[count / BLOCK_SIZE];
+    if (!block) {
+        block.reset(new OccupiedTile[BLOCK_SIZE]);
+    }
+    block[count % BLOCK_SIZE] = tile;
+    ++count;
+}
+
+inline auto TileLog::size() const -> std::size_t
+{
+    return count;
+}
+
+inline auto TileLog::getCapacity() const -> std::size_t
+{
+    return capacity;
+}
+
+inline auto TileLog::operator[](std::size_t index) const -> const OccupiedTile&
+{
+    return blocks[index / BLOCK_SIZE][index % BLOCK_SIZE];
+}
+
+#endif // TILELOG_H
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "match.h"
+#include "tron.h"
+#include "workstealing.h"
+
+namespace {
+
+struct Options
+{
+    std::uint32_t seeds = 100;
+    std::uint32_t seed = 1;
+    std::vector<Size> mapSizes{
+        {Tron::MIN_MAP_WIDTH, Tron::MIN_MAP_HEIGHT},
+        {(Tron::MIN_MAP_WIDTH + Tron::DEFAULT_MAP_WIDTH) / 2,
+         (Tron::MIN_MAP_HEIGHT + Tron::DEFAULT_MAP_HEIGHT) / 2},
+        {Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT},
+    };
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [options]\n"
+              << "  --seeds N     games per pairing and map size (default 100)\n"
+              << "  --seed S      first seed (default 1)\n"
+              << "  --size N      add an N x N map (replaces the default sweep)\n"
+              << "  --threads T   worker threads (default: all cores)\n";
+}
+
+auto parseOptions(int argc, char *argv[], Options &options) -> bool
+{
+    bool customSizes = false;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc) {
+            return false;
+        }
+        long value = std::strtol(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--seeds") == 0) {
+            options.seeds = static_cast<std::uint32_t>(value);
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options.seed = static_cast<std::uint32_t>(value);
+        } else if (std::strcmp(argv[i], "--size") == 0) {
+            if (value < std::max(Tron::MIN_MAP_WIDTH, Tron::MIN_MAP_HEIGHT)
+                    || value > std::min(Tron::MAX_MAP_WIDTH, Tron::MAX_MAP_HEIGHT)) {
+                return false;
+            }
+            if (!customSizes) {
+                options.mapSizes.clear();
+                customSizes = true;
+            }
+            options.mapSizes.push_back({static_cast<int>(value), static_cast<int>(value)});
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            options.threads = static_cast<int>(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options.threads >= 1;
+}
+
+//! Two controllers meeting, in seat order.
+struct Pairing
+{
+    int first;
+    int second;
+};
+
+//! Results gathered by one worker.
+/*!
+ * Only its own worker ever writes to a tally, so no locks or
+ * atomics are needed; tallies are summed after every worker
+ * has finished.
+ */
+struct Tally
+{
+    explicit Tally(std::size_t controllerCount)
+        : wins(controllerCount, 0)
+        , losses(controllerCount, 0)
+        , draws(controllerCount, 0)
+    {}
+
+    std::vector<long> wins;
+    std::vector<long> losses;
+    std::vector<long> draws;
+    long matches = 0;
+    long ticks = 0;
+    long shortest = 0;
+    long longest = 0;
+    //! Keep neighbouring workers' counters off our cache line.
+    char padding[64];
+
+    void record(const Pairing &pairing, const MatchResult &result)
+    {
+        if (result.winner < 0) {
+            ++draws[pairing.first];
+            ++draws[pairing.second];
+        } else if (result.winner == 0) {
+            ++wins[pairing.first];
+            ++losses[pairing.second];
+        } else {
+            ++wins[pairing.second];
+            ++losses[pairing.first];
+        }
+        shortest = matches == 0 ? result.ticks : std::min(shortest, result.ticks);
+        longest = std::max(longest, result.ticks);
+        ++matches;
+        ticks += result.ticks;
+    }
+
+    void merge(const Tally &other)
+    {
+        for (std::size_t i = 0; i < wins.size(); ++i) {
+            wins[i] += other.wins[i];
+            losses[i] += other.losses[i];
+            draws[i] += other.draws[i];
+        }
+        if (other.matches > 0) {
+            shortest = matches == 0 ? other.shortest : std::min(shortest, other.shortest);
+        }
+        longest = std::max(longest, other.longest);
+        matches += other.matches;
+        ticks += other.ticks;
+    }
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options) || options.mapSizes.empty()) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<NamedController> &controllers = builtinControllers();
+    // Every ordered pairing, so each controller plays from both seats.
+    std::vector<Pairing> pairings;
+    for (int i = 0; i < static_cast<int>(controllers.size()); ++i) {
+        for (int j = 0; j < static_cast<int>(controllers.size()); ++j) {
+            if (i != j) {
+                pairings.push_back({i, j});
+            }
+        }
+    }
+    std::uint64_t taskCount = std::uint64_t{pairings.size()}
+            * options.mapSizes.size() * options.seeds;
+    if (taskCount > UINT32_MAX) {
+        std::cerr << "Too many matches." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // One tally per worker runWorkStealing() starts, which is at least one
+    int threadCount = std::max(1, options.threads);
+    std::vector<Tally> tallies(threadCount, Tally{controllers.size()});
+    auto begin = std::chrono::steady_clock::now();
+    try {
+        runWorkStealing(static_cast<std::uint32_t>(taskCount), threadCount,
+                        [&](int worker, std::uint32_t task) {
+            // Task index -> (pairing, map size, seed)
+            std::uint32_t seed = task % options.seeds;
+            std::uint32_t rest = task / options.seeds;
+            const Size &mapSize = options.mapSizes[rest % options.mapSizes.size()];
+            const Pairing &pairing = pairings[rest / options.mapSizes.size()];
+
+            std::vector<ControllerFactory> seats{controllers[pairing.first].create,
+                                                 controllers[pairing.second].create};
+            tallies[worker].record(pairing,
+                                   playMatch(mapSize, seats, options.seed + seed));
+        });
+    } catch (const std::logic_error &error) {
+        std::cerr << error.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    Tally total{controllers.size()};
+    for (const Tally &tally : tallies) {
+        total.merge(tally);
+    }
+
+    std::cout << std::left << std::setw(12) << "bot"
+              << std::right << std::setw(10) << "wins"
+              << std::setw(10) << "losses"
+              << std::setw(10) << "draws"
+              << std::setw(10) << "win %" << "\n";
+    for (std::size_t i = 0; i < controllers.size(); ++i) {
+        long played = total.wins[i] + total.losses[i] + total.draws[i];
+        std::cout << std::left << std::setw(12) << controllers[i].name
+                  << std::right << std::setw(10) << total.wins[i]
+                  << std::setw(10) << total.losses[i]
+                  << std::setw(10) << total.draws[i]
+                  << std::setw(10) << std::fixed << std::setprecision(1)
+                  << (played ? 100.0 * total.wins[i] / played : 0.0) << "\n";
+    }
+    std::cout << "\n"
+              << "matches:       " << total.matches << "\n"
+              << "threads:       " << options.threads << "\n"
+              << "mean length:   " << std::setprecision(1)
+              << (total.matches ? double(total.ticks) / total.matches : 0.0) << " ticks\n"
+              << "shortest:      " << total.shortest << " ticks\n"
+              << "longest:       " << total.longest << " ticks\n"
+              << "seconds:       " << std::setprecision(3) << elapsed.count() << "\n"
+              << "matches/sec:   " << std::setprecision(0) << total.matches / elapsed.count() << "\n"
+              << "ticks/sec:     " << total.ticks / elapsed.count() << std::endl;
+    return EXIT_SUCCESS;
+}
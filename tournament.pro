@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Plays every policy against every other across
+# all cores and reports the standings.
+#
+#-------------------------------------------------
+
+CONFIG -= qt app_bundle
+CONFIG += console thread
+
+TARGET = tron-tournament
+TEMPLATE = app
+
+include(common.pri)
+include(core.pri)
+
+SOURCES += tournament.cpp
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "trail.h"
+
+namespace {
+
+//! Get the direction from `from` to `to`, or None unless they're neighbours.
+auto stepBetween(Point from, Point to) -> Player::Direction
+{
+    int dx = to.x - from.x;
+    int dy = to.y - from.y;
+    if (std::abs(dx) + std::abs(dy) != 1) {
+        return Player::Direction::None;
+    }
+    if (dx != 0) {
+        return dx < 0 ? Player::Direction::Left : Player::Direction::Right;
+    }
+    return dy < 0 ? Player::Direction::Up : Player::Direction::Down;
+}
+
+} // namespace
+
+auto Trail::Segment::at(int offset) const -> Point
+{
+    Point tile = Player::advance(Point{0, 0}, direction);
+    return Point{start.x + tile.x * offset, start.y + tile.y * offset};
+}
+
+auto Trail::Segment::end() const -> Point
+{
+    return at(length - 1);
+}
+
+auto Trail::Segment::contains(Point tile) const -> bool
+{
+    Point step = Player::advance(Point{0, 0}, direction);
+    int dx = tile.x - start.x;
+    int dy = tile.y - start.y;
+    // Along the run, dx and dy are offset times the step
+    int offset = step.x != 0 ? dx * step.x : dy * step.y;
+    return dx == step.x * offset && dy == step.y * offset
+            && offset >= 0 && offset < length;
+}
+
+auto Trail::Segment::continuesTo(Point tile) const -> bool
+{
+    if (length == 1) {
+        return stepBetween(start, tile) != Player::Direction::None;
+    }
+    return Player::advance(end(), direction) == tile;
+}
+
+void Trail::Segment::extendTo(Point tile)
+{
+    if (length == 1) {
+        direction = stepBetween(start, tile);
+    }
+    ++length;
+}
+
+/*!
+ * A tile that doesn't carry the last run straight on starts a new
+ * one, so the segments only depend on the tiles, never on how many
+ * were pushed and popped on the way.
+ */
+void Trail::push_back(Point tile)
+{
+    if (!segments.empty() && segments.back().continuesTo(tile)) {
+        segments.back().extendTo(tile);
+    } else {
+        segments.push_back(Segment{tile, static_cast<int>(size()), 1, Player::Direction::None});
+    }
+}
+
+void Trail::pop_back()
+{
+    Segment &last = segments.back();
+    if (--last.length == 0) {
+        segments.pop_back();
+    } else if (last.length == 1) {
+        last.direction = Player::Direction::None;
+    }
+}
+
+void Trail::clear()
+{
+    segments.clear();
+}
+
+void Trail::reserve(std::size_t turns)
+{
+    // One segment per turn, plus the first
+    segments.reserve(turns + 1);
+}
+
+auto Trail::size() const -> std::size_t
+{
+    if (segments.empty()) {
+        return 0;
+    }
+    return static_cast<std::size_t>(segments.back().first + segments.back().length);
+}
+
+auto Trail::empty() const -> bool
+{
+    return segments.empty();
+}
+
+auto Trail::front() const -> Point
+{
+    return segments.front().start;
+}
+
+auto Trail::back() const -> Point
+{
+    return segments.back().end();
+}
+
+auto Trail::operator[](std::size_t index) const -> Point
+{
+    int i = static_cast<int>(index);
+    auto after = std::upper_bound(segments.begin(), segments.end(), i,
+                                  [](int index, const Segment &segment) {
+        return index < segment.first;
+    });
+    const Segment &segment = *(after - 1);
+    return segment.at(i - segment.first);
+}
+
+auto Trail::contains(Point tile) const -> bool
+{
+    for (const Segment &segment : segments) {
+        if (segment.contains(tile)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto Trail::getSegments() const -> const std::vector<Segment>&
+{
+    return segments;
+}
+
+auto Trail::begin() const -> const_iterator
+{
+    return const_iterator{segments.data(), 0};
+}
+
+auto Trail::end() const -> const_iterator
+{
+    return const_iterator{segments.data() + segments.size(), 0};
+}
@@ -0,0 +1,140 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#include "geometry.h"
+#include "player.h"
+
+//! The tiles a player has left behind, kept as straight segments.
+/*!
+ * A trail only bends where its player turned, so it is stored as
+ * runs of (start, direction, length): memory grows with the number
+ * of turns rather than with the number of ticks played. Tiles can
+ * still be walked in order, or looked up by index in logarithmic
+ * time.
+ */
+class Trail
+{
+public:
+    //! A straight run of tiles.
+    struct Segment
+    {
+        //! First tile of the run.
+        Point start;
+        //! Index of `start` in the whole trail.
+        int first;
+        //! Number of tiles, at least one.
+        int length;
+        //! Direction from each tile to the next; None for a single tile.
+        Player::Direction direction;
+
+        //! Get tile `offset` of the run.
+        auto at(int offset) const -> Point;
+        //! Get the last tile of the run.
+        auto end() const -> Point;
+        //! Check if `tile` is one of the run's.
+        auto contains(Point tile) const -> bool;
+        //! Check if `tile` carries the run straight on from its last tile.
+        /*!
+         * A run of one tile goes on to any tile next to it.
+         */
+        auto continuesTo(Point tile) const -> bool;
+        //! Add `tile` to the end of the run; continuesTo() must hold.
+        void extendTo(Point tile);
+    };
+
+    //! Walks the tiles of a trail in order.
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef Point value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Point *pointer;
+        typedef Point reference;
+
+        const_iterator(const Segment *segment, int offset);
+
+        auto operator*() const -> Point;
+        auto operator++() -> const_iterator&;
+        auto operator++(int) -> const_iterator;
+        auto operator==(const const_iterator &other) const -> bool;
+        auto operator!=(const const_iterator &other) const -> bool;
+
+    private:
+        const Segment *segment;
+        int offset;
+    };
+
+    //! Add `tile` to the end of the trail.
+    void push_back(Point tile);
+    //! Take the last tile off the trail.
+    void pop_back();
+    void clear();
+    //! Make room for `turns` turns, so that many are taken without allocating.
+    void reserve(std::size_t turns);
+
+    auto size() const -> std::size_t; //!< Get the number of tiles.
+    auto empty() const -> bool;
+    auto front() const -> Point; //!< Get the first tile.
+    auto back() const -> Point; //!< Get the last tile.
+    //! Get tile `index`, counting from the start.
+    auto operator[](std::size_t index) const -> Point;
+    //! Check if `tile` is one of the trail's.
+    /*!
+     * Takes a look at every segment; for checks against every trail
+     * at once, Tron keeps an OccupancyGrid.
+     */
+    auto contains(Point tile) const -> bool;
+    //! Get the straight runs making up the trail, in order.
+    auto getSegments() const -> const std::vector<Segment>&;
+
+    auto begin() const -> const_iterator;
+    auto end() const -> const_iterator;
+
+private:
+    std::vector<Segment> segments;
+
+};
+
+inline Trail::const_iterator::const_iterator(const Segment *segment, int offset)
+    : segment(segment)
+    , offset(offset)
+{
+}
+
+inline auto Trail::const_iterator::operator*() const -> Point
+{
+    return segment->at(offset);
+}
+
+inline auto Trail::const_iterator::operator++() -> const_iterator&
+{
+    if (++offset == segment->length) {
+        ++segment;
+        offset = 0;
+    }
+    return *this;
+}
+
+inline auto Trail::const_iterator::operator++(int) -> const_iterator
+{
+    const_iterator old = *this;
+    ++*this;
+    return old;
+}
+
+inline auto Trail::const_iterator::operator==(const const_iterator &other) const -> bool
+{
+    return segment == other.segment && offset == other.offset;
+}
+
+inline auto Trail::const_iterator::operator!=(const const_iterator &other) const -> bool
+{
+    return !(*this == other);
+}
+
+#endif // TRAIL_H
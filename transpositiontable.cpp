@@ -0,0 +1,68 @@
+#include "transpositiontable.h"
+
+TranspositionTable::TranspositionTable(int sizeLog2)
+    : slots(new Slot[std::size_t{1} << sizeLog2])
+    , mask((std::uint64_t{1} << sizeLog2) - 1)
+{
+    clear();
+}
+
+/*!
+ * Relaxed ordering is enough: the check word catches any mix of
+ * old and new halves, and nothing else is published through the
+ * table.
+ */
+auto TranspositionTable::probe(std::uint64_t key, Entry &entry) const -> bool
+{
+    const Slot &slot = slots[key & mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || data == 0) {
+        return false;
+    }
+    entry = unpack(data);
+    return true;
+}
+
+void TranspositionTable::store(std::uint64_t key, const Entry &entry)
+{
+    Slot &slot = slots[key & mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) == key && data != 0 && unpack(data).depth > entry.depth) {
+        return;
+    }
+    data = pack(entry);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(data ^ key, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (std::uint64_t i = 0; i <= mask; ++i) {
+        slots[i].data.store(0, std::memory_order_relaxed);
+        slots[i].check.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Layout: score in the high 32 bits, then depth, bound and move.
+// A bound of None never gets stored, so valid data is never 0.
+
+auto TranspositionTable::pack(const Entry &entry) -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(entry.score)) << 32
+            | static_cast<std::uint64_t>(entry.depth & 0xffff) << 16
+            | static_cast<std::uint64_t>(entry.bound) << 8
+            | static_cast<std::uint64_t>(entry.move);
+}
+
+auto TranspositionTable::unpack(std::uint64_t data) -> Entry
+{
+    return Entry{static_cast<std::int32_t>(data >> 32),
+                 static_cast<int>((data >> 16) & 0xffff),
+                 static_cast<Bound>((data >> 8) & 0xff),
+                 static_cast<Player::Direction>(data & 0xff)};
+}
+
+// Constants
+const int TranspositionTable::DEFAULT_SIZE_LOG2{18};
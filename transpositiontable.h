@@ -0,0 +1,69 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "player.h"
+
+//! Remembers search results by position hash, shared between threads.
+/*!
+ * A fixed number of slots, one entry each, indexed by the low bits
+ * of the hash. Slots hold two words, the entry's packed data and
+ * that data XORed with the hash. A reader only trusts an entry
+ * when the two agree, so a slot torn by threads writing it at the
+ * same moment simply reads as a miss, and no locks are needed.
+ */
+class TranspositionTable
+{
+public:
+    //! How a stored score relates to the true value.
+    enum class Bound : std::uint8_t {None, Exact, Lower, Upper};
+
+    //! What was learned by searching one position.
+    struct Entry
+    {
+        int score;
+        int depth;
+        Bound bound;
+        //! Best move found, or None.
+        Player::Direction move;
+    };
+
+    static const int DEFAULT_SIZE_LOG2;
+
+    //! Create a table of 2^`sizeLog2` slots.
+    explicit TranspositionTable(int sizeLog2 = DEFAULT_SIZE_LOG2);
+
+    //! Look up `key`.
+    /*!
+     * \return Whether an entry for `key` was found.
+     */
+    auto probe(std::uint64_t key, Entry &entry) const -> bool;
+    //! Store `entry` for `key`.
+    /*!
+     * Keeps an entry for the same key that was searched deeper.
+     */
+    void store(std::uint64_t key, const Entry &entry);
+    //! Forget every entry. Not thread-safe.
+    void clear();
+
+private:
+    struct Slot
+    {
+        //! `data` XOR the key it belongs to.
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    //! Slot count - 1.
+    const std::uint64_t mask;
+
+    static auto pack(const Entry &entry) -> std::uint64_t;
+    static auto unpack(std::uint64_t data) -> Entry;
+
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -1,27 +1,125 @@
-#include <exception>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
 
 #include "tron.h"
+#include "bits.h"
 #include "clamp.h"
+#include "replay.h"
+#include "tickprofiler.h"
+#include "workerteam.h"
+#include "zobrist.h"
 
-Tron::Tron(QSize mapSize,
-           int playerCount,
-           std::vector<QString> playerNames,
-           std::vector<QColor> playerColors) :
-    mapSize(mapSize)
+//! What step() needs to run on several threads.
+struct Tron::ParallelStep
+{
+    //! Scratch space of one thread, on cache lines of its own.
+    struct Worker
+    {
+        //! Change to the hash made by this thread's moves.
+        std::uint64_t hash;
+        //! Players this thread found crashing.
+        std::vector<int> colliding;
+        //! Players whose tile left behind is in a chunk not yet allocated.
+        std::vector<int> unset;
+        //! Slots of `heads` this thread filled.
+        std::vector<std::size_t> claimed;
+        char padding[64];
+    };
+
+    ParallelStep(Size mapSize, int playerCount, int threadCount)
+        : team(threadCount)
+        , heads(mapSize, playerCount)
+        , workers(threadCount)
+    {}
+
+    WorkerTeam team;
+    ConcurrentHeadTable heads;
+    std::vector<Worker> workers;
+};
+
+Tron::Tron(Size mapSize, int playerCount) :
+    mapSize(validated(mapSize, playerCount))
   , playerCount(playerCount)
+  , positions(playerCount)
+  , directions(playerCount, Player::Direction::None)
+  , playing((playerCount + 63) / 64, 0)
+  , trails(playerCount)
+  , playingCount(playerCount)
+  , occupied(mapSize)
+  , rays(occupied)
+  , inputs(new InputQueue[playerCount])
+  , heads(mapSize, playerCount)
+  , controllers(playerCount)
+{
+    for (int i = 0; i < playerCount; ++i) {
+        positions[i] = startPos(i);
+        playing[i / 64] |= std::uint64_t{1} << (i % 64);
+        hash ^= headKey(i, positions[i]);
+    }
+    colliding.reserve(playerCount);
+}
+
+Tron::Tron(const Tron &other) :
+    mapSize(other.mapSize)
+  , playerCount(other.playerCount)
+  , positions(other.positions)
+  , directions(other.directions)
+  , playing(other.playing)
+  , trails(other.trails)
+  , playingCount(other.playingCount)
+  , started(other.started)
+  , occupied(other.occupied)
+  , rays(occupied, other.rays)
+  , inputs(new InputQueue[other.playerCount])
+  , heads(other.mapSize, other.playerCount)
+  , colliding(other.colliding)
+  , controllers(other.playerCount)
+  , hash(other.hash)
+  , tick(other.tick)
+  , rewindLimit(other.rewindLimit)
+  , undoFrames(other.undoFrames)
+  , undoMoves(other.undoMoves)
+  , undoEliminations(other.undoEliminations)
+{}
+
+Tron::~Tron()
+{}
+
+auto Tron::validated(Size mapSize, int playerCount) -> Size
 {
-    if (mapSize.width() < MIN_MAP_WIDTH
-            || mapSize.width() > MAX_MAP_WIDTH
-            || mapSize.height() < MIN_MAP_HEIGHT
-            || mapSize.height() > MAX_MAP_HEIGHT) {
+    if (mapSize.width < MIN_MAP_WIDTH
+            || mapSize.width > MAX_MAP_WIDTH
+            || mapSize.height < MIN_MAP_HEIGHT
+            || mapSize.height > MAX_MAP_HEIGHT) {
         throw std::logic_error{"Bad map size."};
     }
     if (playerCount < MIN_PLAYER_COUNT
             || playerCount > MAX_PLAYER_COUNT) {
         throw std::logic_error{"Bad player count."};
     }
-    for (int i = 0; i < playerCount; ++i) {
-        players.emplace_back(playerNames[i], playerColors[i], startPos(i));
+    // Everyone needs a tile to themselves with space around it:
+    // startPos() fits at most half the columns by half the rows
+    if (playerCount > static_cast<long>(mapSize.width / 2) * (mapSize.height / 2)) {
+        throw std::logic_error{"Too many players for map size."};
+    }
+    return mapSize;
+}
+
+template <typename Visitor>
+void Tron::forEachPlaying(Visitor visit) const
+{
+    forEachPlayingIn(0, playing.size(), visit);
+}
+
+template <typename Visitor>
+void Tron::forEachPlayingIn(std::size_t first, std::size_t last, Visitor visit) const
+{
+    for (std::size_t w = first; w < last; ++w) {
+        for (std::uint64_t word = playing[w]; word; word &= word - 1) {
+            visit(static_cast<int>(w * 64 + lowestBit(word)));
+        }
     }
 }
 
@@ -29,120 +127,663 @@ Tron::Tron(QSize mapSize,
  * The object iterates over all players, updates them
  * and then checks for collisions and removes players
  * from the game accordingly.
- * \return Whether the game is now over.
+ * \return Whether the game is still in progress.
  */
 auto Tron::step() -> bool
 {
+    {
+        TickProfiler::StageTimer timer{profiler, TickProfiler::Stage::Input};
+        applyInputs();
+        consultControllers();
+    }
     if (allReady() && !gameIsOver()) {
-        // Update each player
-        for (Player &player : players) {
-            player.step();
-        }
-        // Check each player for collision;
-        // We do this after all updates to ensure
-        // _both_ players are stopped in event of tie
-        for (Player &player : players) {
-            if (isColliding(player)) {
-                player.setIsPlaying(false);
+        if (recorder) {
+            recorder->record(*this);
+        }
+        std::vector<int> *eliminated = nullptr;
+        if (rewindLimit > 0) {
+            undoFrames.push_back(UndoFrame{undoMoves.size(), undoEliminations.size()});
+            forEachPlaying([this](int i) {
+                undoMoves.push_back(UndoMove{i, lastMove(i)});
+            });
+            eliminated = &undoEliminations;
+        }
+        if (parallel && playingCount >= PARALLEL_MIN_PLAYERS) {
+            advancePlayersInParallel(eliminated);
+        } else {
+            {
+                TickProfiler::StageTimer timer{profiler, TickProfiler::Stage::Move};
+                movePlayers();
             }
+            TickProfiler::StageTimer timer{profiler, TickProfiler::Stage::Collision};
+            resolveCollisions(eliminated);
+        }
+        if (rewindLimit > 0) {
+            forgetOldMoves();
         }
+        ++tick;
     }
 
     return !gameIsOver();
 }
 
+void Tron::advancePlayers(std::vector<int> *eliminated)
+{
+    movePlayers();
+    resolveCollisions(eliminated);
+}
+
+/*!
+ * Each player leaves a trail tile where it was; every tile is
+ * folded into the hash as it is occupied.
+ */
+void Tron::movePlayers()
+{
+    // Update each player, recording the tile it just left
+    forEachPlaying([this](int i) {
+        trails[i].push_back(positions[i]);
+        occupied.set(positions[i]);
+        rays.set(positions[i]);
+        Point next = Player::advance(positions[i], directions[i]);
+        hash ^= headKey(i, positions[i]) ^ trailKey(positions[i]) ^ headKey(i, next);
+        positions[i] = next;
+    });
+}
+
+void Tron::resolveCollisions(std::vector<int> *eliminated)
+{
+    // Check each player for collision;
+    // We do this after all updates, and only stop players
+    // once everyone has been checked, to ensure _both_
+    // players are stopped in event of tie.
+    // Heads sharing a tile are found as they are claimed.
+    colliding.clear();
+    heads.clear();
+    forEachPlaying([this](int i) {
+        if (isBlocked(positions[i])) {
+            colliding.push_back(i);
+        } else {
+            int other = heads.claim(positions[i], i);
+            if (other >= 0) {
+                colliding.push_back(i);
+                colliding.push_back(other);
+            }
+        }
+    });
+    eliminateColliding(eliminated);
+}
+
+/*!
+ * Each thread takes a share of the words of `playing`, so the
+ * players it moves (trails, positions) are its own. Then, with
+ * barriers in between:
+ * - Every thread moves its players, setting the tiles they leave
+ *   with atomic ORs; tiles in chunks not allocated yet are left to
+ *   the caller, which allocates them while nobody reads the grid.
+ * - Every thread checks its players against the finished grid and
+ *   claims the tiles they moved to with a compare-and-swap, so two
+ *   claims of one tile show up as a tie whichever lands first.
+ * The crashed players are then sorted, and taken out on the caller
+ * alone, so the game comes out the same as on one thread.
+ */
+void Tron::advancePlayersInParallel(std::vector<int> *eliminated)
+{
+    ParallelStep &step = *parallel;
+    int threadCount = step.team.getThreadCount();
+    std::size_t words = playing.size();
+    TickProfiler::Clock::time_point begin;
+    TickProfiler::Clock::time_point moved;
+    if (profiler) {
+        begin = TickProfiler::Clock::now();
+    }
+    step.team.run([&](int w) {
+        ParallelStep::Worker &worker = step.workers[w];
+        std::size_t first = words * w / threadCount;
+        std::size_t last = words * (w + 1) / threadCount;
+
+        worker.hash = 0;
+        step.heads.clear(worker.claimed);
+        forEachPlayingIn(first, last, [this, &worker](int i) {
+            trails[i].push_back(positions[i]);
+            bool isSet = occupied.setConcurrently(positions[i]);
+            if (!rays.setConcurrently(positions[i]) || !isSet) {
+                worker.unset.push_back(i);
+            }
+            Point next = Player::advance(positions[i], directions[i]);
+            worker.hash ^= headKey(i, positions[i]) ^ trailKey(positions[i]) ^ headKey(i, next);
+            positions[i] = next;
+        });
+        step.team.barrier();
+        if (w == 0) {
+            for (ParallelStep::Worker &other : step.workers) {
+                for (int i : other.unset) {
+                    occupied.set(trails[i].back());
+                    rays.set(trails[i].back());
+                }
+                other.unset.clear();
+            }
+            if (profiler) {
+                moved = TickProfiler::Clock::now();
+            }
+        }
+        step.team.barrier();
+
+        worker.colliding.clear();
+        forEachPlayingIn(first, last, [this, &step, &worker](int i) {
+            if (isBlocked(positions[i])) {
+                worker.colliding.push_back(i);
+            } else {
+                int other = step.heads.claim(positions[i], i, worker.claimed);
+                if (other >= 0) {
+                    worker.colliding.push_back(i);
+                    worker.colliding.push_back(other);
+                }
+            }
+        });
+    });
+
+    colliding.clear();
+    for (const ParallelStep::Worker &worker : step.workers) {
+        hash ^= worker.hash;
+        colliding.insert(colliding.end(), worker.colliding.begin(), worker.colliding.end());
+    }
+    std::sort(colliding.begin(), colliding.end());
+    eliminateColliding(eliminated);
+    if (profiler) {
+        profiler->record(TickProfiler::Stage::Move, begin, moved);
+        profiler->record(TickProfiler::Stage::Collision, moved, TickProfiler::Clock::now());
+    }
+}
+
+void Tron::eliminateColliding(std::vector<int> *eliminated)
+{
+#ifdef TRON_VERIFY_OCCUPANCY
+    forEachPlaying([this](int i) {
+        assert((std::find(colliding.begin(), colliding.end(), i) != colliding.end())
+               == isCollidingByTrail(i));
+    });
+#endif
+    for (int i : colliding) {
+        if (eliminate(i) && eliminated) {
+            eliminated->push_back(i);
+        }
+    }
+}
+
+/*!
+ * Moves are recorded on the undo stacks so unmakeMove() can walk
+ * each player back along its trail; nothing is allocated once the
+ * stacks have grown to the search depth.
+ */
+void Tron::makeMove(const std::vector<Player::Direction> &moves)
+{
+    undoFrames.push_back(UndoFrame{undoMoves.size(), undoEliminations.size()});
+    ++tick;
+    if (gameIsOver()) {
+        return;
+    }
+    forEachPlaying([this, &moves](int i) {
+        undoMoves.push_back(UndoMove{i, directions[i]});
+        directions[i] = moves[i];
+    });
+    advancePlayers(&undoEliminations);
+}
+
+void Tron::unmakeMove()
+{
+    if (undoFrames.empty()) {
+        throw std::logic_error{"No move to unmake."};
+    }
+    undoLastMove();
+}
+
+void Tron::setRewindLimit(int ticks)
+{
+    rewindLimit = std::max(0, ticks);
+    forgetOldMoves();
+}
+
+auto Tron::getRewindLimit() const -> int
+{
+    return rewindLimit;
+}
+
+auto Tron::getRewindableTicks() const -> int
+{
+    return static_cast<int>(undoFrames.size());
+}
+
+/*!
+ * Each tick undone walks the players that moved back one tile,
+ * so the cost is in tiles changed, not the size of the game.
+ */
+void Tron::rewind(int ticks)
+{
+    if (ticks < 0 || static_cast<std::size_t>(ticks) > undoFrames.size()) {
+        throw std::logic_error{"Can't rewind that far."};
+    }
+    if (recorder && ticks > 0) {
+        throw std::logic_error{"Can't rewind while recording."};
+    }
+    for (int t = 0; t < ticks; ++t) {
+        undoLastMove();
+    }
+}
+
+/*!
+ * Only what the last game touched is cleared, and containers
+ * are emptied rather than freed.
+ */
+void Tron::reset()
+{
+    if (recorder) {
+        throw std::logic_error{"Can't reset while recording."};
+    }
+    hash = 0;
+    std::fill(playing.begin(), playing.end(), 0);
+    for (int i = 0; i < playerCount; ++i) {
+        trails[i].clear();
+        positions[i] = startPos(i);
+        directions[i] = Player::Direction::None;
+        playing[i / 64] |= std::uint64_t{1} << (i % 64);
+        inputs[i].clear();
+        hash ^= headKey(i, positions[i]);
+    }
+    playingCount = playerCount;
+    started = false;
+    occupied.clear();
+    rays.clear();
+    colliding.clear();
+    undoFrames.clear();
+    undoMoves.clear();
+    undoEliminations.clear();
+    tick = 0;
+}
+
+void Tron::reserve(std::size_t turns)
+{
+    occupied.allocateAll();
+    rays.allocateAll();
+    for (Trail &trail : trails) {
+        trail.reserve(turns);
+    }
+    // forgetOldMoves() keeps up to twice the limit
+    std::size_t frames = 2 * static_cast<std::size_t>(rewindLimit) + 1;
+    undoFrames.reserve(frames);
+    undoMoves.reserve(frames * playerCount);
+    undoEliminations.reserve(playerCount);
+}
+
+auto Tron::getTick() const -> int
+{
+    return tick;
+}
+
+void Tron::undoLastMove()
+{
+    UndoFrame frame = undoFrames.back();
+    undoFrames.pop_back();
+    for (std::size_t e = frame.eliminations; e < undoEliminations.size(); ++e) {
+        restore(undoEliminations[e]);
+    }
+    undoEliminations.resize(frame.eliminations);
+    for (std::size_t m = frame.moves; m < undoMoves.size(); ++m) {
+        const UndoMove &move = undoMoves[m];
+        int i = move.player;
+        Point previous = trails[i].back();
+        trails[i].pop_back();
+        // Every tile is only ever taken once, so freeing it is safe
+        occupied.reset(previous);
+        rays.reset(previous);
+        hash ^= headKey(i, positions[i]) ^ trailKey(previous) ^ headKey(i, previous);
+        positions[i] = previous;
+        directions[i] = move.direction;
+    }
+    undoMoves.resize(frame.moves);
+    --tick;
+    // Checked again by allReady(), in case this was the first move
+    started = false;
+}
+
+/*!
+ * Old frames are dropped in batches once there are twice as many
+ * as needed, so trimming costs nothing per tick on average.
+ */
+void Tron::forgetOldMoves()
+{
+    std::size_t limit = static_cast<std::size_t>(rewindLimit);
+    if (undoFrames.size() <= 2 * limit) {
+        return;
+    }
+    if (limit == 0) {
+        undoFrames.clear();
+        undoMoves.clear();
+        undoEliminations.clear();
+        return;
+    }
+    std::size_t dropped = undoFrames.size() - limit;
+    UndoFrame first = undoFrames[dropped];
+    undoMoves.erase(undoMoves.begin(), undoMoves.begin() + first.moves);
+    undoEliminations.erase(undoEliminations.begin(),
+                           undoEliminations.begin() + first.eliminations);
+    undoFrames.erase(undoFrames.begin(), undoFrames.begin() + dropped);
+    for (UndoFrame &frame : undoFrames) {
+        frame.moves -= first.moves;
+        frame.eliminations -= first.eliminations;
+    }
+}
+
+auto Tron::lastMove(int player) const -> Player::Direction
+{
+    if (trails[player].empty()) {
+        return Player::Direction::None;
+    }
+    Point from = trails[player].back();
+    Point to = positions[player];
+    if (to.x != from.x) {
+        return to.x < from.x ? Player::Direction::Left : Player::Direction::Right;
+    }
+    return to.y < from.y ? Player::Direction::Up : Player::Direction::Down;
+}
+
+auto Tron::eliminate(int player) -> bool
+{
+    std::uint64_t bit = std::uint64_t{1} << (player % 64);
+    // A player can be listed more than once in a pile-up
+    if (playing[player / 64] & bit) {
+        playing[player / 64] &= ~bit;
+        --playingCount;
+        hash ^= outKey(player);
+        return true;
+    }
+    return false;
+}
+
+void Tron::restore(int player)
+{
+    playing[player / 64] |= std::uint64_t{1} << (player % 64);
+    ++playingCount;
+    hash ^= outKey(player);
+}
+
+// Zobrist features: a tag in the top byte, then player and tile.
+auto Tron::trailKey(Point position) const -> std::uint64_t
+{
+    return zobristKey(std::uint64_t{1} << 56
+                      | (static_cast<std::uint64_t>(position.y) * mapSize.width + position.x));
+}
+
+auto Tron::headKey(int player, Point position) const -> std::uint64_t
+{
+    // Heads can leave the map when crashing into the wall
+    std::uint64_t x = static_cast<std::uint32_t>(position.x) & 0xffffu;
+    std::uint64_t y = static_cast<std::uint32_t>(position.y) & 0xffffu;
+    return zobristKey(std::uint64_t{2} << 56
+                      | static_cast<std::uint64_t>(player) << 32 | y << 16 | x);
+}
+
+auto Tron::outKey(int player) const -> std::uint64_t
+{
+    return zobristKey(std::uint64_t{3} << 56 | static_cast<std::uint64_t>(player));
+}
+
+auto Tron::queueTurn(int player, Player::Direction direction,
+                     std::int64_t timestamp) -> bool
+{
+    if (player < 0 || player >= playerCount) {
+        throw std::logic_error{"Bad player index."};
+    }
+    return inputs[player].push(InputEvent{direction, timestamp});
+}
+
+void Tron::turn(int player, Player::Direction direction)
+{
+    directions[player] = direction;
+}
+
+void Tron::setController(int player, std::unique_ptr<Controller> controller)
+{
+    if (player < 0 || player >= playerCount) {
+        throw std::logic_error{"Bad player index."};
+    }
+    controllers[player] = std::move(controller);
+}
+
+void Tron::setRecorder(ReplayRecorder *recorder)
+{
+    if (recorder && !trails[0].empty()) {
+        throw std::logic_error{"Recording must start before the first move."};
+    }
+    this->recorder = recorder;
+}
+
+void Tron::setProfiler(TickProfiler *profiler)
+{
+    this->profiler = profiler;
+}
+
+void Tron::setStepThreads(int threadCount)
+{
+    if (threadCount == getStepThreads()) {
+        return;
+    }
+    if (threadCount > 1) {
+        parallel.reset(new ParallelStep{mapSize, playerCount, threadCount});
+    } else {
+        parallel.reset(nullptr);
+    }
+}
+
+auto Tron::getStepThreads() const -> int
+{
+    return parallel ? parallel->team.getThreadCount() : 1;
+}
+
+/*!
+ * The trail is taken over as is and folded into the occupancy
+ * and the hash tile by tile.
+ */
+void Tron::placePlayer(int player, Trail trail, Point position,
+                       Player::Direction direction, bool isPlaying)
+{
+    if (player < 0 || player >= playerCount) {
+        throw std::logic_error{"Bad player index."};
+    }
+    hash ^= headKey(player, positions[player]) ^ headKey(player, position);
+    for (Point tile : trail) {
+        occupied.set(tile);
+        rays.set(tile);
+        hash ^= trailKey(tile);
+    }
+    trails[player] = std::move(trail);
+    positions[player] = position;
+    directions[player] = direction;
+    if (!isPlaying) {
+        eliminate(player);
+    }
+}
+
+void Tron::placeTick(int tick)
+{
+    this->tick = tick;
+}
+
+/*!
+ * Controllers are asked in player order, so a rival's direction
+ * may already reflect this tick's decision; positions never do.
+ */
+void Tron::consultControllers()
+{
+    if (gameIsOver()) {
+        return;
+    }
+    forEachPlaying([this](int i) {
+        if (controllers[i]) {
+            directions[i] = controllers[i]->decide(*this, i);
+        }
+    });
+}
+
+/*!
+ * Turns that would change nothing (the current direction) or
+ * steer a player straight back into its own trail (the opposite
+ * direction) are discarded without using up the tick.
+ */
+void Tron::applyInputs()
+{
+    for (int i = 0; i < playerCount; ++i) {
+        InputEvent event;
+        while (inputs[i].pop(event)) {
+            Player::Direction current = directions[i];
+            if (getIsPlaying(i)
+                    && event.direction != Player::Direction::None
+                    && event.direction != current
+                    && event.direction != Player::opposite(current)) {
+                directions[i] = event.direction;
+                break;
+            }
+        }
+    }
+}
+
 /*!
  * A game is considered "over" when it has either a winner or
  * is a draw (tie).
  * \return Whether the game is over.
  */
-auto Tron::gameIsOver() -> bool
+auto Tron::gameIsOver() const -> bool
 {
-    auto still_playing = std::count_if(players.begin(), players.end(),
-                         [](Player &p) { return p.getIsPlaying(); });
-    return still_playing <= 1;
+    return playingCount <= 1;
 }
 
 /*!
- * If the game is over, this function will return an iterator to
- * its winner. In the event of a tie this iterator will point
- * to the end() of the `players` container.
- * \return Iterator to winning player.
+ * If the game is over, this function will return the index of
+ * its winner. In the event of a tie it returns -1.
+ * \return Index of winning player.
  */
-auto Tron::getWinner() -> PlayerContainer::iterator
+auto Tron::getWinner() const -> int
 {
     if (!gameIsOver()) {
         throw std::logic_error{"Game has no winner (game not over)."};
     }
 
-    PlayerContainer::iterator iter;
-    for (iter = players.begin(); iter != players.end(); ++iter) {
-        if (iter->getIsPlaying()) {
-            break;
-        }
-    }
-    return iter;
+    int winner = -1;
+    forEachPlaying([&winner](int i) { winner = i; });
+    return winner;
 }
 
+/*!
+ * Directions never go back to None, so once everyone is
+ * ready this stops looking.
+ */
 auto Tron::allReady() -> bool
 {
-    return std::all_of(players.begin(), players.end(),
-                       [](const Player &p){return p.getDirection() != Player::Direction::None;});
+    if (!started) {
+        started = std::all_of(directions.begin(), directions.end(),
+                              [](Player::Direction d){return d != Player::Direction::None;});
+    }
+    return started;
 }
 
 /*!
  * Determine if `player` is colliding with map geometry
- * or any other players.
+ * or any other players by searching every trail.
  * \param player to check collision status of.
  * \return Whether `player` is colliding.
  */
-auto Tron::isColliding(const Player &player) -> bool
+auto Tron::isCollidingByTrail(int player) const -> bool
 {
-    QPoint position = player.getPosition();
-    int x = position.x();
-    int y = position.y();
+    Point position = positions[player];
     // Check map bound collisions
-    if (x < 0 || y < 0
-            || x >= mapSize.width()
-            || y >= mapSize.height()) {
+    if (position.x < 0 || position.y < 0
+            || position.x >= mapSize.width
+            || position.y >= mapSize.height) {
         return true;
     }
-    // Check collisions with other players
-    for(const Player& otherPlayer : players) {
-        if (player.collidesWith(otherPlayer))
+    for (int other = 0; other < playerCount; ++other) {
+        // Only check if heads collide if a) other player is actually playing,
+        // and b) other player is not actually this player.
+        if (other != player && getIsPlaying(other)
+                && positions[other] == position) {
+            return true;
+        }
+        // Always check to see if we are hitting the other player's trail
+        // as it is valid for a non-playing player and for ourselves
+        if (trails[other].contains(position)) {
             return true;
+        }
     }
     return false;
 }
 
-auto Tron::startPos(int index) -> QPoint
+/*!
+ * Up to four players start in the corners of the map, as they
+ * always have. More are spread over an even grid with at least
+ * one free tile between neighbours.
+ */
+auto Tron::startPos(int index) -> Point
 {
-    // TODO: This just assumes at most 4 players.
     int x, y;
-    switch(index) {
-    case 0: // Top Left
-        x = (mapSize.width() / 4);
-        y = (mapSize.height() / 4);
-        break;
-    case 1: // Bottom Right
-        x = 3 * (mapSize.width() / 4);
-        y = 3 * (mapSize.height() / 4);
-        break;
-    case 2: // Top Right
-        x = 3 * (mapSize.width() / 4);
-        y = (mapSize.height() / 4);
-        break;
-    case 3: // Bottom Left
-        x = (mapSize.width() / 4);
-        y = 3 * (mapSize.height() / 4);
-        break;
-    default:
+    if (playerCount <= 4) {
+        switch(index) {
+        case 0: // Top Left
+            x = (mapSize.width / 4);
+            y = (mapSize.height / 4);
+            break;
+        case 1: // Bottom Right
+            x = 3 * (mapSize.width / 4);
+            y = 3 * (mapSize.height / 4);
+            break;
+        case 2: // Top Right
+            x = 3 * (mapSize.width / 4);
+            y = (mapSize.height / 4);
+            break;
+        case 3: // Bottom Left
+            x = (mapSize.width / 4);
+            y = 3 * (mapSize.height / 4);
+            break;
+        default:
+            throw std::logic_error{"Can't compute start position for player."};
+        }
+        return {x, y};
+    }
+
+    // Pick a column count that keeps cells roughly square, but
+    // with enough columns that the rows fit; validated() made sure
+    // that both halves can be met.
+    int columns = static_cast<int>(std::ceil(std::sqrt(
+            static_cast<double>(playerCount) * mapSize.width / mapSize.height)));
+    int halfHeight = mapSize.height / 2;
+    columns = clamp(columns, (playerCount + halfHeight - 1) / halfHeight, mapSize.width / 2);
+    int rows = (playerCount + columns - 1) / columns;
+    if (rows > mapSize.height / 2) {
         throw std::logic_error{"Can't compute start position for player."};
     }
+    int column = index % columns;
+    int row = index / columns;
+    x = (2 * column + 1) * mapSize.width / (2 * columns);
+    y = (2 * row + 1) * mapSize.height / (2 * rows);
     return {x, y};
 }
 
-auto Tron::getMapSize() const -> QSize
+/*!
+ * \param position to check.
+ * \return Whether moving onto `position` would be a collision
+ * with the map edge or a trail (heads are not considered).
+ */
+auto Tron::isBlocked(Point position) const -> bool
+{
+    return !isOnMap(position) || occupied.test(position);
+}
+
+auto Tron::isOnMap(Point position) const -> bool
+{
+    return position.x >= 0 && position.y >= 0
+            && position.x < mapSize.width
+            && position.y < mapSize.height;
+}
+
+auto Tron::getMapSize() const -> Size
 {
     return mapSize;
 }
@@ -152,22 +793,206 @@ auto Tron::getPlayerCount() const -> int
     return playerCount;
 }
 
-auto Tron::getPlayer(int index) -> Player&
+auto Tron::getFreeTiles() const -> Bitboard
+{
+    Bitboard free{mapSize};
+    for (int y = 0; y < mapSize.height; ++y) {
+        for (int word = 0; word < free.getWordsPerRow(); ++word) {
+            free.setWord(y, word, ~occupied.getWord(y, word));
+        }
+    }
+    forEachPlaying([this, &free](int i) {
+        if (isOnMap(positions[i])) {
+            free.reset(positions[i]);
+        }
+    });
+    return free;
+}
+
+auto Tron::reachableArea(Point from) const -> int
+{
+    if (!isOnMap(from)) {
+        return 0;
+    }
+    Bitboard free = getFreeTiles();
+    free.set(from);
+    Bitboard area{mapSize};
+    area.set(from);
+    area.flood(free);
+    return area.count() - 1;
+}
+
+auto Tron::freeRun(Point from, Player::Direction direction) const -> int
+{
+    return rays.freeRun(from, direction);
+}
+
+auto Tron::obstacleDistance(Point from) const -> int
+{
+    return rays.obstacleDistance(from);
+}
+
+/*!
+ * Small games grow a bitboard per player, which is quickest; past
+ * TERRITORY_BOARD_TILES those would run to gigabytes, so the
+ * players share one frontier instead.
+ */
+void Tron::territories(std::vector<int> &tiles) const
+{
+    tiles.assign(playerCount, 0);
+    // Free tiles nobody has reached yet
+    Bitboard unclaimed = getFreeTiles();
+    std::vector<int> seeds;
+    forEachPlaying([&](int i) {
+        if (isOnMap(positions[i])) {
+            seeds.push_back(i);
+        }
+    });
+    std::size_t area = static_cast<std::size_t>(mapSize.width) * mapSize.height;
+    if (seeds.size() * area <= TERRITORY_BOARD_TILES) {
+        growTerritoryBoards(seeds, unclaimed, tiles);
+    } else {
+        growTerritoryFrontier(seeds, unclaimed, tiles);
+    }
+}
+
+/*!
+ * Every player keeps a bitboard of the tiles it reached last step,
+ * and they all grow one tile per step, so each step costs a few
+ * word operations per row however many tiles it covers.
+ */
+void Tron::growTerritoryBoards(const std::vector<int> &seeds, Bitboard &unclaimed,
+                               std::vector<int> &tiles) const
+{
+    std::vector<Bitboard> fronts(seeds.size(), Bitboard{mapSize});
+    for (std::size_t s = 0; s < seeds.size(); ++s) {
+        fronts[s].set(positions[seeds[s]]);
+    }
+    std::vector<Bitboard> grown(fronts.size(), Bitboard{mapSize});
+    // Tiles reached this step, and those reached by more than one player
+    Bitboard reached{mapSize};
+    Bitboard contested{mapSize};
+
+    for (;;) {
+        reached.clear();
+        contested.clear();
+        for (std::size_t s = 0; s < fronts.size(); ++s) {
+            grown[s].dilate(fronts[s], unclaimed);
+            contested.orIntersection(grown[s], reached);
+            reached |= grown[s];
+        }
+        if (reached.isEmpty()) {
+            break;
+        }
+        unclaimed.andNot(reached);
+        for (std::size_t s = 0; s < fronts.size(); ++s) {
+            // Contested tiles don't extend anyone's claim
+            grown[s].andNot(contested);
+            std::swap(fronts[s], grown[s]);
+            tiles[seeds[s]] += fronts[s].count();
+        }
+    }
+}
+
+/*!
+ * The frontier holds each tile reached last step with the player
+ * that reached it. Each step lists the unclaimed neighbours of the
+ * frontier and sorts them by tile, so the players reaching a tile
+ * sit together and a tile with more than one is seen as contested.
+ * Memory goes with the frontier, not the number of players.
+ */
+void Tron::growTerritoryFrontier(const std::vector<int> &seeds, Bitboard &unclaimed,
+                                 std::vector<int> &tiles) const
+{
+    // Tile index, row by row, and the player that reached it
+    typedef std::pair<int, int> Claim;
+    std::vector<Claim> frontier;
+    frontier.reserve(seeds.size());
+    for (int player : seeds) {
+        Point head = positions[player];
+        frontier.emplace_back(head.y * mapSize.width + head.x, player);
+    }
+    std::vector<Claim> reached;
+
+    while (!frontier.empty()) {
+        reached.clear();
+        for (const Claim &claim : frontier) {
+            Point from{claim.first % mapSize.width, claim.first / mapSize.width};
+            for (Point next : {Point{from.x, from.y - 1}, Point{from.x, from.y + 1},
+                               Point{from.x - 1, from.y}, Point{from.x + 1, from.y}}) {
+                if (isOnMap(next) && unclaimed.test(next)) {
+                    reached.emplace_back(next.y * mapSize.width + next.x, claim.second);
+                }
+            }
+        }
+        std::sort(reached.begin(), reached.end());
+        frontier.clear();
+        for (std::size_t first = 0, last; first < reached.size(); first = last) {
+            int tile = reached[first].first;
+            bool contested = false;
+            for (last = first + 1; last < reached.size() && reached[last].first == tile; ++last) {
+                contested = contested || reached[last].second != reached[first].second;
+            }
+            unclaimed.reset(Point{tile % mapSize.width, tile / mapSize.width});
+            // Contested tiles don't extend anyone's claim
+            if (!contested) {
+                frontier.push_back(reached[first]);
+                ++tiles[reached[first].second];
+            }
+        }
+    }
+}
+
+auto Tron::getHash() const -> std::uint64_t
 {
-    return players[index];
+    return hash;
 }
 
-auto Tron::getPlayers() const -> const PlayerContainer&
+auto Tron::getPlayingCount() const -> int
 {
-    return players;
+    return playingCount;
+}
+
+auto Tron::getPosition(int player) const -> Point
+{
+    return positions[player];
+}
+
+auto Tron::getDirection(int player) const -> Player::Direction
+{
+    return directions[player];
+}
+
+auto Tron::getIsPlaying(int player) const -> bool
+{
+    return (playing[player / 64] >> (player % 64)) & 1u;
+}
+
+auto Tron::getTrail(int player) const -> const Trail&
+{
+    return trails[player];
+}
+
+auto Tron::getOccupancy() const -> const OccupancyGrid&
+{
+    return occupied;
 }
 
 // Constants
 const int Tron::MIN_PLAYER_COUNT{2};
-const int Tron::MAX_PLAYER_COUNT{4};
+const int Tron::MAX_PLAYER_COUNT{4096};
 
 const int Tron::MIN_MAP_WIDTH{10};
-const int Tron::MAX_MAP_WIDTH{100};
+const int Tron::MAX_MAP_WIDTH{10000};
 
 const int Tron::MIN_MAP_HEIGHT{10};
-const int Tron::MAX_MAP_HEIGHT{100};
+const int Tron::MAX_MAP_HEIGHT{10000};
+
+const int Tron::DEFAULT_MAP_WIDTH{100};
+const int Tron::DEFAULT_MAP_HEIGHT{100};
+
+// Below this, waking the other threads costs more than it saves
+const int Tron::PARALLEL_MIN_PLAYERS{256};
+
+// Two boards of this many tiles come to 128 MiB
+const std::size_t Tron::TERRITORY_BOARD_TILES{std::size_t{1} << 29};
@@ -1,15 +1,22 @@
 #ifndef TRON_H
 #define TRON_H
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
-#include <QSize>
-#include <QColor>
-#include <QString>
-
+#include "geometry.h"
 #include "player.h"
+#include "controller.h"
+#include "occupancygrid.h"
+#include "rayindex.h"
+#include "inputqueue.h"
+#include "headtable.h"
+#include "bitboard.h"
+#include "trail.h"
 
-typedef std::vector<Player> PlayerContainer;
+class ReplayRecorder;
+class TickProfiler;
 
 class Tron
 {
@@ -23,43 +30,341 @@ public:
     static const int MIN_MAP_HEIGHT;
     static const int MAX_MAP_HEIGHT;
 
-    explicit Tron(QSize mapSize,
-                  int playerCount,
-                  std::vector<QString> playerNames,
-                  std::vector<QColor> playerColors);
+    static const int DEFAULT_MAP_WIDTH;
+    static const int DEFAULT_MAP_HEIGHT;
+
+    //! Fewest players in play for step() to use more than one thread.
+    static const int PARALLEL_MIN_PLAYERS;
+    //! Most tiles, over every player in play, territories() grows as bitboards.
+    /*!
+     * Each player takes two boards the size of the map, so beyond
+     * this territories() grows one shared frontier instead.
+     */
+    static const std::size_t TERRITORY_BOARD_TILES;
+
+    explicit Tron(Size mapSize, int playerCount);
+    //! Copy the state of a game, for looking ahead.
+    /*!
+     * Controllers, the recorder, the profiler, step threads and
+     * queued turns are not copied.
+     */
+    Tron(const Tron &other);
+    ~Tron();
 
     //! Update all players.
     auto step() -> bool;
+    //! Queue a turn for `player`, to be applied by a later step().
+    /*!
+     * Safe to call from one thread per player while another runs
+     * step(). Each step() applies at most one queued turn per
+     * player, so quick successive turns all take effect.
+     * \param timestamp of the input, in steady_clock nanoseconds.
+     * \return Whether the queue had room for the turn.
+     */
+    auto queueTurn(int player, Player::Direction direction,
+                   std::int64_t timestamp) -> bool;
+    //! Change direction of `player` immediately.
+    /*!
+     * For computer-controlled players deciding on the simulation
+     * thread; no checks are made.
+     */
+    void turn(int player, Player::Direction direction);
+    //! Hand `player` over to `controller`, or back to input if null.
+    /*!
+     * Each step() asks the controller of every player in play for
+     * a direction before anyone moves.
+     */
+    void setController(int player, std::unique_ptr<Controller> controller);
+    //! Record every move from now on with `recorder`, or stop if null.
+    /*!
+     * Must be set before the first move; `recorder` is not owned
+     * and has to outlive the game or be removed first.
+     */
+    void setRecorder(ReplayRecorder *recorder);
+    //! Time the stages of every step() with `profiler`, or stop if null.
+    /*!
+     * `profiler` is not owned and has to outlive the game or be
+     * removed first.
+     */
+    void setProfiler(TickProfiler *profiler);
+    //! Split each step() across `threadCount` threads, counting the caller's.
+    /*!
+     * Steps with fewer than PARALLEL_MIN_PLAYERS in play still run
+     * on the caller alone. The game played is the same either way.
+     */
+    void setStepThreads(int threadCount);
+    //! Get the threads step() may use, counting the caller's.
+    auto getStepThreads() const -> int;
+    //! Put `player` at `position`, heading `direction`, with `trail` behind it.
+    /*!
+     * For rebuilding a saved game in a new one: only players that
+     * haven't moved yet can be placed, and nothing is checked.
+     */
+    void placePlayer(int player, Trail trail, Point position,
+                     Player::Direction direction, bool isPlaying);
+    //! Set the number of moves made so far, as with placePlayer().
+    /*!
+     * For rebuilding a saved game part way through, so getTick()
+     * carries on from where it was saved. Nothing is checked.
+     */
+    void placeTick(int tick);
+    //! Move every player in play one tile, in a way that can be undone.
+    /*!
+     * Like step(), but with `moves[i]` as the direction of player
+     * `i`, and without queued turns, controllers or waiting for
+     * everyone to pick a direction. Meant for search; each call
+     * must be matched by an unmakeMove().
+     */
+    void makeMove(const std::vector<Player::Direction> &moves);
+    //! Undo the most recent makeMove() still in effect.
+    void unmakeMove();
+    //! Keep what it takes to rewind() up to `ticks` moves, or none if 0.
+    /*!
+     * Costs a few words per player moved per tick kept.
+     */
+    void setRewindLimit(int ticks);
+    auto getRewindLimit() const -> int; //!< Get ticks step() keeps to rewind.
+    //! Get how many moves rewind() can currently undo.
+    auto getRewindableTicks() const -> int;
+    //! Undo the last `ticks` moves, made by step() or makeMove().
+    /*!
+     * Players head the way they last moved, and those taken out
+     * since are back in play, so the game can be stepped again
+     * with different turns, e.g. once late input from the network
+     * arrives. Queued turns, controllers and the recorder are left
+     * as they are; rewinding while recording is not allowed.
+     */
+    void rewind(int ticks);
+    //! Start a new game on the same map with the same players.
+    /*!
+     * Everyone is back at their start position with no direction,
+     * as in a new Tron, but storage for trails, the occupancy and
+     * undo stacks is kept, so playing game after game in one
+     * object allocates little once the first few are done.
+     * Controllers, the profiler, step threads and the rewind limit
+     * are kept; queued turns are dropped. Not allowed while
+     * recording.
+     */
+    void reset();
+    //! Allocate now what games of up to `turns` turns per player need.
+    /*!
+     * Every occupancy chunk, room for the turns in each trail, and
+     * the undo stacks for the rewind limit set, so such games, and
+     * reset() between them, never allocate.
+     */
+    void reserve(std::size_t turns);
+    //! Get the number of moves made so far.
+    auto getTick() const -> int;
     //! Check if game is complete.
-    auto gameIsOver() -> bool;
-    //! Get an iterator to the winner, if there is one.
-    auto getWinner() -> PlayerContainer::iterator;
+    auto gameIsOver() const -> bool;
+    //! Get the index of the winner, or -1 in the event of a tie.
+    auto getWinner() const -> int;
 
-    auto getMapSize() const -> QSize; //!< Get map size in tiles.
+    //! Check if `position` is off the map or covered by a trail.
+    /*!
+     * Useful for computer-controlled players looking ahead.
+     */
+    auto isBlocked(Point position) const -> bool;
+
+    //! Get a bitboard of the tiles no trail or head in play covers.
+    /*!
+     * For bots that ask many flood-fill questions a tick: build
+     * this once, then fill within it as often as needed.
+     */
+    auto getFreeTiles() const -> Bitboard;
+    //! Count free tiles reachable from `from`, not counting `from` itself.
+    auto reachableArea(Point from) const -> int;
+    //! Count free tiles from `from` in `direction` up to a trail or the edge.
+    /*!
+     * `from` itself isn't counted, nor are heads, as in
+     * isBlocked(); 0 if `from` is off the map. Takes a few word
+     * lookups however far the run goes.
+     */
+    auto freeRun(Point from, Player::Direction direction) const -> int;
+    //! Get the fewest steps from `from` to a trail or off the map.
+    /*!
+     * What lies in between doesn't matter, so this is how close
+     * the nearest obstacle is, not how far `from` can go. Obstacles
+     * further than RayIndex::MAX_OBSTACLE_DISTANCE are reported at
+     * that distance, so the cost is bounded: a few word lookups per
+     * row within the answer, and never more than twice the cap rows.
+     */
+    auto obstacleDistance(Point from) const -> int;
+    //! Count, for each player, the free tiles it reaches before anyone else.
+    /*!
+     * A breadth-first search from every head in play at once; tiles
+     * reached by two players at the same time count for nobody.
+     * Takes two map-sized bitboards per player in play while they
+     * fit in TERRITORY_BOARD_TILES, else one board and a list of
+     * the tiles on the frontier, however many players there are.
+     * \param tiles Filled with one count per player, zero for
+     * players out of play.
+     */
+    void territories(std::vector<int> &tiles) const;
+
+    auto getMapSize() const -> Size; //!< Get map size in tiles.
     auto getPlayerCount() const -> int; //!< Get player count.
-    auto getPlayer(int index) -> Player&; //! Get player at `index`.
-    //! Get a reference to player container.
+    auto getPlayingCount() const -> int; //!< Get number of players still in play.
+    //! Get the Zobrist hash of every trail, head and who is in play.
+    /*!
+     * Kept up to date as tiles are occupied, so reading it is free.
+     */
+    auto getHash() const -> std::uint64_t;
+
+    auto getPosition(int player) const -> Point; //!< Get position of `player`.
+    auto getDirection(int player) const -> Player::Direction; //!< Get direction of `player`.
+    //! Check if `player` is in play.
+    auto getIsPlaying(int player) const -> bool;
+    //! Get every location `player` has been.
     /*!
+     * Does not include the position currently at.
      * Useful for drawing routines.
      */
-    auto getPlayers() const -> const PlayerContainer&;
+    auto getTrail(int player) const -> const Trail&;
+    //! Get every tile covered by a trail.
+    /*!
+     * For reading many tiles at once, a word at a time.
+     */
+    auto getOccupancy() const -> const OccupancyGrid&;
 
 private:
     //! Size of the map in tiles.
-    const QSize mapSize;
+    const Size mapSize;
     //! Number of players.
     const int playerCount;
-    //! Players.
-    PlayerContainer players;
 
+    // Player state, one entry per player.
+    //! Where each player is.
+    std::vector<Point> positions;
+    //! Which direction each player is traveling.
+    std::vector<Player::Direction> directions;
+    //! Bit per player: whether it is playing (can move).
+    std::vector<std::uint64_t> playing;
+    //! All locations each player has been.
+    std::vector<Trail> trails;
+    //! Number of bits set in `playing`.
+    int playingCount;
+    //! Whether every player has picked a direction yet.
+    bool started{false};
+
+    //! Every tile covered by any player's trail.
+    /*!
+     * Mirrors `trails` so that collision checks don't have to
+     * scan them.
+     */
+    OccupancyGrid occupied;
+    //! Free runs along the rows and columns of `occupied`.
+    RayIndex rays;
+    //! Turns waiting to be applied, one queue per player.
+    std::unique_ptr<InputQueue[]> inputs;
+    //! Heads claimed during the current step.
+    HeadTable heads;
+    //! Players found colliding during the current step.
+    std::vector<int> colliding;
+    //! Controller of each player, null for players driven by input.
+    std::vector<std::unique_ptr<Controller>> controllers;
+    //! Where moves are recorded, if anywhere.
+    ReplayRecorder *recorder{nullptr};
+    //! Where step() timings go, if anywhere.
+    TickProfiler *profiler{nullptr};
+    //! Threads and scratch space of parallel steps; see setStepThreads().
+    struct ParallelStep;
+    std::unique_ptr<ParallelStep> parallel;
+    //! Zobrist hash of the game; see getHash().
+    std::uint64_t hash{0};
+    //! Moves made; see getTick().
+    int tick{0};
+    //! Moves of step() kept on the undo stacks; see setRewindLimit().
+    int rewindLimit{0};
+
+    //! Where one makeMove()'s entries start in the undo stacks.
+    struct UndoFrame
+    {
+        std::size_t moves;
+        std::size_t eliminations;
+    };
+    //! Direction a player had before a makeMove().
+    struct UndoMove
+    {
+        int player;
+        Player::Direction direction;
+    };
+    //! One entry per move that can be undone.
+    std::vector<UndoFrame> undoFrames;
+    //! Every player moved by the moves that can be undone.
+    std::vector<UndoMove> undoMoves;
+    //! Every player eliminated by the moves that can be undone.
+    std::vector<int> undoEliminations;
+
+    //! Throw if the game can't be set up with these parameters.
+    static auto validated(Size mapSize, int playerCount) -> Size;
+    //! Call `visit(index)` for each player still in play.
+    template <typename Visitor>
+    void forEachPlaying(Visitor visit) const;
+    //! Call `visit(index)` for each player in play in words [`first`, `last`) of `playing`.
+    template <typename Visitor>
+    void forEachPlayingIn(std::size_t first, std::size_t last, Visitor visit) const;
+    //! Grow territories() from the heads of `seeds` with a bitboard each.
+    void growTerritoryBoards(const std::vector<int> &seeds, Bitboard &unclaimed,
+                             std::vector<int> &tiles) const;
+    //! Grow territories() from the heads of `seeds` as one list of frontier tiles.
+    void growTerritoryFrontier(const std::vector<int> &seeds, Bitboard &unclaimed,
+                               std::vector<int> &tiles) const;
+    //! Undo the move on top of the undo stacks.
+    void undoLastMove();
+    //! Drop undo frames beyond the rewind limit.
+    void forgetOldMoves();
+    //! Get the direction `player` last moved in, or None.
+    auto lastMove(int player) const -> Player::Direction;
+    //! Take `player` out of play.
+    /*!
+     * \return Whether `player` was still in play.
+     */
+    auto eliminate(int player) -> bool;
+    //! Put `player` back into play.
+    void restore(int player);
+    //! Move every player in play and take out those that crash.
+    /*!
+     * Players taken out are appended to `eliminated`, if given.
+     */
+    void advancePlayers(std::vector<int> *eliminated);
+    //! Move every player in play one tile, leaving a trail behind.
+    void movePlayers();
+    //! Take out every player that just crashed.
+    /*!
+     * Players taken out are appended to `eliminated`, if given.
+     */
+    void resolveCollisions(std::vector<int> *eliminated);
+    //! Do what advancePlayers() does on the step threads.
+    void advancePlayersInParallel(std::vector<int> *eliminated);
+    //! Take out every player in `colliding`.
+    /*!
+     * Players taken out are appended to `eliminated`, if given.
+     */
+    void eliminateColliding(std::vector<int> *eliminated);
+    //! Get the Zobrist key of a trail covering `position`.
+    auto trailKey(Point position) const -> std::uint64_t;
+    //! Get the Zobrist key of `player`'s head at `position`.
+    auto headKey(int player, Point position) const -> std::uint64_t;
+    //! Get the Zobrist key of `player` being out of play.
+    auto outKey(int player) const -> std::uint64_t;
+    //! Apply the next sensible queued turn of each player.
+    void applyInputs();
+    //! Let each controlled player in play pick its direction.
+    void consultControllers();
     //! Check if all players have a valid (non-none) direction.
     auto allReady() -> bool;
-    //! Check if a player is collding.
-    auto isColliding(const Player &) -> bool;
+    //! Check if `position` lies within the map.
+    auto isOnMap(Point position) const -> bool;
+    //! Check if a player is colliding by scanning every trail.
+    /*!
+     * Slow reference for the collision pass in step(), which
+     * should always agree.
+     */
+    auto isCollidingByTrail(int player) const -> bool;
     //! Determine proper starting position for player at `index`
-    auto startPos(int) -> QPoint;
+    auto startPos(int) -> Point;
 
 };
 
-
 #endif // TRON_H
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "tronrunner.h"
+
+TronRunner::TronRunner(Size mapSize, int playerCount, int tickInterval)
+    : tron(mapSize, playerCount)
+    , tickInterval(0)
+    // A tile can only be taken once, so the map area bounds the log.
+    , tiles(static_cast<std::size_t>(mapSize.width) * mapSize.height)
+    , loggedTrail(playerCount, 0)
+{
+    setTickInterval(tickInterval);
+    publishFrame();
+}
+
+TronRunner::TronRunner(const Tron &position, int tickInterval)
+    : tron(position)
+    , over(position.gameIsOver())
+    , tickInterval(0)
+    , tiles(static_cast<std::size_t>(position.getMapSize().width) * position.getMapSize().height)
+    , loggedTrail(position.getPlayerCount(), 0)
+    , tick(position.getTick())
+{
+    setTickInterval(tickInterval);
+    logTrails();
+    publishFrame();
+}
+
+TronRunner::~TronRunner()
+{
+    stop();
+}
+
+void TronRunner::start()
+{
+    if (!running.exchange(true)) {
+        thread = std::thread{&TronRunner::run, this};
+    }
+}
+
+void TronRunner::stop()
+{
+    running.store(false);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void TronRunner::setTickInterval(int milliseconds)
+{
+    std::chrono::steady_clock::duration interval = std::chrono::milliseconds{std::max(milliseconds, 1)};
+    tickInterval.store(interval.count(), std::memory_order_relaxed);
+}
+
+void TronRunner::setFastForward(bool enabled)
+{
+    fastForward.store(enabled, std::memory_order_relaxed);
+}
+
+void TronRunner::setController(int player, std::unique_ptr<Controller> controller)
+{
+    tron.setController(player, std::move(controller));
+}
+
+void TronRunner::connect(const NetConfig &config)
+{
+    session.reset(new RollbackSession{tron, config});
+}
+
+void TronRunner::watch(std::unique_ptr<SpectatorLink> link)
+{
+    const Tron &watched = link->getView().getTron();
+    if (watched.getMapSize() != tron.getMapSize()
+            || watched.getPlayerCount() != tron.getPlayerCount()) {
+        throw std::logic_error{"Watching a different game."};
+    }
+    // Each snapshot replacing the game logs its trails over again
+    std::size_t area = static_cast<std::size_t>(tron.getMapSize().width) * tron.getMapSize().height;
+    tiles = TileLog{area * (1 + MAX_WATCHED_RESYNCS)};
+    watchedSnapshots = link->getView().getSnapshotCount();
+    this->link = std::move(link);
+    publishFrame();
+}
+
+void TronRunner::setProfiler(TickProfiler *profiler)
+{
+    this->profiler = profiler;
+    tron.setProfiler(profiler);
+}
+
+void TronRunner::turn(int player, Player::Direction direction)
+{
+    if (link) {
+        return;
+    }
+    if (session) {
+        if (player == session->getLocalSeat()) {
+            session->queueTurn(direction);
+        }
+    } else if (player >= 0 && player < tron.getPlayerCount()) {
+        std::chrono::nanoseconds now = std::chrono::steady_clock::now().time_since_epoch();
+        tron.queueTurn(player, direction, now.count());
+    }
+}
+
+auto TronRunner::acquireFrame() -> bool
+{
+    return frames.acquire();
+}
+
+auto TronRunner::getFrame() const -> const FrameSnapshot&
+{
+    return frames.front();
+}
+
+auto TronRunner::getTiles() const -> const TileLog&
+{
+    return tiles;
+}
+
+auto TronRunner::getMapSize() const -> Size
+{
+    return tron.getMapSize();
+}
+
+auto TronRunner::getPlayerCount() const -> int
+{
+    return tron.getPlayerCount();
+}
+
+auto TronRunner::game() const -> const Tron&
+{
+    return link ? link->getView().getTron() : tron;
+}
+
+void TronRunner::run()
+{
+    typedef std::chrono::steady_clock clock;
+    clock::time_point previous = clock::now();
+    clock::duration accumulator{0};
+    while (running.load(std::memory_order_relaxed)) {
+        clock::time_point now = clock::now();
+        accumulator += now - previous;
+        previous = now;
+
+        if (fastForward.load(std::memory_order_relaxed) && !session && !link) {
+            accumulator = clock::duration{0};
+            if (!advance()) {
+                running.store(false);
+            }
+            continue;
+        }
+
+        clock::duration interval{tickInterval.load(std::memory_order_relaxed)};
+        // After a long stall (suspend, debugger) drop the backlog
+        // rather than replaying it all at once.
+        if (accumulator > interval * MAX_CATCH_UP_TICKS) {
+            if (profiler) {
+                clock::duration dropped = accumulator - interval * MAX_CATCH_UP_TICKS;
+                profiler->dropTicks(static_cast<long>(dropped / interval));
+            }
+            accumulator = interval * MAX_CATCH_UP_TICKS;
+        }
+        while (accumulator >= interval && running.load(std::memory_order_relaxed)) {
+            accumulator -= interval;
+            if (!advance()) {
+                running.store(false);
+            }
+        }
+        waitUntil(previous + (interval - accumulator));
+    }
+}
+
+/*!
+ * OS sleeps can overshoot by a millisecond or more, so sleep until
+ * shortly before `deadline` and yield the rest of the way.
+ */
+void TronRunner::waitUntil(std::chrono::steady_clock::time_point deadline)
+{
+    const std::chrono::microseconds SPIN{1000};
+    std::this_thread::sleep_until(deadline - SPIN);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+auto TronRunner::advance() -> bool
+{
+    TickProfiler::StageTimer timer{profiler, TickProfiler::Stage::Tick};
+    bool playing;
+    if (link) {
+        bool open;
+        try {
+            open = link->poll();
+        } catch (const std::runtime_error&) {
+            // A feed gone bad can't be recovered; stop where it was good
+            open = false;
+        }
+        open = followSnapshots() && open;
+        playing = open && !game().gameIsOver();
+        feedLost = !open && !game().gameIsOver();
+    } else {
+        playing = session ? session->update() : tron.step();
+    }
+    over = !playing;
+    ++tick;
+    logTrails();
+    publishFrame();
+    return playing;
+}
+
+/*!
+ * The log is append-only, as the viewer may still be reading it,
+ * so the new game's trails are logged after the old one's.
+ */
+auto TronRunner::followSnapshots() -> bool
+{
+    const SpectatorView &view = link->getView();
+    if (view.getSnapshotCount() == watchedSnapshots) {
+        return true;
+    }
+    const Tron &shown = view.getTron();
+    std::size_t area = static_cast<std::size_t>(shown.getMapSize().width) * shown.getMapSize().height;
+    if (tiles.getCapacity() - tiles.size() < area) {
+        return false;
+    }
+    watchedSnapshots = view.getSnapshotCount();
+    firstTile = tiles.size();
+    std::fill(loggedTrail.begin(), loggedTrail.end(), 0);
+    return true;
+}
+
+/*!
+ * In networked games only tiles taken before the confirmed tick
+ * go into the log, since later ones can still be rewound. A
+ * watched game grows the same way between snapshots, which
+ * followSnapshots() has to be told about first.
+ */
+void TronRunner::logTrails()
+{
+    if (link && link->getView().getSnapshotCount() != watchedSnapshots) {
+        // Replaced by a game there was no room to log
+        return;
+    }
+    const Tron &shown = game();
+    // Log the tiles each player left behind; trail tile k is left
+    // by move k + 1
+    std::size_t confirmed = session ? static_cast<std::size_t>(session->getConfirmedTick())
+                                    : static_cast<std::size_t>(-1);
+    for (int i = 0; i < shown.getPlayerCount(); ++i) {
+        const Trail &trail = shown.getTrail(i);
+        std::size_t end = std::min(trail.size(), confirmed);
+        for (; loggedTrail[i] < end; ++loggedTrail[i]) {
+            tiles.append(OccupiedTile{trail[loggedTrail[i]], i});
+        }
+    }
+}
+
+/*!
+ * The exchange's release ordering also publishes every tile
+ * logged before this call.
+ */
+void TronRunner::publishFrame()
+{
+    const Tron &shown = game();
+    FrameSnapshot &frame = frames.back();
+    int playerCount = shown.getPlayerCount();
+    frame.tick = tick;
+    frame.heads.resize(playerCount);
+    frame.alive.resize(playerCount);
+    for (int i = 0; i < playerCount; ++i) {
+        frame.heads[i] = shown.getPosition(i);
+        frame.alive[i] = shown.getIsPlaying(i);
+    }
+    frame.firstTile = firstTile;
+    frame.tileCount = tiles.size();
+    frame.predicted.clear();
+    for (int i = 0; i < playerCount; ++i) {
+        const Trail &trail = shown.getTrail(i);
+        for (std::size_t t = loggedTrail[i]; t < trail.size(); ++t) {
+            frame.predicted.push_back(OccupiedTile{trail[t], i});
+        }
+    }
+    frame.over = over;
+    frame.feedLost = feedLost;
+    frame.lostSeat = session ? session->getLostSeat() : -1;
+    // A lost feed or peer stops short of the end, so there may be no winner
+    frame.winner = frame.over && shown.gameIsOver() ? shown.getWinner() : -1;
+    frames.publish();
+}
+
+// Constants
+const int TronRunner::MAX_CATCH_UP_TICKS{5};
+const int TronRunner::MAX_WATCHED_RESYNCS{3};
@@ -0,0 +1,180 @@
+#ifndef TRONRUNNER_H
+#define TRONRUNNER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "tron.h"
+#include "rollbacksession.h"
+#include "snapshotexchange.h"
+#include "spectatorlink.h"
+#include "tickprofiler.h"
+#include "tilelog.h"
+
+//! What a viewer needs to draw one tick of a game.
+struct FrameSnapshot
+{
+    //! Ticks simulated so far.
+    long tick = 0;
+    //! Current position of each player.
+    std::vector<Point> heads;
+    //! Whether each player is still in play.
+    std::vector<std::uint8_t> alive;
+    //! Index of the first entry of TronRunner::getTiles() in the game as it is now.
+    /*!
+     * Moves on when a snapshot from the feed replaces a watched
+     * game; entries before it are of the game it replaced.
+     */
+    std::size_t firstTile = 0;
+    //! Number of entries of TronRunner::getTiles() valid for this frame.
+    std::size_t tileCount = 0;
+    //! Trail tiles that may yet be rewound, so not in the log.
+    /*!
+     * Only networked games have any: tiles taken while other
+     * peers' turns are still being guessed.
+     */
+    std::vector<OccupiedTile> predicted;
+    //! Whether the game has finished, or stopped being shown.
+    bool over = false;
+    //! Whether the watched game stopped arriving before it finished.
+    bool feedLost = false;
+    //! Seat of a peer lost before a networked game finished, or -1.
+    int lostSeat = -1;
+    //! Index of the winner once `over`, or -1 for a tie or a game cut short.
+    int winner = -1;
+};
+
+//! Plays a game of Tron on its own thread.
+/*!
+ * The simulation runs a fixed-timestep loop against the monotonic
+ * clock: elapsed time is accumulated and paid out in whole ticks,
+ * so the game runs at the same speed on every machine regardless
+ * of timer jitter or how long the viewer takes to draw. In
+ * fast-forward it ticks as fast as it can instead, and the viewer
+ * simply draws whatever is newest. After every tick a FrameSnapshot is
+ * published; trail tiles go into an append-only TileLog, so a
+ * viewer can read every tile up to a snapshot's `tileCount`
+ * without locking.
+ */
+class TronRunner
+{
+public:
+    //! Most ticks run back-to-back to catch up after a stall.
+    static const int MAX_CATCH_UP_TICKS;
+    //! Snapshots replacing a watched game that there is always room to log.
+    /*!
+     * Each takes room for a whole map in the tile log; once there
+     * is none left for another, the feed is given up as lost.
+     */
+    static const int MAX_WATCHED_RESYNCS;
+
+    TronRunner(Size mapSize, int playerCount, int tickInterval);
+    //! Carry on from `position`; its controllers aren't copied.
+    TronRunner(const Tron &position, int tickInterval);
+    ~TronRunner();
+
+    //! Start ticking.
+    void start();
+    //! Stop ticking and wait for the simulation thread to finish.
+    void stop();
+
+    //! Set milliseconds per tick (any thread).
+    void setTickInterval(int milliseconds);
+    //! Tick as fast as possible rather than in real time (any thread).
+    void setFastForward(bool enabled);
+
+    //! Hand `player` over to `controller` (before start() only).
+    void setController(int player, std::unique_ptr<Controller> controller);
+    //! Play one seat of a game shared over the network (before start() only).
+    /*!
+     * Ticks follow the clock as usual, but fast-forward is ignored
+     * and only the local seat takes turns. Every peer has to use
+     * the same map size and tick interval. If a peer goes quiet
+     * for too long the game stops, and the last frame says which.
+     */
+    void connect(const NetConfig &config);
+    //! Show a game played elsewhere rather than playing one (before start() only).
+    /*!
+     * The game shown is whatever `link` receives; the map size and
+     * player count must match it. Turns and fast-forward are
+     * ignored. If the feed closes or goes bad before the game is
+     * over, the last frame says the feed was lost.
+     */
+    void watch(std::unique_ptr<SpectatorLink> link);
+    //! Time every tick with `profiler`, which must outlive the runner (before start() only).
+    void setProfiler(TickProfiler *profiler);
+    //! Queue a turn for `player` (one input thread only).
+    void turn(int player, Player::Direction direction);
+
+    //! Take the newest snapshot, if one has been published (viewer only).
+    auto acquireFrame() -> bool;
+    //! Get the snapshot taken by acquireFrame() (viewer only).
+    auto getFrame() const -> const FrameSnapshot&;
+    //! Get the trail tile log; valid up to getFrame().tileCount.
+    auto getTiles() const -> const TileLog&;
+
+    auto getMapSize() const -> Size; //!< Get map size in tiles.
+    auto getPlayerCount() const -> int; //!< Get player count.
+
+private:
+    //! The game being played; only touched by the simulation thread.
+    Tron tron;
+    //! Keeps `tron` in step with other peers, in networked games.
+    std::unique_ptr<RollbackSession> session;
+    //! Brings the game being watched, instead of `tron`.
+    std::unique_ptr<SpectatorLink> link;
+    //! Where tick timings and dropped ticks go, if anywhere.
+    TickProfiler *profiler{nullptr};
+    //! Whether the game has finished; for networked games, once
+    //! other peers no longer need us.
+    bool over{false};
+    //! Whether the watched feed ended before the game did.
+    bool feedLost{false};
+    //! Length of a tick in steady_clock ticks.
+    std::atomic<long long> tickInterval;
+    //! Whether to ignore `tickInterval` and run flat out.
+    std::atomic<bool> fastForward{false};
+    //! Every trail tile in the order it was taken.
+    TileLog tiles;
+    //! Entry of `tiles` where the game shown now starts.
+    std::size_t firstTile{0};
+    //! Trail length of each player when last logged.
+    std::vector<std::size_t> loggedTrail;
+    //! Snapshots the watched game had when last logged.
+    long watchedSnapshots{0};
+    //! Frames passed to the viewer.
+    SnapshotExchange<FrameSnapshot> frames;
+    //! Ticks simulated so far.
+    long tick{0};
+
+    std::atomic<bool> running{false};
+    std::thread thread;
+
+    //! Get the game being shown: `tron`, or the one being watched.
+    auto game() const -> const Tron&;
+    //! Simulation thread body.
+    void run();
+    //! Sleep until `deadline` as precisely as the platform allows.
+    static void waitUntil(std::chrono::steady_clock::time_point deadline);
+    //! Advance the game by one tick.
+    /*!
+     * \return Whether the game is still in progress.
+     */
+    auto advance() -> bool;
+    //! Start logging afresh if a snapshot has replaced the watched game.
+    /*!
+     * \return Whether there was room in the log to do so.
+     */
+    auto followSnapshots() -> bool;
+    //! Log the trail tiles taken since the last call.
+    void logTrails();
+    //! Fill and publish the next snapshot.
+    void publishFrame();
+
+};
+
+#endif // TRONRUNNER_H
@@ -1,57 +1,129 @@
 #include <exception>
+#include <fstream>
+#include <stdexcept>
 #include <utility>
 
+#include <QFileDialog>
 #include <QMessageBox>
 
 #include "tronwidget.h"
+#include "bots.h"
 #include "clamp.h"
 
 TronWidget::TronWidget(QWidget *parent) :
     QWidget(parent)
 {
-    QObject::connect(&ticker, SIGNAL(timeout()),
-                     this, SLOT(step()));
-    // TODO: Let user modify this interval?
-    ticker.setInterval(DEFAULT_TICK_INTERVAL);
+    QObject::connect(&frameTimer, SIGNAL(timeout()),
+                     this, SLOT(showFrame()));
+    frameTimer.setInterval(DEFAULT_FRAME_INTERVAL);
 }
 
 TronWidget::~TronWidget()
 {
-    tron.reset(nullptr);
+    runner.reset(nullptr);
 }
 
+/*!
+ * Seats after the human players go to bots, topped up so there
+ * are always enough players for a game.
+ */
 void TronWidget::start()
 {
-    tron.reset(new Tron(mapSize, playerCount, playerNames, playerColors));
-    resizeMap();
+    int seats = std::max(playerCount + botCount, Tron::MIN_PLAYER_COUNT);
+    int humans = playerCount;
+    if (networked) {
+        seats = static_cast<int>(network.peers.size());
+        humans = seats;
+    }
+    // The last game's thread writes to the old profiler until it's gone
+    runner.reset(nullptr);
+    profiler.reset(new TickProfiler);
+    lastFrame = TickProfiler::Clock::time_point{};
+    try {
+        if (watchedMatch != 0) {
+            // The server decides the map and players, so ask it first
+            std::unique_ptr<SpectatorLink> link{new SpectatorLink{spectatorServer, watchedMatch}};
+            const Tron &watched = link->getView().getTron();
+            seats = watched.getPlayerCount();
+            humans = 0;
+            runner.reset(new TronRunner(watched.getMapSize(), seats, tickInterval));
+            runner->watch(std::move(link));
+        } else {
+            runner.reset(new TronRunner(Size{mapSize.width(), mapSize.height()},
+                                        seats, tickInterval));
+        }
+        if (networked) {
+            runner->connect(network);
+        }
+    } catch (const std::exception &error) {
+        runner.reset(nullptr);
+        QMessageBox::critical(this, "Can't Start Game", error.what());
+        return;
+    }
+    seatColors.assign(playerColors.begin(), playerColors.begin() + humans);
+    if (watchedMatch == 0) {
+        for (int i = humans; i < seats; ++i) {
+            runner->setController(i, std::unique_ptr<Controller>{new VoronoiBot{}});
+        }
+    }
+    std::vector<QColor> botColors = BoardPainter::spreadColors(seats - humans);
+    seatColors.insert(seatColors.end(), botColors.begin(), botColors.end());
+    runner->setFastForward(fastForward);
+    runner->setProfiler(profiler.get());
+    resetBoard();
     setFocus(Qt::OtherFocusReason);
-    ticker.start();
+    runner->start();
+    frameTimer.start();
     emit gameInProgress(true);
 }
 
 void TronWidget::stop()
 {
-    ticker.stop();
+    frameTimer.stop();
+    if (runner) {
+        runner->stop();
+    }
     emit gameInProgress(false);
 }
 
-void TronWidget::step()
+void TronWidget::showFrame()
 {
-    if (tron) {
-        if (tron->step()) {
-            repaint(rect());
+    if (runner && runner->acquireFrame()) {
+        TickProfiler::Clock::time_point now = TickProfiler::Clock::now();
+        if (profiler && lastFrame != TickProfiler::Clock::time_point{}) {
+            profiler->record(TickProfiler::Stage::Frame, lastFrame, now);
+        }
+        lastFrame = now;
+        {
+            TickProfiler::StageTimer timer{profiler.get(), TickProfiler::Stage::Draw};
+            drawFrame();
+        }
+        const FrameSnapshot &frame = runner->getFrame();
+        if (!frame.over) {
+            update();
         } else {
             stop();
             repaint(rect());
-            auto winner = tron->getWinner();
+            if (frame.feedLost) {
+                QMessageBox::warning(this, "Feed Lost",
+                                     "The server stopped sending the game before it was over.");
+                return;
+            }
+            if (frame.lostSeat >= 0) {
+                QMessageBox::warning(this, "Connection Lost",
+                                     QString{"Nothing has been heard from %1 for too long."}
+                                     .arg(seatName(frame.lostSeat)));
+                return;
+            }
             QString winnerString;
             QString colorString;
-            if (winner == tron->getPlayers().end()) {
+            if (frame.winner < 0) {
                 winnerString = "Tie Game";
                 colorString = "white";
             } else {
-                winnerString = QString{"%1 wins!"}.arg(winner->getName());
-                colorString = winner->getColor().name();
+                int index = frame.winner;
+                winnerString = QString{"%1 wins!"}.arg(seatName(index));
+                colorString = seatColors[index].name();
             }
             QMessageBox gameOverDialog{QMessageBox::Information, "Game Over", winnerString, QMessageBox::Ok, this};
             gameOverDialog.setStyleSheet(QString("color: %1").arg(colorString));
@@ -60,11 +132,43 @@ void TronWidget::step()
     }
 }
 
+void TronWidget::showPosition(const Tron &position)
+{
+    stop();
+    runner.reset(new TronRunner(position, tickInterval));
+    seatColors = BoardPainter::spreadColors(position.getPlayerCount());
+    resetBoard();
+    drawFrame();
+    update();
+}
+
+void TronWidget::setNetwork(const NetConfig &config)
+{
+    if (config.peers.size() < static_cast<std::size_t>(Tron::MIN_PLAYER_COUNT)
+            || config.peers.size() > static_cast<std::size_t>(MAX_PLAYER_COUNT)) {
+        throw std::logic_error{"Bad number of peers."};
+    }
+    network = config;
+    networked = true;
+}
+
+void TronWidget::setSpectator(NetAddress server, std::uint64_t match)
+{
+    if (match == 0) {
+        throw std::logic_error{"Bad match."};
+    }
+    spectatorServer = server;
+    watchedMatch = match;
+}
+
 void TronWidget::setPlayerCount(int playerCount)
 {
-    this->playerCount = clamp(playerCount,
-                              Tron::MIN_PLAYER_COUNT,
-                              Tron::MAX_PLAYER_COUNT);
+    this->playerCount = clamp(playerCount, 0, MAX_PLAYER_COUNT);
+}
+
+void TronWidget::setBotCount(int botCount)
+{
+    this->botCount = clamp(botCount, 0, MAX_BOT_COUNT);
 }
 
 void TronWidget::setPlayerName(int player, QString name)
@@ -101,18 +205,189 @@ void TronWidget::setMapHeight(int height)
                                   Tron::MAX_MAP_HEIGHT));
 }
 
+void TronWidget::setTickInterval(int interval)
+{
+    tickInterval = clamp(interval, MIN_TICK_INTERVAL, MAX_TICK_INTERVAL);
+    if (runner) {
+        runner->setTickInterval(tickInterval);
+    }
+}
+
+void TronWidget::setFastForward(bool enabled)
+{
+    fastForward = enabled;
+    if (runner) {
+        runner->setFastForward(fastForward);
+    }
+}
+
+auto TronWidget::seatName(int index) const -> QString
+{
+    if (watchedMatch != 0) {
+        return QString{"Player %1"}.arg(index + 1);
+    }
+    if (networked || index < playerCount) {
+        return playerNames[index];
+    }
+    return QString{"Bot %1"}.arg(index - playerCount + 1);
+}
+
+void TronWidget::resetBoard()
+{
+    runner->acquireFrame();
+    board.reset(runner->getMapSize(), seatColors);
+    followedPlayer = 0;
+    resizeMap();
+}
+
 void TronWidget::resizeMap()
 {
-    if (tron) {
-        // We need to keep the map on-screen no matter
+    if (runner) {
+        // We try to keep the map on-screen no matter
         // how the window is resized, so we choose the
         // smallest dimension and divide it evenly.
-        int tileWidth = rect().width() / tron->getMapSize().width();
-        int tileHeight = rect().height() / tron->getMapSize().height();
+        int tileWidth = rect().width() / runner->getMapSize().width;
+        int tileHeight = rect().height() / runner->getMapSize().height;
         tileSize = std::min(tileWidth, tileHeight);
+        // Unless the map is too big for that, or the user zoomed in
+        if (zoomTileSize > 0) {
+            tileSize = zoomTileSize;
+        } else if (tileSize < MIN_ZOOM_TILE_SIZE) {
+            tileSize = DEFAULT_TILE_SIZE;
+        }
     } else {
         tileSize = DEFAULT_TILE_SIZE;
     }
+    rebuildBoard();
+}
+
+auto TronWidget::showsWholeMap() const -> bool
+{
+    return runner
+            && runner->getMapSize().width * tileSize <= rect().width()
+            && runner->getMapSize().height * tileSize <= rect().height();
+}
+
+void TronWidget::rebuildBoard()
+{
+    board.setTileSize(tileSize);
+    // Too big to cache otherwise; paintViewport() draws what's visible.
+    if (showsWholeMap()) {
+        board.cacheImage(runner->getFrame(), !networked);
+    }
+}
+
+void TronWidget::drawFrame()
+{
+    board.addFrame(runner->getFrame(), runner->getTiles(), !networked);
+}
+
+/*!
+ * Only the runs near the widget are drawn, so the cost depends on
+ * the window size rather than the map size.
+ */
+void TronWidget::paintViewport(QPainter &painter)
+{
+    const FrameSnapshot &frame = runner->getFrame();
+    Size mapSize = runner->getMapSize();
+
+    // Centre on the followed player's head
+    Point centre = frame.heads[followedPlayer];
+    int originX = centre.x * tileSize + tileSize / 2 - rect().width() / 2;
+    int originY = centre.y * tileSize + tileSize / 2 - rect().height() / 2;
+    painter.fillRect(rect(), Qt::darkGray);
+    painter.translate(-originX, -originY);
+
+    // Visible tiles, clipped to the map
+    int left = std::max(0, originX / tileSize);
+    int top = std::max(0, originY / tileSize);
+    int right = std::min(mapSize.width, (originX + rect().width()) / tileSize + 1);
+    int bottom = std::min(mapSize.height, (originY + rect().height()) / tileSize + 1);
+    board.paintArea(painter, left, top, right, bottom);
+    board.drawPredicted(painter, frame);
+}
+
+void TronWidget::zoom(int steps)
+{
+    int current = zoomTileSize > 0 ? zoomTileSize : tileSize;
+    zoomTileSize = clamp(current + steps, MIN_ZOOM_TILE_SIZE, MAX_ZOOM_TILE_SIZE);
+    resizeMap();
+    update();
+}
+
+void TronWidget::followNextPlayer()
+{
+    const FrameSnapshot &frame = runner->getFrame();
+    int count = static_cast<int>(frame.heads.size());
+    for (int i = 1; i <= count; ++i) {
+        int candidate = (followedPlayer + i) % count;
+        if (frame.alive[candidate]) {
+            followedPlayer = candidate;
+            break;
+        }
+    }
+    update();
+}
+
+/*!
+ * Times are the 50th and 99th percentiles and the worst since the
+ * game started, in milliseconds.
+ */
+void TronWidget::drawStats(QPainter &painter)
+{
+    typedef TickProfiler::Stage Stage;
+    QStringList lines;
+    for (Stage stage : {Stage::Tick, Stage::Input, Stage::Move, Stage::Collision,
+                        Stage::Draw, Stage::Paint, Stage::Frame}) {
+        const LatencyHistogram &histogram = profiler->getHistogram(stage);
+        lines << QString{"%1 p50 %2  p99 %3  max %4"}
+                 .arg(TickProfiler::stageName(stage), -9)
+                 .arg(histogram.percentile(0.5) / 1e6, 7, 'f', 2)
+                 .arg(histogram.percentile(0.99) / 1e6, 7, 'f', 2)
+                 .arg(histogram.getMax() / 1e6, 7, 'f', 2);
+    }
+    lines << QString{"dropped ticks %1"}.arg(profiler->getDroppedTicks());
+
+    painter.save();
+    // Over the widget, not the map, however the viewport moved it
+    painter.resetTransform();
+    QFont font{"Monospace"};
+    font.setStyleHint(QFont::TypeWriter);
+    painter.setFont(font);
+    QFontMetrics metrics{font};
+    int width = 0;
+    for (const QString &line : lines) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+        width = std::max(width, metrics.horizontalAdvance(line));
+#else
+        width = std::max(width, metrics.width(line));
+#endif
+    }
+    const int MARGIN = 4;
+    painter.fillRect(0, 0, width + 2 * MARGIN, lines.size() * metrics.lineSpacing() + 2 * MARGIN,
+                     QColor{0, 0, 0, 192});
+    painter.setPen(Qt::white);
+    for (int i = 0; i < lines.size(); ++i) {
+        painter.drawText(MARGIN, MARGIN + i * metrics.lineSpacing() + metrics.ascent(), lines[i]);
+    }
+    painter.restore();
+}
+
+void TronWidget::saveTrace()
+{
+    if (!profiler) {
+        return;
+    }
+    QString path = QFileDialog::getSaveFileName(this, "Save Trace", "tron-trace.json",
+                                                "Chrome trace (*.json)");
+    if (path.isEmpty()) {
+        return;
+    }
+    std::ofstream out{QFile::encodeName(path).constData()};
+    profiler->writeTrace(out);
+    if (!out) {
+        QMessageBox::warning(this, "Can't Save Trace", QString{"Can't write %1."}.arg(path));
+    }
 }
 
 void TronWidget::resizeEvent(QResizeEvent *)
@@ -122,45 +397,67 @@ void TronWidget::resizeEvent(QResizeEvent *)
 
 void TronWidget::paintEvent(QPaintEvent *)
 {
-    if (tron) {
+    if (runner) {
+        TickProfiler::StageTimer timer{profiler.get(), TickProfiler::Stage::Paint};
         QPainter painter{this};
-
-        // Paint playing board
-        painter.setBrush(Qt::black);
-        painter.setPen(QPen(QBrush(Qt::white), 1));
-        painter.drawRect(rect().x(), rect().y(),
-                         tron->getMapSize().width()*tileSize,
-                         tron->getMapSize().height()*tileSize);
-
-        // Draw each player and its trail
-        painter.setPen(QPen(QBrush(Qt::white), 1));
-        for(int i = 0; i < tron->getPlayerCount(); ++i) {
-            auto player = tron->getPlayer(i);
-            painter.setBrush(player.getColor());
-            if (player.getIsPlaying()) {
-                QPoint p = player.getPosition();
-                painter.drawRect(p.x() * tileSize, p.y() * tileSize,
-                                 tileSize, tileSize);
-            }
-            for (QPoint pt : player.getTrail()) {
-                painter.drawRect(pt.x() * tileSize, pt.y() * tileSize,
-                                 tileSize, tileSize);
+        if (!board.getImage().isNull()) {
+            painter.drawImage(0, 0, board.getImage());
+            if (networked) {
+                board.drawPredicted(painter, runner->getFrame());
             }
+        } else {
+            paintViewport(painter);
+        }
+        if (showingStats && profiler) {
+            drawStats(painter);
         }
     }
 }
 
+void TronWidget::wheelEvent(QWheelEvent *event)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    int delta = event->angleDelta().y();
+#else
+    int delta = event->delta();
+#endif
+    // Sideways scrolling has no vertical delta and doesn't zoom
+    if (runner && delta != 0) {
+        zoom(delta > 0 ? 1 : -1);
+    } else {
+        QWidget::wheelEvent(event);
+    }
+}
+
 void TronWidget::keyPressEvent(QKeyEvent *event)
 {
-    if (tron) {
+    if (runner) {
         if (keybindings.count(event->key()) > 0) {
             // This key press is a game control
             auto binding = keybindings.at(event->key());
-            // Check if this binding applies to an active player
-            if (binding.first < tron->getPlayerCount()) {
-                // Make the turn
-                tron->getPlayer(binding.first).turn(binding.second);
+            if (networked) {
+                // Any keys steer the one seat played here
+                runner->turn(network.localSeat, binding.second);
+            } else if (binding.first < playerCount) {
+                // The binding applies to a human player; make the turn
+                runner->turn(binding.first, binding.second);
             }
+        } else if (event->key() == Qt::Key_Plus || event->key() == Qt::Key_Equal) {
+            zoom(1);
+        } else if (event->key() == Qt::Key_Minus) {
+            zoom(-1);
+        } else if (event->key() == Qt::Key_0) {
+            // Back to fitting the whole map, if it fits
+            zoomTileSize = 0;
+            resizeMap();
+            update();
+        } else if (event->key() == Qt::Key_C) {
+            followNextPlayer();
+        } else if (event->key() == Qt::Key_F3) {
+            showingStats = !showingStats;
+            update();
+        } else if (event->key() == Qt::Key_F4) {
+            saveTrace();
         } else {
             // This key press doesn't concern our game directly
             // Pass it on to the default Qt implementation
@@ -194,6 +491,14 @@ TronWidget::keybindings
     {Qt::Key_H, {3, Player::Direction::Right}},
 };
 
+const int TronWidget::MAX_PLAYER_COUNT{4};
+// Few enough for every bot to get a hue of its own
+const int TronWidget::MAX_BOT_COUNT{64};
 const int TronWidget::DEFAULT_TILE_SIZE{20};
+const int TronWidget::MIN_ZOOM_TILE_SIZE{2};
+const int TronWidget::MAX_ZOOM_TILE_SIZE{40};
+const int TronWidget::MIN_TICK_INTERVAL{5};
+const int TronWidget::MAX_TICK_INTERVAL{1000};
 const int TronWidget::DEFAULT_TICK_INTERVAL{80};
+const int TronWidget::DEFAULT_FRAME_INTERVAL{16};
 
@@ -7,40 +7,128 @@
 #include <QWidget>
 #include <QTimer>
 #include <QColor>
+#include <QImage>
 
+#include "boardpainter.h"
 #include "tron.h"
+#include "tronrunner.h"
 
 class TronWidget : public QWidget
 {
     Q_OBJECT
 public:
+    //! Most players that can share the keyboard.
+    static const int MAX_PLAYER_COUNT;
+    //! Most computer-controlled players in one game.
+    static const int MAX_BOT_COUNT;
     static const int DEFAULT_TILE_SIZE;
+    static const int MIN_ZOOM_TILE_SIZE;
+    static const int MAX_ZOOM_TILE_SIZE;
+    static const int MIN_TICK_INTERVAL;
+    static const int MAX_TICK_INTERVAL;
     static const int DEFAULT_TICK_INTERVAL;
+    static const int DEFAULT_FRAME_INTERVAL;
 
     explicit TronWidget(QWidget *parent = 0);
     ~TronWidget();
 
     auto getPlayerName(int) const -> QString;
     auto getPlayerColor(int) const -> QColor;
+    //! Play later games over the network with `config`.
+    /*!
+     * Each peer plays one seat, with any of the keyboard bindings;
+     * there are no bots. Map size and tick interval must be the
+     * same on every peer.
+     */
+    void setNetwork(const NetConfig &config);
+    //! Watch match `match` on tron-server `server` in later games.
+    /*!
+     * Nothing is played here: the game shown is whatever the
+     * server sends, and keys only move the view.
+     */
+    void setSpectator(NetAddress server, std::uint64_t match);
+    //! Show `position` without playing it, e.g. to time painting.
+    /*!
+     * Every seat is drawn in a bot colour; start() plays a new
+     * game as usual.
+     */
+    void showPosition(const Tron &position);
     
 protected:
     void resizeEvent(QResizeEvent *);
     void paintEvent(QPaintEvent *);
     void keyPressEvent(QKeyEvent *);
+    void wheelEvent(QWheelEvent *);
 
 private:
-    QTimer ticker{this};
-    std::unique_ptr<Tron> tron{nullptr};
+    //! Polls for new frames at display rate.
+    QTimer frameTimer{this};
+    //! Timings of the game in progress; outlives `runner`, which writes to it.
+    std::unique_ptr<TickProfiler> profiler;
+    //! The game in progress, simulated on its own thread.
+    std::unique_ptr<TronRunner> runner{nullptr};
+    //! Whether to draw the timings over the game.
+    bool showingStats{false};
+    //! When the last new frame was shown, or zero before the first.
+    TickProfiler::Clock::time_point lastFrame;
     int tileSize{DEFAULT_TILE_SIZE};
-    QSize mapSize{Tron::MAX_MAP_WIDTH, Tron::MAX_MAP_HEIGHT};
+    QSize mapSize{Tron::DEFAULT_MAP_WIDTH, Tron::DEFAULT_MAP_HEIGHT};
     int playerCount{Tron::MIN_PLAYER_COUNT};
+    //! Number of computer-controlled players after the humans.
+    int botCount{0};
+    //! Milliseconds per game tick.
+    int tickInterval{DEFAULT_TICK_INTERVAL};
+    //! Whether the game runs as fast as it can.
+    bool fastForward{false};
     std::vector<QString> playerNames{"Player One", "Player Two", "Player Three", "Player Four"};
     std::vector<QColor> playerColors{Qt::red, Qt::green, Qt::blue, Qt::yellow};
+    //! Colour of every seat in the current game, humans then bots.
+    std::vector<QColor> seatColors;
+    //! How to play over the network, if `networked`.
+    NetConfig network;
+    bool networked{false};
+    //! Server of the match being watched, if `watchedMatch` isn't 0.
+    NetAddress spectatorServer;
+    std::uint64_t watchedMatch{0};
     //! Keybindings of Qt::Key -> (playerIndex, direction)
     static std::map<int, std::pair<int, Player::Direction>> keybindings;
+    //! Draws the game, keeping a picture of the board at the current tile size.
+    /*!
+     * Each tick only adds one tile per player, so rather than
+     * repainting every trail we draw the new tiles into its
+     * image and blit that in paintEvent().
+     */
+    BoardPainter board;
+    //! Tile size chosen by zooming, or 0 to fit the whole map.
+    int zoomTileSize{0};
+    //! Player the viewport is centred on when not showing the whole map.
+    int followedPlayer{0};
 
+    //! Get the display name of seat `index` in the current game.
+    auto seatName(int index) const -> QString;
+    //! Forget what was drawn and start over with `runner`'s game.
+    void resetBoard();
     //! Adjust tile-size to maximize screen-usage.
     void resizeMap();
+    //! Check if the whole map is drawn at once from `board`.
+    /*!
+     * Otherwise only the part around `followedPlayer` is drawn.
+     */
+    auto showsWholeMap() const -> bool;
+    //! Redraw `board` from scratch.
+    void rebuildBoard();
+    //! Draw the map around `followedPlayer` directly to the widget.
+    void paintViewport(QPainter &painter);
+    //! Change zoom by `steps` tile sizes (negative to zoom out).
+    void zoom(int steps);
+    //! Centre the viewport on the next player still in play.
+    void followNextPlayer();
+    //! Draw the tiles newly occupied by the current frame into `board`.
+    void drawFrame();
+    //! Draw tick and frame timings in the top left corner.
+    void drawStats(QPainter &painter);
+    //! Ask where to and write a Chrome trace of recent timings.
+    void saveTrace();
 
 signals:
     //! Emitted when a game starts (true) or stops (false).
@@ -54,6 +142,8 @@ public slots:
 
     //! Set player count for next game.
     void setPlayerCount(int);
+    //! Set number of bots for next game.
+    void setBotCount(int);
     //! Set name to be used to display player.
     void setPlayerName(int, QString);
     //! Set color to be used to display player.
@@ -62,9 +152,13 @@ public slots:
     void setMapWidth(int);
     //! Set height of map in tiles.
     void setMapHeight(int);
+    //! Set milliseconds per tick, for this and later games.
+    void setTickInterval(int);
+    //! Set whether to run the game as fast as possible.
+    void setFastForward(bool);
 
-    //! Update game.
-    void step();
+    //! Show the newest frame of the game, if there is one.
+    void showFrame();
     
 };
 
@@ -0,0 +1,162 @@
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "udpchannel.h"
+
+#ifdef TRON_HAVE_SOCKETS
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+auto toSockaddr(NetAddress address) -> sockaddr_in
+{
+    sockaddr_in result{};
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = htonl(address.host);
+    result.sin_port = htons(address.port);
+    return result;
+}
+
+} // namespace
+
+auto NetAddress::parse(const std::string &text) -> NetAddress
+{
+    std::string::size_type colon = text.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::logic_error{"Bad address " + text + "."};
+    }
+    std::string host = text.substr(0, colon);
+    if (host == "localhost") {
+        host = "127.0.0.1";
+    }
+    char *end = nullptr;
+    long port = std::strtol(text.c_str() + colon + 1, &end, 10);
+    in_addr parsed;
+    if (*end != '\0' || port <= 0 || port > 65535
+            || ::inet_pton(AF_INET, host.c_str(), &parsed) != 1) {
+        throw std::logic_error{"Bad address " + text + "."};
+    }
+    return NetAddress{ntohl(parsed.s_addr), static_cast<std::uint16_t>(port)};
+}
+
+UdpChannel::UdpChannel(std::uint16_t port)
+{
+    descriptor = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (descriptor < 0) {
+        throw std::runtime_error{"Can't create UDP socket."};
+    }
+    sockaddr_in local = toSockaddr(NetAddress{INADDR_ANY, port});
+    if (::bind(descriptor, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0
+            || ::fcntl(descriptor, F_SETFL, ::fcntl(descriptor, F_GETFL) | O_NONBLOCK) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error{"Can't listen on UDP port " + std::to_string(port) + "."};
+    }
+}
+
+UdpChannel::~UdpChannel()
+{
+    ::close(descriptor);
+}
+
+auto UdpChannel::receive(NetAddress &from, std::vector<std::uint8_t> &datagram) -> bool
+{
+    flushDelayed();
+    datagram.resize(MAX_DATAGRAM_SIZE);
+    sockaddr_in sender{};
+    socklen_t senderSize = sizeof(sender);
+    ssize_t size = ::recvfrom(descriptor, datagram.data(), datagram.size(), 0,
+                              reinterpret_cast<sockaddr*>(&sender), &senderSize);
+    if (size < 0) {
+        // EAGAIN when nothing has arrived; other errors (e.g. a
+        // peer's port not open yet) are as good as a lost datagram
+        datagram.clear();
+        return false;
+    }
+    datagram.resize(static_cast<std::size_t>(size));
+    from = NetAddress{ntohl(sender.sin_addr.s_addr), ntohs(sender.sin_port)};
+    return true;
+}
+
+void UdpChannel::sendNow(NetAddress to, const std::uint8_t *data, std::size_t size)
+{
+    sockaddr_in address = toSockaddr(to);
+    // UDP promises nothing, so a failed send is just a lost datagram
+    ::sendto(descriptor, data, size, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+}
+
+#else
+
+auto NetAddress::parse(const std::string &text) -> NetAddress
+{
+    throw std::logic_error{"Can't use address " + text + ": no networking on this platform."};
+}
+
+UdpChannel::UdpChannel(std::uint16_t)
+{
+    throw std::runtime_error{"No networking on this platform."};
+}
+
+UdpChannel::~UdpChannel()
+{}
+
+auto UdpChannel::receive(NetAddress&, std::vector<std::uint8_t> &datagram) -> bool
+{
+    datagram.clear();
+    return false;
+}
+
+void UdpChannel::sendNow(NetAddress, const std::uint8_t*, std::size_t)
+{}
+
+#endif // TRON_HAVE_SOCKETS
+
+void UdpChannel::setConditions(const LinkConditions &conditions, std::uint32_t seed)
+{
+    this->conditions = conditions;
+    random.seed(seed);
+}
+
+void UdpChannel::send(NetAddress to, const std::uint8_t *data, std::size_t size)
+{
+    flushDelayed();
+    if (conditions.loss > 0.0
+            && std::uniform_real_distribution<double>{0.0, 1.0}(random) < conditions.loss) {
+        return;
+    }
+    Clock::duration delay = conditions.latency;
+    if (conditions.jitter.count() > 0) {
+        delay += std::chrono::milliseconds{
+                std::uniform_int_distribution<long>{0, conditions.jitter.count()}(random)};
+    }
+    if (delay == Clock::duration::zero()) {
+        sendNow(to, data, size);
+    } else {
+        delayed.push_back(Delayed{Clock::now() + delay, to,
+                                  std::vector<std::uint8_t>(data, data + size)});
+    }
+}
+
+void UdpChannel::flushDelayed()
+{
+    if (delayed.empty()) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    for (std::size_t i = 0; i < delayed.size();) {
+        if (delayed[i].due <= now) {
+            sendNow(delayed[i].to, delayed[i].data.data(), delayed[i].data.size());
+            std::swap(delayed[i], delayed.back());
+            delayed.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Constants
+const std::size_t UdpChannel::MAX_DATAGRAM_SIZE{1500};
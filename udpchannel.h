@@ -0,0 +1,106 @@
+#ifndef UDPCHANNEL_H
+#define UDPCHANNEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+//! Defined where games can be played and watched over the network.
+/*!
+ * Sockets are only implemented for POSIX; elsewhere the core still
+ * builds, but opening a UdpChannel or SpectatorLink throws.
+ */
+#define TRON_HAVE_SOCKETS
+#endif
+
+//! An IPv4 address and UDP port.
+struct NetAddress
+{
+    //! Address in host byte order.
+    std::uint32_t host;
+    std::uint16_t port;
+
+    //! Parse "host:port", where host is dotted IPv4 or "localhost".
+    /*!
+     * Throws if `text` isn't in that form.
+     */
+    static auto parse(const std::string &text) -> NetAddress;
+};
+
+inline auto operator==(NetAddress a, NetAddress b) -> bool
+{
+    return a.host == b.host && a.port == b.port;
+}
+
+inline auto operator!=(NetAddress a, NetAddress b) -> bool
+{
+    return !(a == b);
+}
+
+//! Made-up network trouble, for trying netcode on one machine.
+struct LinkConditions
+{
+    //! Delay added to every datagram sent.
+    std::chrono::milliseconds latency{0};
+    //! Up to this much more delay, picked at random per datagram.
+    std::chrono::milliseconds jitter{0};
+    //! Chance of dropping a datagram, from 0 to 1.
+    double loss{0.0};
+};
+
+//! A non-blocking UDP socket, optionally behind LinkConditions.
+/*!
+ * Delayed datagrams wait in a queue and go out from a later send()
+ * or receive() once due, so the owner just has to keep polling.
+ * With jitter they can overtake each other, as on a real network.
+ */
+class UdpChannel
+{
+public:
+    //! Listen on `port` of every local address.
+    explicit UdpChannel(std::uint16_t port);
+    ~UdpChannel();
+    UdpChannel(const UdpChannel&) = delete;
+    auto operator=(const UdpChannel&) -> UdpChannel& = delete;
+
+    //! Start simulating `conditions` for datagrams sent from now on.
+    void setConditions(const LinkConditions &conditions, std::uint32_t seed);
+    //! Send `size` bytes of `data` to `to`, or queue them if delayed.
+    void send(NetAddress to, const std::uint8_t *data, std::size_t size);
+    //! Take the next datagram that has arrived, if any.
+    /*!
+     * \return Whether `datagram` and `from` were filled in.
+     */
+    auto receive(NetAddress &from, std::vector<std::uint8_t> &datagram) -> bool;
+
+    //! Largest datagram received; longer ones are truncated.
+    static const std::size_t MAX_DATAGRAM_SIZE;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    //! A datagram held back by `conditions`.
+    struct Delayed
+    {
+        Clock::time_point due;
+        NetAddress to;
+        std::vector<std::uint8_t> data;
+    };
+
+    int descriptor{-1};
+    LinkConditions conditions;
+    std::mt19937 random;
+    //! Held-back datagrams, in no particular order.
+    std::vector<Delayed> delayed;
+
+    //! Send every held-back datagram that is due.
+    void flushDelayed();
+    //! Hand `size` bytes of `data` to the operating system.
+    void sendNow(NetAddress to, const std::uint8_t *data, std::size_t size);
+
+};
+
+#endif // UDPCHANNEL_H
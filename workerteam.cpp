@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "workerteam.h"
+
+WorkerTeam::WorkerTeam(int threadCount)
+    : threadCount(std::max(threadCount, 1))
+{
+    for (int i = 1; i < this->threadCount; ++i) {
+        threads.emplace_back(&WorkerTeam::work, this, i);
+    }
+}
+
+WorkerTeam::~WorkerTeam()
+{
+    stopping.store(true, std::memory_order_relaxed);
+    announce();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+auto WorkerTeam::getThreadCount() const -> int
+{
+    return threadCount;
+}
+
+void WorkerTeam::run(const std::function<void(int)> &job)
+{
+    this->job = &job;
+    pending.store(threadCount - 1, std::memory_order_relaxed);
+    announce();
+    job(0);
+    while (pending.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+/*!
+ * The last thread to arrive resets the count and lets the others
+ * go; the release of `barriers` publishes everything each thread
+ * wrote before arriving.
+ */
+void WorkerTeam::barrier()
+{
+    std::uint64_t passed = barriers.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == threadCount) {
+        arrived.store(0, std::memory_order_relaxed);
+        barriers.store(passed + 1, std::memory_order_release);
+        return;
+    }
+    while (barriers.load(std::memory_order_acquire) == passed) {
+        std::this_thread::yield();
+    }
+}
+
+/*!
+ * The generation is bumped under the mutex, so a thread about to
+ * sleep either sees it or is already waiting when notified.
+ */
+void WorkerTeam::announce()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_all();
+}
+
+void WorkerTeam::work(int index)
+{
+    std::uint64_t seen = 0;
+    for (;;) {
+        std::uint64_t current = generation.load(std::memory_order_acquire);
+        for (int spins = 0; current == seen && spins < SPIN_LIMIT; ++spins) {
+            std::this_thread::yield();
+            current = generation.load(std::memory_order_acquire);
+        }
+        if (current == seen) {
+            std::unique_lock<std::mutex> lock{mutex};
+            wake.wait(lock, [this, seen] {
+                return generation.load(std::memory_order_acquire) != seen;
+            });
+            current = generation.load(std::memory_order_acquire);
+        }
+        seen = current;
+        if (stopping.load(std::memory_order_relaxed)) {
+            return;
+        }
+        (*job)(index);
+        pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+// Constants
+// A few hundred microseconds; longer than a tick takes in fast-forward
+const int WorkerTeam::SPIN_LIMIT{2000};
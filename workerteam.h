@@ -0,0 +1,68 @@
+#ifndef WORKERTEAM_H
+#define WORKERTEAM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! Threads kept around to share small jobs that come often, like ticks.
+/*!
+ * run() hands one job to every thread of the team, the caller's
+ * included, and returns when all of them are done; inside a job,
+ * barrier() lines the threads up between phases. Idle threads spin
+ * for a while before going to sleep, so back-to-back runs (a game
+ * in fast-forward) start within microseconds, while a team between
+ * real-time ticks costs nothing.
+ */
+class WorkerTeam
+{
+public:
+    //! Start a team of `threadCount` threads, counting the caller's.
+    explicit WorkerTeam(int threadCount);
+    ~WorkerTeam();
+    WorkerTeam(const WorkerTeam&) = delete;
+    auto operator=(const WorkerTeam&) -> WorkerTeam& = delete;
+
+    //! Get the number of threads, counting the caller's.
+    auto getThreadCount() const -> int;
+    //! Run `job(worker)` on every thread; the caller is worker 0.
+    /*!
+     * Only one thread may call run() at a time.
+     */
+    void run(const std::function<void(int)> &job);
+    //! Wait for every thread of the current job to get here.
+    void barrier();
+
+private:
+    //! Times an idle thread checks for work before sleeping.
+    static const int SPIN_LIMIT;
+
+    const int threadCount;
+    std::vector<std::thread> threads;
+    //! The job being run; written before `generation` is released.
+    const std::function<void(int)> *job{nullptr};
+    //! Jobs started so far; a change means there is work.
+    std::atomic<std::uint64_t> generation{0};
+    //! Threads other than the caller yet to finish the job.
+    std::atomic<int> pending{0};
+    std::atomic<bool> stopping{false};
+    //! Threads that reached the current barrier.
+    std::atomic<int> arrived{0};
+    //! Barriers passed so far.
+    std::atomic<std::uint64_t> barriers{0};
+    //! Guards sleeping on `wake`; never held while working.
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    //! Body of worker `index`.
+    void work(int index);
+    //! Start a new generation, waking any sleeping threads.
+    void announce();
+
+};
+
+#endif // WORKERTEAM_H
@@ -0,0 +1,138 @@
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "workstealing.h"
+
+namespace {
+
+auto pack(std::uint32_t begin, std::uint32_t end) -> std::uint64_t
+{
+    return (std::uint64_t{begin} << 32) | end;
+}
+
+auto front(std::uint64_t bounds) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(bounds >> 32);
+}
+
+auto back(std::uint64_t bounds) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(bounds);
+}
+
+//! Keep each worker's range on its own cache line.
+struct PaddedRange
+{
+    TaskRange range;
+    char padding[64];
+};
+
+} // namespace
+
+TaskRange::TaskRange()
+    : bounds(0)
+{}
+
+void TaskRange::reset(std::uint32_t begin, std::uint32_t end)
+{
+    bounds.store(pack(begin, end), std::memory_order_relaxed);
+}
+
+auto TaskRange::pop(std::uint32_t &task) -> bool
+{
+    std::uint64_t current = bounds.load(std::memory_order_acquire);
+    while (front(current) < back(current)) {
+        std::uint64_t next = pack(front(current) + 1, back(current));
+        if (bounds.compare_exchange_weak(current, next,
+                                         std::memory_order_acq_rel)) {
+            task = front(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+auto TaskRange::stealFrom(TaskRange &victim) -> bool
+{
+    std::uint64_t current = victim.bounds.load(std::memory_order_acquire);
+    while (front(current) < back(current)) {
+        std::uint32_t count = back(current) - front(current);
+        // Leave the victim the front half (rounded down), so a
+        // single remaining task can still be stolen.
+        std::uint32_t middle = front(current) + count / 2;
+        if (victim.bounds.compare_exchange_weak(current,
+                                                pack(front(current), middle),
+                                                std::memory_order_acq_rel)) {
+            bounds.store(pack(middle, back(current)), std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+void runWorkStealing(std::uint32_t taskCount, int threadCount,
+                     const std::function<void(int, std::uint32_t)> &task)
+{
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    std::unique_ptr<PaddedRange[]> ranges{new PaddedRange[threadCount]};
+    for (int i = 0; i < threadCount; ++i) {
+        std::uint32_t begin = static_cast<std::uint64_t>(taskCount) * i / threadCount;
+        std::uint32_t end = static_cast<std::uint64_t>(taskCount) * (i + 1) / threadCount;
+        ranges[i].range.reset(begin, end);
+    }
+
+    // The first task to throw stops every worker, and is rethrown
+    // once they have all finished
+    std::atomic<bool> failed{false};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto work = [&](int worker) {
+        TaskRange &own = ranges[worker].range;
+        std::uint32_t index;
+        for (;;) {
+            while (!failed.load(std::memory_order_relaxed) && own.pop(index)) {
+                try {
+                    task(worker, index);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock{failureMutex};
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+            // Out of work; look for a victim, starting with
+            // our neighbour so thieves spread out.
+            bool stole = false;
+            for (int i = 1; i < threadCount && !stole; ++i) {
+                stole = own.stealFrom(ranges[(worker + i) % threadCount].range);
+            }
+            // Tasks are never added, so if nobody had anything
+            // left to steal we are done.
+            if (!stole) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef WORKSTEALING_H
+#define WORKSTEALING_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+//! A contiguous range of task indices owned by one worker.
+/*!
+ * The owner takes tasks from the front while idle workers steal
+ * the back half. Both ends live in a single atomic word, so every
+ * operation is one compare-and-swap and nothing ever blocks.
+ */
+class TaskRange
+{
+public:
+    TaskRange();
+
+    //! Replace the range with [`begin`, `end`). Not thread-safe.
+    void reset(std::uint32_t begin, std::uint32_t end);
+    //! Take the next task from the front (owner only).
+    auto pop(std::uint32_t &task) -> bool;
+    //! Move the back half of `victim` into this (empty) range.
+    auto stealFrom(TaskRange &victim) -> bool;
+
+private:
+    //! Front index in the high half, end index in the low half.
+    std::atomic<std::uint64_t> bounds;
+
+};
+
+//! Run `task(worker, index)` for every index in [0, `taskCount`).
+/*!
+ * Indices are dealt out evenly to `threadCount` workers up front;
+ * a worker that runs dry steals from the others, so a few long
+ * tasks don't leave the rest of the machine idle. Returns once
+ * every task has finished.
+ *
+ * If a task throws, workers stop taking new tasks, and once those
+ * already running have finished, the first exception thrown is
+ * rethrown here, on the calling thread.
+ */
+void runWorkStealing(std::uint32_t taskCount, int threadCount,
+                     const std::function<void(int, std::uint32_t)> &task);
+
+#endif // WORKSTEALING_H
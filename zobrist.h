@@ -0,0 +1,22 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+//! Get the Zobrist key of a board `feature`.
+/*!
+ * Rather than a table of random keys, which would take gigabytes
+ * for the largest maps, each key is derived on demand by running
+ * the feature's number through the SplitMix64 finalizer. Distinct
+ * features give keys that look independent, which is all Zobrist
+ * hashing needs.
+ */
+inline auto zobristKey(std::uint64_t feature) -> std::uint64_t
+{
+    std::uint64_t key = feature + 0x9e3779b97f4a7c15u;
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9u;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebu;
+    return key ^ (key >> 31);
+}
+
+#endif // ZOBRIST_H